@@ -57,6 +57,30 @@ if ("${CMAKE_CXX_COMPILER_ID}" MATCHES "MSVC")
     )
 endif ()
 
+if(OPTION_COMPACT_NODES)
+    set(DEFAULT_COMPILE_DEFINITIONS ${DEFAULT_COMPILE_DEFINITIONS}
+        USE_COMPACT_NODES
+    )
+endif()
+
+if(OPTION_64BIT_INDICES)
+    set(DEFAULT_COMPILE_DEFINITIONS ${DEFAULT_COMPILE_DEFINITIONS}
+        USE_64BIT_INDICES
+    )
+endif()
+
+if(OPTION_INPLACE_SORT)
+    set(DEFAULT_COMPILE_DEFINITIONS ${DEFAULT_COMPILE_DEFINITIONS}
+        USE_INPLACE_SORT
+    )
+endif()
+
+if(OPTION_LEGACY_VARIATES)
+    set(DEFAULT_COMPILE_DEFINITIONS ${DEFAULT_COMPILE_DEFINITIONS}
+        USE_LEGACY_VARIATES
+    )
+endif()
+
 
 #
 # Compile options
@@ -130,10 +154,21 @@ if ("${CMAKE_CXX_COMPILER_ID}" MATCHES "GNU" OR "${CMAKE_CXX_COMPILER_ID}" MATCH
 
     if(OPTION_USE_BMI2)
         set(DEFAULT_COMPILE_OPTIONS ${DEFAULT_COMPILE_OPTIONS}
-                -DUSE_BMI2
                 -mbmi2
                 )
     endif()
+
+    if(OPTION_USE_AVX2)
+        set(DEFAULT_COMPILE_OPTIONS ${DEFAULT_COMPILE_OPTIONS}
+                -mavx2
+                )
+    endif()
+
+    if(OPTION_USE_AVX512)
+        set(DEFAULT_COMPILE_OPTIONS ${DEFAULT_COMPILE_OPTIONS}
+                -mavx512f
+                )
+    endif()
 endif ()
 
 
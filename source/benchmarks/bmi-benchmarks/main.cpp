@@ -32,6 +32,8 @@ static void BM_deposit(benchmark::State& state) {
     BENCHMARK_TEMPLATE2(BM_deposit, X<5>, 5); \
 
 DEPOSIT_BENCHMARK(girgs::BitManipulationDetails::Generic::Implementation)
+DEPOSIT_BENCHMARK(girgs::BitManipulationDetails::LUT::Implementation)
+DEPOSIT_BENCHMARK(girgs::BitManipulation)
 
 // specialisations using fewer pdep at the cost of some more shifts
 #ifdef __BMI2__
@@ -91,6 +93,9 @@ ImplSpec(4, c[0], c[1], c[2], c[3]);
 ImplSpec(5, c[0], c[1], c[2], c[3], c[4]);
 
 DEPOSIT_BENCHMARK(SDeposit)
+#endif
+
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
 DEPOSIT_BENCHMARK(girgs::BitManipulationDetails::BMI2::Implementation)
 #endif
 
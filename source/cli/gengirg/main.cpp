@@ -4,14 +4,19 @@
 #include <map>
 #include <string>
 #include <cstring>
-#include <fstream>
 #include <algorithm>
+#include <memory>
+#include <stdexcept>
 
 #include <omp.h>
 
 #include <girgs/girgs-version.h>
 #include <girgs/Generator.h>
+#include <girgs/BinaryEdgeList.h>
+#include <girgs/CompressedGraph.h>
+#include <girgs/MappedPoints.h>
 #include <girgs/BitManipulation.h>
+#include <girgs/TypeIKernel.h>
 
 
 using namespace std;
@@ -56,7 +61,7 @@ int main(int argc, char* argv[]) {
     if (argc < 2 || 0 == strcmp(argv[1], "--help") || 0 == strcmp(argv[1], "-help")) {
         clog << "usage: ./gengirg\n"
             << "\t\t[-n anInt]          // number of nodes                          default 10000\n"
-            << "\t\t[-d anInt]          // dimension of geometry    range [1,5]     default 1\n"
+            << "\t\t[-d anInt]          // dimension of geometry    range [1,10]    default 1\n"
             << "\t\t[-ple aFloat]       // power law exponent       range (2,3]     default 2.5\n"
             << "\t\t[-alpha aFloat]     // model parameter          range (1,inf]   default infinity\n"
             << "\t\t[-deg aFloat]       // average degree           range [1,n)     default 10\n"
@@ -64,9 +69,16 @@ int main(int argc, char* argv[]) {
             << "\t\t[-pseed anInt]      // position seed                            default 130\n"
             << "\t\t[-sseed anInt]      // sampling seed                            default 1400\n"
             << "\t\t[-threads anInt]    // number of threads to use                 default 1\n"
+            << "\t\t[-morton aString]   // Generic, BMI2 or LUT morton codes        default fastest on this cpu\n"
+            << "\t\t[-kernel aString]   // Generic, AVX2 or AVX512 type 1 kernels   default widest on this cpu\n"
             << "\t\t[-file aString]     // file name for output (w/o ext)           default \"graph\"\n"
             << "\t\t[-dot 0|1]          // write result as dot (.dot)               default 0\n"
-            << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 0\n";
+            << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 0\n"
+            << "\t\t[-bin 0|1]          // write result as binary edgelist (.bin)   default 0\n"
+            << "\t\t[-adj 0|1]          // write compressed adjacency (.adj)        default 0\n"
+            << "\t\t[-pts 0|1]          // write weights and positions (.pts)       default 0\n"
+            << "\t\t[-input aString]    // map weights and positions from a .pts file instead of sampling them;\n"
+            << "\t\t                    // n and d are taken from the file, weights are only scaled if -deg is given\n";
         return 0;
     }
 
@@ -83,7 +95,7 @@ int main(int argc, char* argv[]) {
 
     // read params
     auto params = parseArgs(argc, argv);
-    auto n      = !params["n"    ].empty()  ? stoi(params["n"    ]) : 10000;
+    auto n      = !params["n"    ].empty()  ? static_cast<girgs::NodeIndex>(stoll(params["n"    ])) : 10000;
     auto d      = !params["d"    ].empty()  ? stoi(params["d"    ]) : 1;
     auto ple    = !params["ple"  ].empty()  ? stod(params["ple"  ]) : 2.5;
     auto alpha  = !params["alpha"].empty()  ? stod(params["alpha"]) : std::numeric_limits<double>::infinity();
@@ -95,11 +107,31 @@ int main(int argc, char* argv[]) {
     auto file   = !params["file" ].empty()  ? params["file"] : "graph";
     auto dot    = params["dot" ] == "1";
     auto edge   = params["edge"] == "1";
+    auto bin    = params["bin" ] == "1";
+    auto adj    = params["adj" ] == "1";
+    auto pts    = params["pts" ] == "1";
+    auto input  = params["input"];
+    auto morton = params["morton"];
+    auto kernel = params["kernel"];
+    auto scale  = input.empty() || !params["deg"].empty();
+
+    // the input file determines n and d; its pages are only read when the points are accessed
+    std::unique_ptr<girgs::MappedPoints> mapped;
+    if (!input.empty()) {
+        try {
+            mapped = std::make_unique<girgs::MappedPoints>(input);
+        } catch (const std::runtime_error& error) {
+            cerr << error.what() << '\n';
+            return 1;
+        }
+        n = static_cast<girgs::NodeIndex>(mapped->size());
+        d = static_cast<int>(mapped->dimension());
+    }
 
     // log params and range checks
     cout << "using:\n";
     logParam(n, "n");
-    rangeCheck(d, 1, 5, "d");
+    rangeCheck(d, 1, 10, "d");
     rangeCheck(ple, 2.0, 3.0, "ple", true, false);
     rangeCheck(alpha, 1.0, std::numeric_limits<double>::infinity(), "alpha", true);
     rangeCheck(deg, 1.0, n-1.0, "deg");
@@ -111,38 +143,97 @@ int main(int argc, char* argv[]) {
     logParam(file, "file");
     logParam(dot, "dot");
     logParam(edge, "edge");
+    logParam(bin, "bin");
+    logParam(adj, "adj");
+    logParam(pts, "pts");
+    if (mapped)
+        logParam(input, "input");
+    if (!morton.empty()) {
+        auto impl = girgs::MortonImplementation::Generic;
+        for (auto candidate : {girgs::MortonImplementation::BMI2, girgs::MortonImplementation::LUT})
+            if (morton == girgs::mortonImplementationName(candidate))
+                impl = candidate;
+        if (morton != girgs::mortonImplementationName(impl) || !girgs::mortonImplementationAvailable(impl)) {
+            cerr << "ERROR: morton implementation " << morton << " is unknown or not supported by this cpu\n";
+            return 1;
+        }
+        girgs::setMortonImplementation(impl);
+    }
     logParam(girgs::BitManipulation<1>::name(), "morton");
+    if (!kernel.empty()) {
+        auto impl = girgs::TypeIKernelImplementation::Generic;
+        for (auto candidate : {girgs::TypeIKernelImplementation::AVX2, girgs::TypeIKernelImplementation::AVX512})
+            if (kernel == girgs::typeIKernelName(candidate))
+                impl = candidate;
+        if (kernel != girgs::typeIKernelName(impl) || !girgs::typeIKernelAvailable(impl)) {
+            cerr << "ERROR: type 1 kernel " << kernel << " is unknown or not supported by this cpu\n";
+            return 1;
+        }
+        girgs::setTypeIKernel(impl);
+    }
+    logParam(girgs::typeIKernelName(girgs::typeIKernel()), "kernel");
     cout << "\n";
 
     auto t1 = high_resolution_clock::now();
 
 
-    cout << "generating weights ...\t\t" << flush;
-    auto weights = girgs::generateWeights(n, ple, wseed, threads > 1);
-    auto t2 = high_resolution_clock::now();
-    cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms\tlargest = ";
-    cout << *max_element(weights.begin(), weights.end()) << endl;
+    // the sampler reads weights and positions through views, either into the vectors below or into the mapped file
+    std::vector<double> weights;
+    auto positions = girgs::FlatPositions();
+    girgs::DoubleView weightView;
+    girgs::PositionView positionView;
 
+    if (!mapped) {
+        cout << "generating weights ...\t\t" << flush;
+        weights = girgs::generateWeights(n, ple, wseed, threads > 1);
+        auto t2 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms\tlargest = ";
+        cout << *max_element(weights.begin(), weights.end()) << endl;
 
-    cout << "generating positions ...\t" << flush;
-    auto positions = girgs::generatePositions(n, d, pseed);
-    auto t3 = high_resolution_clock::now();
-    cout << "done in " << duration_cast<milliseconds>(t3 - t2).count() << "ms" << endl;
+        cout << "generating positions ...\t" << flush;
+        positions = girgs::FlatPositions(n, d);
+        girgs::generatePositions(positions, pseed);
+        auto t3 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t3 - t2).count() << "ms" << endl;
 
+        weightView = weights;
+        positionView = positions;
+    } else {
+        weightView = mapped->weights();
+        positionView = mapped->positions();
+        if (scale) // scaling changes the weights, so they are copied
+            weights.assign(weightView.begin(), weightView.end());
+    }
 
-    cout << "find weight scaling ...\t\t" << flush;
-    auto scaling = girgs::scaleWeights(weights, deg, d, alpha);
-    auto t4 = high_resolution_clock::now();
-    cout << "done in " << duration_cast<milliseconds>(t4 - t3).count() << "ms\tscaling = " << scaling << endl;
+    if (scale) {
+        cout << "find weight scaling ...\t\t" << flush;
+        auto t3 = high_resolution_clock::now();
+        auto scaling = girgs::scaleWeights(weights, deg, d, alpha);
+        auto t4 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t4 - t3).count() << "ms\tscaling = " << scaling << endl;
+        weightView = weights;
+    }
 
     cout << "sampling edges ...\t\t" << flush;
-    auto edges = girgs::generateEdges(weights, positions, alpha, sseed);
+    auto t4 = high_resolution_clock::now();
+    auto edges = girgs::generateEdges(weightView, positionView, alpha, sseed);
     auto t5 = high_resolution_clock::now();
     cout << "done in " << duration_cast<milliseconds>(t5 - t4).count() << "ms\tavg deg = " << edges.size()*2.0/n << endl;
 
+    // .dot and .pts files are written from owned copies of mapped points
+    auto ownPoints = [&] {
+        if (weights.empty())
+            weights.assign(weightView.begin(), weightView.end());
+        if (positions.empty()) {
+            positions = girgs::FlatPositions(n, d, positionView.layout());
+            std::copy(positionView.data(), positionView.data() + static_cast<std::size_t>(n) * d, positions.data());
+        }
+    };
+
     if (dot) {
         cout << "writing .dot file ...\t\t" << flush;
         auto t6 = high_resolution_clock::now();
+        ownPoints();
         girgs::saveDot(weights, positions, edges, file+".dot");
         auto t7 = high_resolution_clock::now();
         cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
@@ -151,11 +242,40 @@ int main(int argc, char* argv[]) {
     if (edge) {
         cout << "writing edge list (.txt) ...\t" << flush;
         auto t6 = high_resolution_clock::now();
-        ofstream f{file+".txt"};
-        if(!f.is_open()) throw std::runtime_error{"Error: failed to open file \"" + file + ".txt\""};
-        f << n << ' ' << edges.size() << "\n\n";
-        for(auto& each : edges)
-            f << each.first << ' ' << each.second << '\n';
+        girgs::saveEdgeList(n, edges, file+".txt");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (bin) {
+        cout << "writing edge list (.bin) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        auto header = girgs::BinaryEdgeListHeader();
+        header.model = 0;
+        header.parameters = {{static_cast<double>(d), ple, alpha, deg}};
+        header.seeds = {{wseed, pseed, sseed, 0}};
+        girgs::saveBinary(header, n, edges, file+".bin");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (adj) {
+        cout << "writing adjacency (.adj) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        auto header = girgs::CompressedGraphHeader();
+        header.model = 0;
+        header.parameters = {{static_cast<double>(d), ple, alpha, deg}};
+        header.seeds = {{wseed, pseed, sseed, 0}};
+        girgs::saveCompressed(header, n, edges, girgs::mortonLabels(positionView), file+".adj");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (pts) {
+        cout << "writing points (.pts) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        ownPoints();
+        girgs::savePoints(weights, positions, file+".pts");
         auto t7 = high_resolution_clock::now();
         cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
     }
@@ -4,13 +4,17 @@
 #include <map>
 #include <string>
 #include <cstring>
-#include <fstream>
-#include <iomanip>
+#include <memory>
+#include <stdexcept>
 
 #include <omp.h>
 
 #include <girgs/girgs-version.h>
 #include <hypergirgs/Generator.h>
+#include <hypergirgs/BinaryEdgeList.h>
+#include <hypergirgs/CompressedGraph.h>
+#include <hypergirgs/MappedPoints.h>
+#include <hypergirgs/TypeIKernel.h>
 
 
 using namespace std;
@@ -65,7 +69,13 @@ int main(int argc, char* argv[]) {
             << "\t\t[-nkr 0|1]          // use NetworKit R estimation               default 0\n"
             << "\t\t[-file aString]     // file name for output (w/o ext)           default \"graph\"\n"
             << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 0\n"
-            << "\t\t[-coord 0|1]        // write hyp. coordinates (.hyp)            default 0\n";
+            << "\t\t[-bin 0|1]          // write result as binary edgelist (.bin)   default 0\n"
+            << "\t\t[-adj 0|1]          // write compressed adjacency (.adj)        default 0\n"
+            << "\t\t[-coord 0|1]        // write hyp. coordinates (.hyp)            default 0\n"
+            << "\t\t[-pts 0|1]          // write radii, angles, and R (.pts)        default 0\n"
+            << "\t\t[-input aString]    // map radii and angles from a .pts file instead of sampling them;\n"
+            << "\t\t                    // n and R are taken from the file\n"
+            << "\t\t[-kernel aString]   // Generic, AVX2 or AVX512 type 1 kernels   default widest on this cpu\n";
         return 0;
     }
 
@@ -82,7 +92,7 @@ int main(int argc, char* argv[]) {
 
     // read params
     auto params = parseArgs(argc, argv);
-    auto n      = !params["n"    ].empty()  ? stoi(params["n"    ]) : 10000;
+    auto n      = !params["n"    ].empty()  ? static_cast<hypergirgs::NodeIndex>(stoll(params["n"    ])) : 10000;
     auto alpha  = !params["alpha"].empty()  ? stod(params["alpha"]) : 0.75;
     auto T      = !params["t"    ].empty()  ? stod(params["t"    ]) : 0;
     auto deg    = !params["deg"  ].empty()  ? stod(params["deg"  ]) : 10.0;
@@ -93,7 +103,24 @@ int main(int argc, char* argv[]) {
     auto nkr    = params["nkr"  ] == "1";
     auto file   = !params["file" ].empty()  ? params["file"] : "graph";
     auto edge   = params["edge" ] == "1";
+    auto bin    = params["bin"  ] == "1";
+    auto adj    = params["adj"  ] == "1";
     auto coord  = params["coord"] == "1";
+    auto pts    = params["pts"  ] == "1";
+    auto input  = params["input"];
+    auto kernel = params["kernel"];
+
+    // the input file determines n and R; its pages are only read when the points are accessed
+    std::unique_ptr<hypergirgs::MappedPoints> mapped;
+    if (!input.empty()) {
+        try {
+            mapped = std::make_unique<hypergirgs::MappedPoints>(input);
+        } catch (const std::runtime_error& error) {
+            cerr << error.what() << '\n';
+            return 1;
+        }
+        n = static_cast<hypergirgs::NodeIndex>(mapped->size());
+    }
 
     // log params and range checks
     cout << "using:\n";
@@ -109,39 +136,92 @@ int main(int argc, char* argv[]) {
     logParam(nkr, "nkr");
     logParam(file, "file");
     logParam(edge, "edge");
+    logParam(bin, "bin");
+    logParam(adj, "adj");
     logParam(coord, "coord");
+    logParam(pts, "pts");
+    if (mapped)
+        logParam(input, "input");
+    if (!kernel.empty()) {
+        auto impl = hypergirgs::TypeIKernelImplementation::Generic;
+        for (auto candidate : {hypergirgs::TypeIKernelImplementation::AVX2, hypergirgs::TypeIKernelImplementation::AVX512})
+            if (kernel == hypergirgs::typeIKernelName(candidate))
+                impl = candidate;
+        if (kernel != hypergirgs::typeIKernelName(impl) || !hypergirgs::typeIKernelAvailable(impl)) {
+            cerr << "ERROR: type 1 kernel " << kernel << " is unknown or not supported by this cpu\n";
+            return 1;
+        }
+        hypergirgs::setTypeIKernel(impl);
+    }
+    logParam(hypergirgs::typeIKernelName(hypergirgs::typeIKernel()), "kernel");
     cout << "\n";
 
-    cout << "estimate R ...\t\t" << flush;
-    auto R = nkr ?
-            hypergirgs::calculateRadiusLikeNetworKit(n, alpha, T, deg) :
-            hypergirgs::calculateRadius(n, alpha, T, deg);
-    cout << "R = " << R << endl;
-
-    auto t1 = high_resolution_clock::now();
-    cout << "generating radii ...\t" << flush;
-    auto radii = hypergirgs::sampleRadii(n, alpha, R, rseed, threads > 1);
-    auto t2 = high_resolution_clock::now();
-    cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms" << endl;
-
-    cout << "generating angles ...\t" << flush;
-    auto angles = hypergirgs::sampleAngles(n, aseed, threads > 1);
+    // the sampler reads radii and angles through views, either into the vectors below or into the mapped file
+    std::vector<double> radii, angles;
+    hypergirgs::DoubleView radiusView, angleView;
+    double R;
     auto t3 = high_resolution_clock::now();
-    cout << "done in " << duration_cast<milliseconds>(t3 - t2).count() << "ms" << endl;
+
+    if (!mapped) {
+        cout << "estimate R ...\t\t" << flush;
+        R = nkr ?
+                hypergirgs::calculateRadiusLikeNetworKit(n, alpha, T, deg) :
+                hypergirgs::calculateRadius(n, alpha, T, deg);
+        cout << "R = " << R << endl;
+
+        auto t1 = high_resolution_clock::now();
+        cout << "generating radii ...\t" << flush;
+        radii = hypergirgs::sampleRadii(n, alpha, R, rseed, threads > 1);
+        auto t2 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms" << endl;
+
+        cout << "generating angles ...\t" << flush;
+        angles = hypergirgs::sampleAngles(n, aseed, threads > 1);
+        t3 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t3 - t2).count() << "ms" << endl;
+
+        radiusView = radii;
+        angleView = angles;
+    } else {
+        R = mapped->radius();
+        cout << "R from input\t\tR = " << R << endl;
+        radiusView = mapped->radii();
+        angleView = mapped->angles();
+    }
 
     cout << "sampling edges ...\t" << flush;
-    auto edges = hypergirgs::generateEdges(radii, angles, T, R, sseed);
+    auto edges = hypergirgs::generateEdges(radiusView, angleView, T, R, sseed);
     auto t5 = high_resolution_clock::now();
     cout << "done in " << duration_cast<milliseconds>(t5 - t3).count() << "ms\tavg deg = " << edges.size()*2.0/n << endl;
 
     if (edge) {
         cout << "writing edge list (.txt) ...\t" << flush;
         auto t6 = high_resolution_clock::now();
-        ofstream f{file+".txt"};
-        if(!f.is_open()) throw std::runtime_error{"Error: failed to open file \"" + file + ".txt\""};
-        f << n << ' ' << edges.size() << "\n\n";
-        for(auto& each : edges)
-            f << each.first << ' ' << each.second << '\n';
+        hypergirgs::saveEdgeList(n, edges, file+".txt");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (bin) {
+        cout << "writing edge list (.bin) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        auto header = hypergirgs::BinaryEdgeListHeader();
+        header.model = 1;
+        header.parameters = {{alpha, T, deg, R}};
+        header.seeds = {{rseed, aseed, sseed, 0}};
+        hypergirgs::saveBinary(header, n, edges, file+".bin");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (adj) {
+        cout << "writing adjacency (.adj) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        auto header = hypergirgs::CompressedGraphHeader();
+        header.model = 1;
+        header.parameters = {{alpha, T, deg, R}};
+        header.seeds = {{rseed, aseed, sseed, 0}};
+        hypergirgs::saveCompressed(header, n, edges, hypergirgs::angularLabels(angleView), file+".adj");
         auto t7 = high_resolution_clock::now();
         cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
     }
@@ -149,11 +229,19 @@ int main(int argc, char* argv[]) {
     if (coord) {
         cout << "writing coordinates (.hyp) ...\t" << flush;
         auto t6 = high_resolution_clock::now();
-        ofstream f{file+".hyp"};
-        if(!f.is_open()) throw std::runtime_error{"Error: failed to open file \"" + file + ".hyp\""};
-        f << std::fixed << std::setprecision(std::numeric_limits<double>::max_digits10);
-        for(auto i{0u}; i<n; ++i)
-            f << radii[i]  << ' ' << angles[i] << '\n';
+        hypergirgs::saveCoordinates(radiusView, angleView, file+".hyp");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
+    if (pts) {
+        cout << "writing points (.pts) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        if (mapped) {
+            radii.assign(radiusView.begin(), radiusView.end());
+            angles.assign(angleView.begin(), angleView.end());
+        }
+        hypergirgs::savePoints(radii, angles, R, file+".pts");
         auto t7 = high_resolution_clock::now();
         cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
     }
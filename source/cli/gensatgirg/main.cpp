@@ -4,13 +4,13 @@
 #include <map>
 #include <string>
 #include <cstring>
-#include <fstream>
 #include <algorithm>
 
 #include <omp.h>
 
 #include <girgs/girgs-version.h>
 #include <satgirgs/Generator.h>
+#include <satgirgs/BinaryEdgeList.h>
 
 
 using namespace std;
@@ -64,6 +64,7 @@ int main(int argc, char* argv[]) {
             << "\t\t[-file aString]     // file name for output (w/o ext)           default \"graph\"\n"
             << "\t\t[-dot 0|1]          // write result as dot (.dot)               default 0\n"
             << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 0\n"
+            << "\t\t[-bin 0|1]          // write result as binary edgelist (.bin)   default 0\n"
             << "\t\t[-debug 0|1]         // output debug graph                      default 0\n";
         return 0;
     }
@@ -91,6 +92,7 @@ int main(int argc, char* argv[]) {
     auto file   = !params["file" ].empty()  ? params["file"] : "graph";
     auto dot    = params["dot" ] == "1";
     auto edge   = params["edge"] == "1";
+    auto bin    = params["bin" ] == "1";
     auto debug  = params["debug"] == "1";
 
     // log params and range checks
@@ -106,6 +108,7 @@ int main(int argc, char* argv[]) {
     logParam(file, "file");
     logParam(dot, "dot");
     logParam(edge, "edge");
+    logParam(bin, "bin");
     logParam(debug, "debugMode");
     cout << "\n";
 
@@ -165,12 +168,19 @@ int main(int argc, char* argv[]) {
     if (edge) {
         cout << "writing edge list (.txt) ...\t" << flush;
         auto t7 = high_resolution_clock::now();
-        ofstream f{file+".txt"};
-        if(!f.is_open()) throw std::runtime_error{"Error: failed to open file \"" + file + ".txt\""};
-        f << n << ' ' << dedup_edges.size() << "\n\n";
-        int u, v, w;
-        for(const auto& [u, v, w] : dedup_edges)
-            f << u << ' ' << v << ' ' << w << '\n';
+        satgirgs::saveEdgeList(n, dedup_edges, file+".txt");
+        auto t8 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t8 - t7).count() << "ms" << endl;
+    }
+
+    if (bin) {
+        cout << "writing edge list (.bin) ...\t" << flush;
+        auto t7 = high_resolution_clock::now();
+        auto header = satgirgs::BinaryEdgeListHeader();
+        header.model = 2;
+        header.parameters = {{ple, static_cast<double>(m), 0.0, 0.0}};
+        header.seeds = {{wseed, ncseed, cseed, 0}};
+        satgirgs::saveBinary(header, n, dedup_edges, file+".bin");
         auto t8 = high_resolution_clock::now();
         cout << "done in " << duration_cast<milliseconds>(t8 - t7).count() << "ms" << endl;
     }
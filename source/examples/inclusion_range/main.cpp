@@ -14,7 +14,7 @@
 
 
 using namespace std;
-using Graph = vector<pair<int,int>>;
+using Graph = vector<girgs::Edge>;
 
 
 void unifyEdges(Graph& g) {
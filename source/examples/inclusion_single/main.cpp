@@ -15,7 +15,7 @@
 
 using namespace std;
 
-using Graph = vector<pair<int,int>>;
+using Graph = vector<girgs::Edge>;
 
 
 void createReverseEdges(Graph& g) {
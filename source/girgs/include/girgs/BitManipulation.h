@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <string>
+
+#include <girgs/girgs_api.h>
 
 namespace girgs {
 
@@ -16,19 +20,93 @@ struct BitPattern {
 };
 }
 
-// Load implementations
+// Load implementations; BMI2 is compiled on x86-64 with gcc or clang and only used if the cpu supports it
+// (32 bit x86 lacks the 64 bit PDEP/PEXT intrinsics)
 #include <girgs/BitManipulationGeneric.inl>
+#include <girgs/BitManipulationLUT.inl>
 
-#ifdef USE_BMI2
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define GIRGS_HAS_BMI2_IMPLEMENTATION
     #include <girgs/BitManipulationBMI2.inl>
 #endif
 
 namespace girgs {
-#ifdef USE_BMI2
-    template <unsigned D>
-    using BitManipulation = BitManipulationDetails::BMI2::Implementation<D>;
-#else
-    template <unsigned D>
-    using BitManipulation = BitManipulationDetails::Generic::Implementation<D>;
+
+/// The implementations of Morton encoding (deposit) and decoding (extract) BitManipulation chooses from.
+enum class MortonImplementation : int {
+    Generic,    ///< shifts and masks, see BitManipulationDetails::Generic
+    BMI2,       ///< PDEP/PEXT instructions, fast on Intel and AMD Zen 3 and later, microcoded (slow) on older AMD cpus
+    LUT         ///< byte wise lookup tables, see BitManipulationDetails::LUT
+};
+
+namespace BitManipulationDetails {
+/// the implementation used by BitManipulation, set to calibrateMortonImplementation() when the library is loaded
+GIRGS_API extern MortonImplementation g_selected;
+}
+
+/// @return whether impl can run on this cpu (BMI2 needs the instruction set)
+GIRGS_API bool mortonImplementationAvailable(MortonImplementation impl) noexcept;
+
+/**
+ * @brief
+ *  Times all available implementations on a few thousand random 2D and 3D cells (in the style of bmi-benchmarks)
+ *  and returns the fastest. Takes well below a millisecond.
+ *  All implementations compute the same codes, so the choice only affects the running time.
+ */
+GIRGS_API MortonImplementation calibrateMortonImplementation();
+
+/// @return the implementation used by BitManipulation
+inline MortonImplementation mortonImplementation() noexcept {
+    return BitManipulationDetails::g_selected;
+}
+
+/**
+ * @brief
+ *  Overrides the calibrated implementation, e.g. for benchmarks.
+ *  Must not be called while graphs are generated.
+ *
+ * @throw std::invalid_argument if impl is not available on this cpu
+ */
+GIRGS_API void setMortonImplementation(MortonImplementation impl);
+
+/// @return the name of impl ("Generic", "BMI2" or "LUT")
+GIRGS_API std::string mortonImplementationName(MortonImplementation impl);
+
+
+/**
+ * @brief
+ *  Morton encoding (deposit) and decoding (extract) of D coordinates into cells of type CellId,
+ *  either uint32_t or uint64_t.
+ *  Forwards to the implementation chosen at runtime (see mortonImplementation()), so a single binary
+ *  uses PDEP where it is fast and avoids it where it is microcoded.
+ */
+template <unsigned D, typename CellId = uint32_t>
+struct BitManipulation {
+    static constexpr unsigned kDimensions = D;
+
+    static CellId deposit(const std::array<CellId, D>& coords) noexcept {
+        switch (mortonImplementation()) {
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
+            case MortonImplementation::BMI2: return BitManipulationDetails::BMI2::Implementation<D, CellId>::deposit(coords);
+#endif
+            case MortonImplementation::LUT:  return BitManipulationDetails::LUT::Implementation<D, CellId>::deposit(coords);
+            default:                         return BitManipulationDetails::Generic::Implementation<D, CellId>::deposit(coords);
+        }
+    }
+
+    static std::array<CellId, kDimensions> extract(CellId cell) noexcept {
+        switch (mortonImplementation()) {
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
+            case MortonImplementation::BMI2: return BitManipulationDetails::BMI2::Implementation<D, CellId>::extract(cell);
 #endif
+            case MortonImplementation::LUT:  return BitManipulationDetails::LUT::Implementation<D, CellId>::extract(cell);
+            default:                         return BitManipulationDetails::Generic::Implementation<D, CellId>::extract(cell);
+        }
+    }
+
+    static std::string name() {
+        return mortonImplementationName(mortonImplementation());
+    }
+};
+
 }
@@ -2,10 +2,9 @@
 #include <array>
 #include <cassert>
 #include <cstdint>
-
-#ifdef USE_BMI2
-#include <immintrin.h>
-#endif    
+#include <string>
+#include <type_traits>
+#include <utility>
 
 
 namespace girgs {
@@ -200,8 +199,68 @@ struct Deposit<4> {
     }
 };
 
-template <unsigned D>
+/**
+ * Software PEXT/PDEP for 64 bit words and a fixed mask (Hacker's Delight, compress and expand).
+ * The bits selected by Mask move in log2(64) = 6 rounds of shifts; the bits moved per round
+ * only depend on Mask and are computed at compile time.
+ */
+template <uint64_t Mask>
+struct MaskedBits64 {
+    static constexpr unsigned kRounds = 6;
+
+    static constexpr std::array<uint64_t, kRounds> compile_moves() {
+        std::array<uint64_t, kRounds> moves {};
+        uint64_t mask = Mask;
+        uint64_t zeros_right = ~mask << 1; // marks bits with a zero somewhere to their right
+        for (unsigned i = 0; i < kRounds; ++i) {
+            // parallel suffix: bits with an odd number of zeros_right at or below them
+            auto suffix = zeros_right ^ (zeros_right << 1);
+            for (unsigned s = 2; s < 64; s *= 2)
+                suffix ^= suffix << s;
+            const auto move = suffix & mask;
+            moves[i] = move;
+            mask = (mask ^ move) | (move >> (1u << i));
+            zeros_right &= ~suffix;
+        }
+        return moves;
+    }
+
+    static constexpr std::array<uint64_t, kRounds> kMoves = compile_moves();
+
+    /// moves the bits of x selected by Mask to the lowest bits (like PEXT)
+    static constexpr uint64_t compress(uint64_t x) {
+        x &= Mask;
+        for (unsigned i = 0; i < kRounds; ++i) {
+            const auto t = x & kMoves[i];
+            x = (x ^ t) | (t >> (1u << i));
+        }
+        return x;
+    }
+
+    /// moves the lowest bits of x to the bits selected by Mask (like PDEP)
+    static constexpr uint64_t expand(uint64_t x) {
+        for (unsigned i = kRounds; i-- > 0;) {
+            const auto t = x << (1u << i);
+            x = (x & ~kMoves[i]) | (t & kMoves[i]);
+        }
+        return x & Mask;
+    }
+};
+
+static_assert(MaskedBits64<0x5555555555555555>::compress(0x5555555555555555) == 0xffffffff, "Unittest failed");
+static_assert(MaskedBits64<0x5555555555555555>::compress(0xaaaaaaaaaaaaaaaa) == 0, "Unittest failed");
+static_assert(MaskedBits64<0x5555555555555555>::expand(0xffffffff) == 0x5555555555555555, "Unittest failed");
+static_assert(MaskedBits64<0x8040201008040201>::compress(0x8000000000000201) == 0x83, "Unittest failed");
+static_assert(MaskedBits64<0x8040201008040201>::expand(0x83) == 0x8000000000000201, "Unittest failed");
+
+/**
+ * Implementation of deposit/extract for 32 bit cells (primary template) and 64 bit cells (specialisation below).
+ * A coordinate has the same type as the cell.
+ */
+template <unsigned D, typename T = uint32_t>
 struct Implementation {
+    static_assert(std::is_same<T, uint32_t>::value, "Cells are either 32 or 64 bit unsigned integers");
+
     static constexpr unsigned kDimensions = D;
 
     static uint32_t deposit(const std::array<uint32_t, D>& coords) {
@@ -217,6 +276,36 @@ struct Implementation {
     }
 };
 
+template <unsigned D>
+struct Implementation<D, uint64_t> {
+    static constexpr unsigned kDimensions = D;
+
+    static uint64_t deposit(const std::array<uint64_t, D>& coords) {
+        return deposit(coords, std::make_index_sequence<D>());
+    }
+
+    static std::array<uint64_t, kDimensions> extract(uint64_t cell) {
+        return extract(cell, std::make_index_sequence<D>());
+    }
+
+    static std::string name() {
+        return "Generic";
+    }
+
+private:
+    static constexpr auto kMask = BitPattern<D, uint64_t>::kEveryDthBit;
+
+    template <std::size_t... Ds>
+    static uint64_t deposit(const std::array<uint64_t, D>& coords, std::index_sequence<Ds...>) {
+        return (MaskedBits64<(kMask << Ds)>::expand(coords[Ds]) | ...);
+    }
+
+    template <std::size_t... Ds>
+    static std::array<uint64_t, kDimensions> extract(uint64_t cell, std::index_sequence<Ds...>) {
+        return {{MaskedBits64<(kMask << Ds)>::compress(cell)...}};
+    }
+};
+
 } // namespace Generic
 } // namespace BitManipulationDetails
 } // namespace girgs
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <girgs/Index.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Undirected graph in compressed sparse row format (adjacency array).
+ *  Every edge {u,v} is stored twice, once in the neighbourhood of u and once in the neighbourhood of v.
+ *  Each neighbourhood is sorted in ascending order.
+ */
+struct CSRGraph {
+    std::vector<std::size_t> offsets;   ///< neighbours of node v are neighbours[offsets[v] .. offsets[v+1]), size n+1
+    std::vector<NodeIndex> neighbours;  ///< concatenated neighbourhoods of all nodes, size 2m
+
+    std::size_t numNodes() const noexcept { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::size_t numEdges() const noexcept { return neighbours.size() / 2; }
+    std::size_t degree(NodeIndex v) const noexcept { return offsets[v+1] - offsets[v]; }
+
+    const NodeIndex* neighboursBegin(NodeIndex v) const noexcept { return neighbours.data() + offsets[v]; }
+    const NodeIndex* neighboursEnd(NodeIndex v) const noexcept { return neighbours.data() + offsets[v+1]; }
+};
+
+
+} // namespace girgs
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <girgs/Index.h>
+#include <girgs/Philox.h>
+#include <girgs/SpatialTreeCoordinateHelper.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Dynamic variant of the SpatialTree: a GIRG that supports inserting and erasing single nodes.
+ *
+ *  Instead of the sorted node array and the prefix sums over cells, every weight layer keeps a mutable bucket
+ *  per cell on each level that is relevant for it. Inserting a node samples only its incident edges:
+ *  for every weight layer j, the nodes in the cells touching the cell of the new node on the partitioning base level
+ *  of the layer pair are checked individually (type 1), and the nodes in the non-touching children of touching cells
+ *  on the levels above are sampled by geometric jumps (type 2), as in SpatialTree.
+ *  Erasing a node removes its incident edges in time linear in its degree.
+ *  The expected cost of an insertion is linear in the number of sampled edges plus the number of
+ *  weight layers times the number of levels (i.e. \f$ O(\log^2 n) \f$ for power law weights).
+ *
+ *  The edge probabilities are normalised by a fixed total weight W given at construction, so that
+ *  updates do not change the probabilities of existing pairs. For the same nodes and W = sum of their weights,
+ *  the graph has the distribution of generateEdges(); in the threshold model (alpha = infinity) it is the same graph.
+ *
+ *  Each pair of nodes is sampled once, by the insertion of the later node. The random numbers of an insertion
+ *  come from a counter-based stream keyed by the seed and the number of previous insertions,
+ *  so the same sequence of updates yields the same graph.
+ *
+ * @tparam D
+ *  Dimension of the underlying geometry.
+ */
+template<unsigned int D>
+class DynamicSpatialTree
+{
+    using CoordinateHelper = SpatialTreeCoordinateHelper<D>;
+
+public:
+    /**
+     * @brief
+     *  Creates an empty graph.
+     *
+     * @param alpha
+     *  Edge probability parameter. Infinity results in the threshold model.
+     * @param totalWeight
+     *  The constant W in the edge probabilities, e.g. the expected sum of all weights.
+     * @param minWeight
+     *  Lower bound for the weights of all nodes that will be inserted; determines the weight layers.
+     * @param seed
+     *  Seed for the edge sampling. A negative seed draws a random one.
+     */
+    DynamicSpatialTree(double alpha, double totalWeight, double minWeight, int seed);
+
+    /**
+     * @brief
+     *  Inserts a node and samples the edges to all nodes in the graph.
+     *
+     * @param position
+     *  Position on the torus \f$[0,1)^D\f$.
+     * @param weight
+     *  Weight of at least minWeight.
+     *
+     * @return
+     *  The id of the new node. Ids of erased nodes are reused.
+     */
+    NodeIndex insert(const std::array<double, D>& position, double weight);
+
+    /**
+     * @brief
+     *  Removes a node and all its edges.
+     *
+     * @throw std::invalid_argument if node is not in the graph, e.g. because it has been erased before
+     */
+    void erase(NodeIndex node);
+
+    /// whether node is the id of a node in the graph
+    bool contains(NodeIndex node) const noexcept {
+        return 0 <= node && node < idBound() && m_nodes[node].alive;
+    }
+
+    std::size_t numNodes() const noexcept { return m_num_nodes; }
+    std::size_t numEdges() const noexcept { return m_num_edges; }
+
+    /// all ids of nodes in the graph are less than this bound
+    NodeIndex idBound() const noexcept { return static_cast<NodeIndex>(m_nodes.size()); }
+
+    double weight(NodeIndex node) const noexcept { return m_nodes[node].weight; }
+    const std::array<double, D>& position(NodeIndex node) const noexcept { return m_nodes[node].position; }
+    std::size_t degree(NodeIndex node) const noexcept { return m_nodes[node].neighbours.size(); }
+
+    /// calls callback(v) for every neighbour v of node
+    template<typename Callback>
+    void forEachNeighbour(NodeIndex node, Callback&& callback) const {
+        for (auto& neighbour : m_nodes[node].neighbours)
+            callback(neighbour.node);
+    }
+
+    /// an edge list of the current graph with u < v for every edge (u,v)
+    std::vector<std::pair<NodeIndex, NodeIndex>> edges() const;
+
+protected:
+    using Cell = std::array<uint32_t, D>;   ///< coordinates of a cell within its level
+
+    /// entry of an adjacency list; reverse is the position of the opposite entry in the adjacency list of node
+    struct Neighbour {
+        NodeIndex node;
+        std::size_t reverse;
+    };
+
+    struct NodeData {
+        std::array<double, D> position;
+        double weight;
+        unsigned int layer;
+        bool alive;
+        std::vector<std::size_t> slots;      ///< slots[level] is the position of the node in its bucket on that level
+        std::vector<Neighbour> neighbours;
+    };
+
+    /// nodes of one weight layer, bucketed by cell on the levels 0 to maxLevel
+    struct Layer {
+        unsigned int maxLevel = 0;
+        std::size_t size = 0;
+        std::vector<std::vector<std::vector<NodeIndex>>> buckets; ///< buckets[level][cell] with cells in Morton order
+    };
+
+    /// weight layer of a weight; layer i holds the weights in \f$ [2^i w_0, 2^{i+1} w_0) \f$
+    unsigned int layerOf(double weight) const;
+
+    /// same as SpatialTree::partitioningBaseLevel(), but at most #m_max_level
+    unsigned int partitioningBaseLevel(unsigned int layer1, unsigned int layer2) const;
+
+    /// calls callback(cellB) for each cell of level that touches cell (including cell itself) once
+    template<typename Callback>
+    static void forEachTouchingCell(const Cell& cell, unsigned int level, Callback&& callback);
+
+    /// torus distance of two cells of level in cells and maximum norm; cells with distance at most 1 touch
+    static unsigned int cellDistance(const Cell& cellA, const Cell& cellB, unsigned int level);
+
+    /// samples the edges of the new node v to the nodes of layer j
+    void sampleLayer(NodeIndex v, unsigned int j, PhiloxStream& gen);
+
+    /// samples the edges of v to every node of bucket individually (type 1)
+    void sampleAll(NodeIndex v, const std::vector<NodeIndex>& bucket, PhiloxStream& gen);
+
+    /**
+     * @brief
+     *  Samples the edges of v to the nodes of several buckets which have at most connection probability maxProb (type 2).
+     *  The buckets are traversed as one sequence, so the geometric jumps cost one random number per candidate
+     *  and bucket set instead of one per bucket.
+     */
+    void sampleJumps(NodeIndex v, const std::vector<const std::vector<NodeIndex>*>& buckets, double maxProb, PhiloxStream& gen);
+
+    /// torus distance in maximum norm
+    double distance(NodeIndex u, NodeIndex v) const;
+
+    void addEdge(NodeIndex u, NodeIndex v);
+
+    /// removes entry index of the adjacency list of u (but not the opposite entry)
+    void removeNeighbour(NodeIndex u, std::size_t index);
+
+private:
+    double m_alpha;             ///< girg model parameter
+    double m_W;                 ///< fixed total weight
+    double m_w0;                ///< lower bound for all weights
+    uint32_t m_seed;            ///< key of the random streams
+    int    m_baseLevelConstant; ///< \f$\log_2(W/w_0^2)\f$ see partitioningBaseLevel()
+    unsigned int m_max_level;   ///< deepest level with cell ids that fit 32 bits
+
+    std::vector<NodeData> m_nodes;  ///< indexed by node id
+    std::vector<NodeIndex> m_free;  ///< ids of erased nodes that are reused
+    std::vector<Layer> m_layers;    ///< created up to the largest layer of an inserted weight
+    std::array<std::vector<const std::vector<NodeIndex>*>, 2> m_candidates; ///< type 2 buckets of one level at cell distance 2 and 3
+
+    uint64_t m_insertions = 0;      ///< number of insertions so far, selects the random stream of an insertion
+    std::size_t m_num_nodes = 0;
+    std::size_t m_num_edges = 0;
+};
+
+
+} // namespace girgs
+
+#include <girgs/DynamicSpatialTree.inl>
@@ -0,0 +1,335 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+
+#include <girgs/BitManipulation.h>
+#include <girgs/Helper.h>
+#include <girgs/Node.h>
+
+
+namespace girgs {
+
+
+template<unsigned int D>
+DynamicSpatialTree<D>::DynamicSpatialTree(double alpha, double totalWeight, double minWeight, int seed)
+: m_alpha(alpha)
+, m_W(totalWeight)
+, m_w0(minWeight)
+, m_seed(seed >= 0 ? static_cast<uint32_t>(seed) : std::random_device()())
+, m_baseLevelConstant(static_cast<int>(std::log2(m_W/m_w0/m_w0))) // log2(W/w0^2)
+, m_max_level(30 / D)
+{
+    if (!(minWeight > 0.0 && totalWeight > 0.0))
+        throw std::invalid_argument{"Error: the minimum weight and the total weight must be positive"};
+}
+
+
+template<unsigned int D>
+NodeIndex DynamicSpatialTree<D>::insert(const std::array<double, D>& position, double weight) {
+    if (!(weight >= m_w0))
+        throw std::invalid_argument{"Error: the weight of a node must be at least the minimum weight"};
+
+    NodeIndex v;
+    if (m_free.empty()) {
+        v = idBound();
+        m_nodes.emplace_back();
+    } else {
+        v = m_free.back();
+        m_free.pop_back();
+    }
+
+    auto& node = m_nodes[v];
+    node.position = position;
+    node.weight = weight;
+    node.layer = layerOf(weight);
+    assert(node.neighbours.empty());
+    if (node.layer >= m_layers.size())
+        m_layers.resize(node.layer + 1);
+
+    // sample the edges to all nodes in the graph; v is not in a bucket yet
+    auto gen = PhiloxStream(m_seed, static_cast<uint32_t>(m_insertions), static_cast<uint32_t>(m_insertions >> 32));
+    ++m_insertions;
+    for (auto j = 0u; j < m_layers.size(); ++j)
+        if (m_layers[j].size > 0)
+            sampleLayer(v, j, gen);
+
+    // add v to the buckets of its layer on all levels
+    auto& layer = m_layers[node.layer];
+    if (layer.buckets.empty()) {
+        layer.maxLevel = partitioningBaseLevel(0, node.layer);
+        layer.buckets.resize(layer.maxLevel + 1);
+        for (auto level = 0u; level <= layer.maxLevel; ++level)
+            layer.buckets[level].resize(CoordinateHelper::numCellsInLevel(level));
+    }
+
+    node.slots.resize(layer.maxLevel + 1);
+    for (auto level = 0u; level <= layer.maxLevel; ++level) {
+        auto& bucket = layer.buckets[level][CoordinateHelper::cellForPoint(position, level)];
+        node.slots[level] = bucket.size();
+        bucket.push_back(v);
+    }
+
+    ++layer.size;
+    ++m_num_nodes;
+    node.alive = true;
+    return v;
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::erase(NodeIndex node) {
+    if (!contains(node))
+        throw std::invalid_argument{"Error: the node to erase is not in the graph"};
+    auto& data = m_nodes[node];
+
+    // remove the opposite entries of all edges
+    for (auto& neighbour : data.neighbours)
+        removeNeighbour(neighbour.node, neighbour.reverse);
+    m_num_edges -= data.neighbours.size();
+    data.neighbours.clear();
+
+    // remove the node from its buckets; the last node of a bucket takes its slot
+    auto& layer = m_layers[data.layer];
+    for (auto level = 0u; level <= layer.maxLevel; ++level) {
+        auto& bucket = layer.buckets[level][CoordinateHelper::cellForPoint(data.position, level)];
+        const auto slot = data.slots[level];
+        assert(bucket[slot] == node);
+        bucket[slot] = bucket.back();
+        m_nodes[bucket[slot]].slots[level] = slot;
+        bucket.pop_back();
+    }
+
+    --layer.size;
+    --m_num_nodes;
+    data.alive = false;
+    m_free.push_back(node);
+}
+
+
+template<unsigned int D>
+std::vector<std::pair<NodeIndex, NodeIndex>> DynamicSpatialTree<D>::edges() const {
+    std::vector<std::pair<NodeIndex, NodeIndex>> result;
+    result.reserve(m_num_edges);
+    for (NodeIndex u = 0; u < idBound(); ++u)
+        for (auto& neighbour : m_nodes[u].neighbours)
+            if (u < neighbour.node)
+                result.emplace_back(u, neighbour.node);
+    return result;
+}
+
+
+template<unsigned int D>
+unsigned int DynamicSpatialTree<D>::layerOf(double weight) const {
+    return static_cast<unsigned int>(std::log2(weight / m_w0));
+}
+
+
+template<unsigned int D>
+unsigned int DynamicSpatialTree<D>::partitioningBaseLevel(unsigned int layer1, unsigned int layer2) const {
+    const auto result = std::max((m_baseLevelConstant - static_cast<int>(layer1) - static_cast<int>(layer2) - 2) / static_cast<int>(D), 0);
+    return std::min(static_cast<unsigned int>(result), m_max_level);
+}
+
+
+template<unsigned int D>
+template<typename Callback>
+void DynamicSpatialTree<D>::forEachTouchingCell(const Cell& cell, unsigned int level, Callback&& callback) {
+    const auto sides = 1u << level;
+
+    // the distinct coordinates of touching cells in each dimension
+    std::array<std::array<uint32_t, 3>, D> values;
+    std::array<unsigned int, D> counts;
+    auto total = 1u;
+    for (auto d = 0u; d < D; ++d) {
+        if (sides <= 3) {
+            for (auto x = 0u; x < sides; ++x)
+                values[d][x] = x;
+            counts[d] = sides;
+        } else {
+            values[d] = {{(cell[d] + sides - 1) % sides, cell[d], (cell[d] + 1) % sides}};
+            counts[d] = 3;
+        }
+        total *= counts[d];
+    }
+
+    for (auto k = 0u; k < total; ++k) {
+        auto cellB = Cell();
+        auto rest = k;
+        for (auto d = 0u; d < D; ++d) {
+            cellB[d] = values[d][rest % counts[d]];
+            rest /= counts[d];
+        }
+        callback(cellB);
+    }
+}
+
+
+template<unsigned int D>
+unsigned int DynamicSpatialTree<D>::cellDistance(const Cell& cellA, const Cell& cellB, unsigned int level) {
+    const auto sides = 1u << level;
+    auto result = 0u;
+    for (auto d = 0u; d < D; ++d) {
+        const auto dist = cellA[d] > cellB[d] ? cellA[d] - cellB[d] : cellB[d] - cellA[d];
+        result = std::max(result, std::min(dist, sides - dist));
+    }
+    return result;
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::sampleLayer(NodeIndex v, unsigned int j, PhiloxStream& gen) {
+    const auto& node = m_nodes[v];
+    const auto& layer = m_layers[j];
+    const auto baseLevel = partitioningBaseLevel(node.layer, j);
+    assert(baseLevel <= layer.maxLevel);
+
+    const auto cellOnLevel = [&] (unsigned int level) {
+        return BitManipulation<D>::extract(CoordinateHelper::cellForPoint(node.position, level));
+    };
+
+    // type 1: all nodes in the cells touching the cell of v on the partitioning base level
+    forEachTouchingCell(cellOnLevel(baseLevel), baseLevel, [&] (const Cell& cell) {
+        sampleAll(v, layer.buckets[baseLevel][BitManipulation<D>::deposit(cell)], gen);
+    });
+
+    #ifdef NDEBUG
+    if (m_alpha == std::numeric_limits<double>::infinity()) return; // type 2 pairs are never connected in the threshold model
+    #endif // NDEBUG
+
+    // type 2: on each level above, the children of cells touching the parent of the cell of v that do not touch the cell of v.
+    // These children are 2 or 3 cells away from the cell of v, so all buckets at the same distance share one bound.
+    const auto w_upper_bound = node.weight * m_w0*(1<<(j+1)) / m_W;
+    for (auto level = 1u; level <= baseLevel; ++level) {
+        const auto cellA = cellOnLevel(level);
+        auto parentA = Cell();
+        for (auto d = 0u; d < D; ++d)
+            parentA[d] = cellA[d] >> 1;
+
+        for (auto& candidates : m_candidates)
+            candidates.clear();
+        std::array<std::size_t, 2> num_candidates {{0, 0}};
+
+        forEachTouchingCell(parentA, level - 1, [&] (const Cell& parentB) {
+            // the buckets are nested, so the children of an empty bucket are empty as well
+            if (layer.buckets[level - 1][BitManipulation<D>::deposit(parentB)].empty())
+                return;
+
+            for (auto child = 0u; child < CoordinateHelper::numChildren(); ++child) {
+                auto cellB = Cell();
+                for (auto d = 0u; d < D; ++d)
+                    cellB[d] = 2 * parentB[d] + ((child >> d) & 1);
+
+                const auto dist = cellDistance(cellA, cellB, level);
+                if (dist <= 1) // touching; sampled on a deeper level
+                    continue;
+                assert(dist <= 3);
+
+                const auto& bucket = layer.buckets[level][BitManipulation<D>::deposit(cellB)];
+                if (!bucket.empty()) {
+                    m_candidates[dist - 2].push_back(&bucket);
+                    num_candidates[dist - 2] += bucket.size();
+                }
+            }
+        });
+
+        const auto diameter = 1.0 / (1u << level);
+        for (auto k = 0u; k < 2; ++k) {
+            if (!num_candidates[k])
+                continue;
+
+            const auto max_ratio = w_upper_bound / pow_to_the<D>((k + 1) * diameter);
+            const auto max_connection_prob = std::min(std::pow(max_ratio, m_alpha), 1.0);
+            assert(max_ratio < 1.0 || m_alpha != std::numeric_limits<double>::infinity());
+
+            // as in SpatialTree::sampleTypeII(), throwing a coin per pair is cheaper for high probabilities
+            if (max_connection_prob > 0.2) {
+                for (auto bucket : m_candidates[k])
+                    sampleAll(v, *bucket, gen);
+            } else if (num_candidates[k] * max_connection_prob >= 1e-6) {
+                sampleJumps(v, m_candidates[k], max_connection_prob, gen);
+            }
+        }
+    }
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::sampleAll(NodeIndex v, const std::vector<NodeIndex>& bucket, PhiloxStream& gen) {
+    const auto weight = m_nodes[v].weight;
+    const auto inThresholdMode = m_alpha == std::numeric_limits<double>::infinity();
+
+    for (auto u : bucket) {
+        const auto w_term = weight * m_nodes[u].weight / m_W;
+        const auto d_term = pow_to_the<D>(distance(v, u));
+
+        // same comparisons as the TypeIKernel; in the binomial case one random number per pair
+        if (inThresholdMode ? d_term < w_term : gen.uniform() < std::pow(w_term / d_term, m_alpha))
+            addEdge(v, u);
+    }
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::sampleJumps(NodeIndex v, const std::vector<const std::vector<NodeIndex>*>& buckets, double maxProb, PhiloxStream& gen) {
+    const auto weight = m_nodes[v].weight;
+
+    // init geometric distribution (number of failures before the next success) by inversion
+    const auto inv_log_fail = 1.0 / std::log1p(-maxProb);
+    auto geo = [&] { return std::floor(std::log1p(-gen.uniform()) * inv_log_fail); };
+
+    // rd is relative to the current bucket
+    auto current = buckets.begin();
+    for (auto rd = geo(); current != buckets.end(); rd += 1 + geo()) {
+        while (current != buckets.end() && rd >= static_cast<double>((*current)->size())) {
+            rd -= static_cast<double>((*current)->size());
+            ++current;
+        }
+        if (current == buckets.end())
+            break;
+
+        const auto u = (**current)[static_cast<std::size_t>(rd)];
+        const auto rnd = gen.uniform() * maxProb;
+
+        const auto w_term = weight * m_nodes[u].weight / m_W;
+        const auto d_term = pow_to_the<D>(distance(v, u));
+        if (rnd < std::pow(w_term / d_term, m_alpha))
+            addEdge(v, u);
+    }
+}
+
+
+template<unsigned int D>
+double DynamicSpatialTree<D>::distance(NodeIndex u, NodeIndex v) const {
+    auto result = 0.0;
+    for (auto d = 0u; d < D; ++d)
+        result = std::max(result, ExactNodeStorage::torusDistance(m_nodes[u].position[d], m_nodes[v].position[d]));
+    return result;
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::addEdge(NodeIndex u, NodeIndex v) {
+    auto& neighboursU = m_nodes[u].neighbours;
+    auto& neighboursV = m_nodes[v].neighbours;
+    neighboursU.push_back({v, neighboursV.size()});
+    neighboursV.push_back({u, neighboursU.size() - 1});
+    ++m_num_edges;
+}
+
+
+template<unsigned int D>
+void DynamicSpatialTree<D>::removeNeighbour(NodeIndex u, std::size_t index) {
+    auto& neighbours = m_nodes[u].neighbours;
+    neighbours[index] = neighbours.back();
+    neighbours.pop_back();
+
+    // the moved entry has a new position, tell its opposite entry
+    if (index < neighbours.size())
+        m_nodes[neighbours[index].node].neighbours[neighbours[index].reverse].reverse = index;
+}
+
+
+} // namespace girgs
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+#include <girgs/girgs_api.h>
+#include <girgs/Generator.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Receives a block of edges of one graph of EdgeSampler::generateEnsemble().
+ *  Calls for the same sample never overlap, calls for different samples may run concurrently.
+ *  The edges are only valid during the call.
+ */
+using SampleBlockCallback = std::function<void(std::size_t sample, const Edge* edges, std::size_t count)>;
+
+
+/**
+ * @brief
+ *  Samples many graphs that share weights and positions and differ only in the sampling seed.
+ *  The constructor preprocesses weights and positions once (classification into cells, sorting, and prefix sums);
+ *  every sample then only runs the edge sampling on the shared structure.
+ *  For the same seed, the sampled edges equal those of generateEdges() with the same weights, positions, and alpha.
+ *
+ *  All sampling functions are const and may be called concurrently.
+ *
+ *  Example:
+ *  @code
+ *  auto sampler = EdgeSampler(weights, positions, alpha);
+ *  for (int seed = 0; seed < 1000; ++seed)
+ *      process(sampler.generateEdges(seed));   // one graph after another, each by all threads
+ *  @endcode
+ */
+class GIRGS_API EdgeSampler {
+public:
+    /**
+     * @brief
+     *  Preprocesses weights and positions for the sampling.
+     *
+     * @param weights
+     *  Power law distributed weights.
+     * @param positions
+     *  Positions on a torus of dimension 1 to 10. All inner vectors should have the same length.
+     * @param alpha
+     *  Edge probability parameter.
+     */
+    EdgeSampler(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions, double alpha);
+
+    /// Same as EdgeSampler(const std::vector<double>&, const std::vector<std::vector<double>>&, double) for a flat position buffer.
+    EdgeSampler(const std::vector<double>& weights, const FlatPositions& positions, double alpha);
+
+    ~EdgeSampler();
+    EdgeSampler(EdgeSampler&&) noexcept;
+    EdgeSampler& operator=(EdgeSampler&&) noexcept;
+
+    /// number of nodes of the sampled graphs
+    NodeIndex numNodes() const noexcept;
+
+    /// Same as generateEdges(const std::vector<double>&, const FlatPositions&, double, int) on the preprocessed weights and positions.
+    std::vector<Edge> generateEdges(int samplingSeed) const;
+
+    /// Same as generateEdges(const std::vector<double>&, const FlatPositions&, double, int, const EdgeBlockCallback&, std::size_t, unsigned int, unsigned int) on the preprocessed weights and positions.
+    void generateEdges(int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+            unsigned int shard = 0, unsigned int numShards = 1) const;
+
+    /// Same as generateCSR(const std::vector<double>&, const FlatPositions&, double, int) on the preprocessed weights and positions.
+    CSRGraph generateCSR(int samplingSeed) const;
+
+    /**
+     * @brief
+     *  Samples one graph per seed, several in parallel: every thread samples whole graphs on its own,
+     *  which avoids the synchronisation of sampling a single graph by all threads.
+     *  The graph of samplingSeeds[s] equals generateEdges(samplingSeeds[s]).
+     *
+     * @param samplingSeeds
+     *  The seeds of the graphs.
+     * @param consumer
+     *  Called with the index s of the seed for each block of edges of that graph.
+     * @param blockSize
+     *  Maximum number of edges per call of consumer.
+     */
+    void generateEnsemble(const std::vector<int>& samplingSeeds, const SampleBlockCallback& consumer,
+            std::size_t blockSize = std::size_t{1} << 16) const;
+
+    /// Same as generateEnsemble(const std::vector<int>&, const SampleBlockCallback&, std::size_t) but returns the edge lists.
+    std::vector<std::vector<Edge>> generateEnsemble(const std::vector<int>& samplingSeeds) const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+
+} // namespace girgs
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Contiguous storage for the positions of n points on a d dimensional torus \f$[0,1)^d\f$.
+ *  In contrast to std::vector<std::vector<double>>, all coordinates share a single allocation.
+ *
+ *  In row-major layout, the d coordinates of a point are stored next to each other.
+ *  In column-major layout, the i-th coordinates of all points are stored next to each other.
+ */
+class FlatPositions {
+public:
+    enum class Layout { RowMajor, ColumnMajor };
+
+    FlatPositions() = default;
+
+    FlatPositions(std::size_t n, unsigned int dimension, Layout layout = Layout::RowMajor)
+        : m_n(n)
+        , m_dimension(dimension)
+        , m_layout(layout)
+        , m_coords(n * dimension)
+    {}
+
+    /// copies nested positions; all inner vectors must have the same length
+    explicit FlatPositions(const std::vector<std::vector<double>>& positions, Layout layout = Layout::RowMajor)
+        : FlatPositions(positions.size(), positions.empty() ? 0u : static_cast<unsigned int>(positions.front().size()), layout)
+    {
+        for (std::size_t i = 0; i < m_n; ++i) {
+            assert(positions[i].size() == m_dimension);
+            for (auto d = 0u; d < m_dimension; ++d)
+                (*this)(i, d) = positions[i][d];
+        }
+    }
+
+    std::size_t size() const noexcept { return m_n; }
+    bool empty() const noexcept { return m_n == 0; }
+    unsigned int dimension() const noexcept { return m_dimension; }
+    Layout layout() const noexcept { return m_layout; }
+
+    double& operator()(std::size_t i, unsigned int d) noexcept {
+        assert(i < m_n && d < m_dimension);
+        return m_coords[i * pointStride() + d * coordinateStride()];
+    }
+
+    double operator()(std::size_t i, unsigned int d) const noexcept {
+        assert(i < m_n && d < m_dimension);
+        return m_coords[i * pointStride() + d * coordinateStride()];
+    }
+
+    /// offset between the same coordinate of two consecutive points
+    std::size_t pointStride() const noexcept { return m_layout == Layout::RowMajor ? m_dimension : 1; }
+
+    /// offset between two consecutive coordinates of the same point
+    std::size_t coordinateStride() const noexcept { return m_layout == Layout::RowMajor ? 1 : m_n; }
+
+    double* data() noexcept { return m_coords.data(); }
+    const double* data() const noexcept { return m_coords.data(); }
+
+    /// converts back into one vector per point
+    std::vector<std::vector<double>> toNested() const {
+        auto result = std::vector<std::vector<double>>(m_n, std::vector<double>(m_dimension));
+        for (std::size_t i = 0; i < m_n; ++i)
+            for (auto d = 0u; d < m_dimension; ++d)
+                result[i][d] = (*this)(i, d);
+        return result;
+    }
+
+private:
+    std::size_t  m_n{0};                      ///< number of points
+    unsigned int m_dimension{0};              ///< number of coordinates per point
+    Layout       m_layout{Layout::RowMajor};  ///< order of coordinates in m_coords
+    std::vector<double> m_coords;             ///< all coordinates of all points
+};
+
+
+/// Read-only view of n contiguous doubles, e.g. weights in a std::vector<double> or in a MappedPoints file.
+class DoubleView {
+public:
+    DoubleView() = default;
+    DoubleView(const double* data, std::size_t n) noexcept : m_data(data), m_n(n) {}
+    DoubleView(const std::vector<double>& values) noexcept : m_data(values.data()), m_n(values.size()) {}
+
+    std::size_t size() const noexcept { return m_n; }
+    bool empty() const noexcept { return m_n == 0; }
+    const double* data() const noexcept { return m_data; }
+    const double* begin() const noexcept { return m_data; }
+    const double* end() const noexcept { return m_data + m_n; }
+
+    double operator[](std::size_t i) const noexcept {
+        assert(i < m_n);
+        return m_data[i];
+    }
+
+private:
+    const double* m_data = nullptr;
+    std::size_t m_n = 0;
+};
+
+
+/**
+ * @brief
+ *  Read-only view of the positions of n points with the same layout as FlatPositions,
+ *  but without owning the coordinates (e.g. coordinates in a MappedPoints file).
+ */
+class PositionView {
+public:
+    using Layout = FlatPositions::Layout;
+
+    PositionView() = default;
+
+    PositionView(const double* data, std::size_t n, unsigned int dimension, Layout layout = Layout::RowMajor) noexcept
+        : m_data(data), m_n(n), m_dimension(dimension), m_layout(layout) {}
+
+    PositionView(const FlatPositions& positions) noexcept
+        : PositionView(positions.data(), positions.size(), positions.dimension(), positions.layout()) {}
+
+    std::size_t size() const noexcept { return m_n; }
+    unsigned int dimension() const noexcept { return m_dimension; }
+    Layout layout() const noexcept { return m_layout; }
+
+    double operator()(std::size_t i, unsigned int d) const noexcept {
+        assert(i < m_n && d < m_dimension);
+        return m_data[i * pointStride() + d * coordinateStride()];
+    }
+
+    /// same as FlatPositions::pointStride()
+    std::size_t pointStride() const noexcept { return m_layout == Layout::RowMajor ? m_dimension : 1; }
+
+    /// same as FlatPositions::coordinateStride()
+    std::size_t coordinateStride() const noexcept { return m_layout == Layout::RowMajor ? 1 : m_n; }
+
+    const double* data() const noexcept { return m_data; }
+
+private:
+    const double* m_data = nullptr;
+    std::size_t   m_n{0};
+    unsigned int  m_dimension{0};
+    Layout        m_layout{Layout::RowMajor};
+};
+
+// uniform access to the position containers used by the generators
+
+inline std::size_t numPoints(const std::vector<std::vector<double>>& positions) noexcept { return positions.size(); }
+inline std::size_t numPoints(const FlatPositions& positions) noexcept { return positions.size(); }
+inline std::size_t numPoints(const PositionView& positions) noexcept { return positions.size(); }
+
+inline unsigned int dimensionOf(const std::vector<std::vector<double>>& positions) noexcept {
+    return positions.empty() ? 0u : static_cast<unsigned int>(positions.front().size());
+}
+inline unsigned int dimensionOf(const FlatPositions& positions) noexcept { return positions.dimension(); }
+inline unsigned int dimensionOf(const PositionView& positions) noexcept { return positions.dimension(); }
+
+inline double coordinate(const std::vector<std::vector<double>>& positions, std::size_t i, unsigned int d) noexcept { return positions[i][d]; }
+inline double coordinate(const FlatPositions& positions, std::size_t i, unsigned int d) noexcept { return positions(i, d); }
+inline double coordinate(const PositionView& positions, std::size_t i, unsigned int d) noexcept { return positions(i, d); }
+
+template<unsigned int D>
+std::array<double, D> coordinatesOf(const std::vector<std::vector<double>>& positions, std::size_t i) noexcept {
+    assert(positions[i].size() == D);
+    std::array<double, D> result;
+    for (auto d = 0u; d < D; ++d)
+        result[d] = positions[i][d];
+    return result;
+}
+
+template<unsigned int D>
+std::array<double, D> coordinatesOf(const FlatPositions& positions, std::size_t i) noexcept {
+    assert(positions.dimension() == D);
+    const auto* base = positions.data() + i * positions.pointStride();
+    const auto stride = positions.coordinateStride();
+    std::array<double, D> result;
+    for (auto d = 0u; d < D; ++d)
+        result[d] = base[d * stride];
+    return result;
+}
+
+template<unsigned int D>
+std::array<double, D> coordinatesOf(const PositionView& positions, std::size_t i) noexcept {
+    assert(positions.dimension() == D);
+    const auto* base = positions.data() + i * positions.pointStride();
+    const auto stride = positions.coordinateStride();
+    std::array<double, D> result;
+    for (auto d = 0u; d < D; ++d)
+        result[d] = base[d * stride];
+    return result;
+}
+
+
+} // namespace girgs
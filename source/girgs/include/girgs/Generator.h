@@ -2,16 +2,34 @@
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <cstddef>
+#include <functional>
 
 #include <girgs/girgs_api.h>
+#include <girgs/FlatPositions.h>
+#include <girgs/CSRGraph.h>
+#include <girgs/Index.h>
 
 
 namespace girgs {
 
+/// an undirected edge with zero based node indices
+using Edge = std::pair<NodeIndex, NodeIndex>;
+
+/**
+ * @brief
+ *  Receives a block of edges emitted by one thread during edge sampling.
+ *  Calls with the same threadId never overlap, calls with different threadIds may run concurrently.
+ *  The edges are only valid during the call.
+ */
+using EdgeBlockCallback = std::function<void(const Edge* edges, std::size_t count, int threadId)>;
+
 
 /**
  * @brief
  *  The weights are sampled according to a power law distribution between [1, n)
+ *  Unless compiled with OPTION_LEGACY_VARIATES, they only depend on the seed and not on the number of threads.
  *
  * @param n
  *  The size of the graph. Should match with size of positions.
@@ -23,11 +41,12 @@ namespace girgs {
  * @return
  *  The weights according to the desired distribution.
  */
-GIRGS_API std::vector<double> generateWeights(int n, double ple, int weightSeed, bool parallel = true);
+GIRGS_API std::vector<double> generateWeights(NodeIndex n, double ple, int weightSeed, bool parallel = true);
 
 /**
  * @brief
  *  Samples d dimensional coordinates for n points on a torus \f$[0,1)^d\f$.
+ *  Unless compiled with OPTION_LEGACY_VARIATES, they only depend on the seed and not on the number of threads.
  *
  * @param n
  *  Size of the graph.
@@ -39,12 +58,26 @@ GIRGS_API std::vector<double> generateWeights(int n, double ple, int weightSeed,
  * @return
  *  The positions on a torus. All inner vectors have the same length.
  */
-GIRGS_API std::vector<std::vector<double>> generatePositions(int n, int dimension, int positionSeed, bool parallel = true);
+GIRGS_API std::vector<std::vector<double>> generatePositions(NodeIndex n, int dimension, int positionSeed, bool parallel = true);
+
+/**
+ * @brief
+ *  Samples coordinates for all points of a flat position buffer on a torus \f$[0,1)^d\f$.
+ *  Yields the same coordinates as generatePositions(NodeIndex, int, int, bool) for the same seed
+ *  but avoids one heap allocation per point.
+ *
+ * @param positions
+ *  The buffer to fill. Its size and dimension determine the number of points and the dimension of the geometry.
+ * @param positionSeed
+ *  Seed to sample the positions.
+ */
+GIRGS_API void generatePositions(FlatPositions& positions, int positionSeed, bool parallel = true);
 
 /**
  * @brief
  *  Scales all weights so that the expected average degree equals desiredAvgDegree.
  *  Implemented as binary search over an estimation function.
+ *  To scale the same weights for many parameters, use a WeightScalingSolver.
  *
  * @bug
  *  For \f$\alpha > 10\f$ we use the estimation for threshold graphs due to numerical difficulties.
@@ -67,6 +100,9 @@ GIRGS_API std::vector<std::vector<double>> generatePositions(int n, int dimensio
  */
 GIRGS_API double scaleWeights(std::vector<double>& weights, double desiredAvgDegree, int dimension, double alpha);
 
+/// Same as scaleWeights(std::vector<double>&, double, int, double) with the dimension taken from positions.
+GIRGS_API double scaleWeights(std::vector<double>& weights, double desiredAvgDegree, const FlatPositions& positions, double alpha);
+
 /**
  * @brief
  *  Samples edges according to weights and positions.
@@ -76,6 +112,7 @@ GIRGS_API double scaleWeights(std::vector<double>& weights, double desiredAvgDeg
  *  Power law distributed weights.
  * @param positions
  *  Positions on a torus. All inner vectors should have the same length indicating the dimension of the torus.
+ *  Dimensions 1 to 10 are supported; trees too deep for 32 bit cell ids (large n, or dimensions above 5) use 64 bit cell ids.
  * @param alpha
  *  Edge probability parameter.
  * @param samplingSeed
@@ -84,7 +121,81 @@ GIRGS_API double scaleWeights(std::vector<double>& weights, double desiredAvgDeg
  * @return
  *  An edge list with zero based indices.
  */
-GIRGS_API std::vector<std::pair<int,int>> generateEdges(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions,
+GIRGS_API std::vector<Edge> generateEdges(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions,
+        double alpha, int samplingSeed);
+
+/// Same as generateEdges(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int) for a flat position buffer.
+GIRGS_API std::vector<Edge> generateEdges(const std::vector<double>& weights, const FlatPositions& positions,
+        double alpha, int samplingSeed);
+
+/// Same as generateEdges(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int) for views, e.g. into a MappedPoints file.
+GIRGS_API std::vector<Edge> generateEdges(DoubleView weights, PositionView positions,
+        double alpha, int samplingSeed);
+
+/**
+ * @brief
+ *  Samples edges according to weights and positions and streams them to a consumer instead of returning an edge list.
+ *  Each thread buffers up to blockSize edges before handing them to the consumer.
+ *  The sampling can be split into shards (e.g. one per process) that only produce a part of the edges.
+ *
+ * @param weights
+ *  Power law distributed weights.
+ * @param positions
+ *  Positions on a torus. All inner vectors should have the same length indicating the dimension of the torus.
+ * @param alpha
+ *  Edge probability parameter.
+ * @param samplingSeed
+ *  Seed to sample the edges.
+ * @param consumer
+ *  Called for each block of edges (zero based indices) with the id of the producing thread.
+ * @param blockSize
+ *  Maximum number of edges per call of consumer.
+ * @param shard
+ *  Index of the shard to sample, must be less than numShards.
+ * @param numShards
+ *  Number of shards. For the same inputs and a non-negative seed, the shards are disjoint and together form the graph sampled with one shard.
+ */
+GIRGS_API void generateEdges(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+        unsigned int shard = 0, unsigned int numShards = 1);
+
+/// Same as generateEdges(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int, const EdgeBlockCallback&, std::size_t, unsigned int, unsigned int) for a flat position buffer.
+GIRGS_API void generateEdges(const std::vector<double>& weights, const FlatPositions& positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+        unsigned int shard = 0, unsigned int numShards = 1);
+
+/// Same as generateEdges(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int, const EdgeBlockCallback&, std::size_t, unsigned int, unsigned int) for views, e.g. into a MappedPoints file.
+GIRGS_API void generateEdges(DoubleView weights, PositionView positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+        unsigned int shard = 0, unsigned int numShards = 1);
+
+/**
+ * @brief
+ *  Samples edges according to weights and positions and returns them as symmetric adjacency array.
+ *  In contrast to generateEdges(), no intermediate edge list is built:
+ *  the sampler runs twice with the same seed, first to count the degrees and then to place each edge directly.
+ *
+ * @param weights
+ *  Power law distributed weights.
+ * @param positions
+ *  Positions on a torus. All inner vectors should have the same length indicating the dimension of the torus.
+ * @param alpha
+ *  Edge probability parameter.
+ * @param samplingSeed
+ *  Seed to sample the edges.
+ *
+ * @return
+ *  The graph in CSR format with sorted neighbourhoods.
+ */
+GIRGS_API CSRGraph generateCSR(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions,
+        double alpha, int samplingSeed);
+
+/// Same as generateCSR(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int) for a flat position buffer.
+GIRGS_API CSRGraph generateCSR(const std::vector<double>& weights, const FlatPositions& positions,
+        double alpha, int samplingSeed);
+
+/// Same as generateCSR(const std::vector<double>&, const std::vector<std::vector<double>>&, double, int) for views, e.g. into a MappedPoints file.
+GIRGS_API CSRGraph generateCSR(DoubleView weights, PositionView positions,
         double alpha, int samplingSeed);
 
 
@@ -92,6 +203,7 @@ GIRGS_API std::vector<std::pair<int,int>> generateEdges(const std::vector<double
  * @brief
  *  Saves the graph in .dot format (graphviz).
  *  The weight is saved as a label and the coordinates as a position attribute for each Node.
+ *  The lines are formatted by all threads in parallel.
  *
  * @param weights
  *  Power law distributed weights.
@@ -103,7 +215,26 @@ GIRGS_API std::vector<std::pair<int,int>> generateEdges(const std::vector<double
  *  The name of the output file.
  */
 GIRGS_API void saveDot(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions,
-        const std::vector<std::pair<int,int>> &graph, const std::string &file);
+        const std::vector<Edge> &graph, const std::string &file);
+
+/// Same as saveDot(const std::vector<double>&, const std::vector<std::vector<double>>&, const std::vector<Edge>&, const std::string&) for a flat position buffer.
+GIRGS_API void saveDot(const std::vector<double>& weights, const FlatPositions& positions,
+        const std::vector<Edge> &graph, const std::string &file);
+
+/**
+ * @brief
+ *  Saves the graph as text edge list.
+ *  The first line holds the number of nodes and edges, followed by an empty line and one line "u v" per edge.
+ *  The lines are formatted by all threads in parallel.
+ *
+ * @param n
+ *  The number of nodes.
+ * @param graph
+ *  An edge list with zero based indices.
+ * @param file
+ *  The name of the output file.
+ */
+GIRGS_API void saveEdgeList(NodeIndex n, const std::vector<Edge> &graph, const std::string &file);
 
 
 
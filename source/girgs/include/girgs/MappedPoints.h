@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <girgs/girgs_api.h>
+#include <girgs/FlatPositions.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Header of a binary points file (see savePoints()).
+ *  The header is followed by the n weights and then by the n*dimension coordinates of the positions,
+ *  both as doubles in the byte order of the writing machine, starting at byte offset sizeof(BinaryPointsHeader) = 128.
+ *  Hence, the file can be memory mapped and used in place (see MappedPoints).
+ */
+struct BinaryPointsHeader {
+    std::array<char, 8> magic {{'G','I','R','G','P','T','S','\0'}}; ///< identifies the format
+    uint32_t version     = 1;   ///< version of the format
+    uint32_t model       = 0;   ///< meaning of the data: 0 girgs (weights, torus coordinates), 1 hypergirgs (radii, angles)
+    uint32_t dimension   = 0;   ///< coordinates per point
+    uint32_t layout      = 0;   ///< order of the coordinates: 0 row-major, 1 column-major (see FlatPositions::Layout)
+    uint64_t n           = 0;   ///< number of points
+    std::array<double, 4>  parameters {};   ///< model parameters, e.g. the disk radius R for hypergirgs
+    std::array<uint8_t, 64> reserved {};    ///< pads the header to 128 bytes
+};
+static_assert(sizeof(BinaryPointsHeader) == 128, "the data of a binary points file starts at byte 128");
+
+
+/**
+ * @brief
+ *  Saves weights and positions as binary points file (format see BinaryPointsHeader),
+ *  e.g. to generate graphs for them later without parsing text (see MappedPoints).
+ *
+ * @param weights
+ *  One weight per point.
+ * @param positions
+ *  The positions in any layout; the layout is kept.
+ * @param file
+ *  The name of the output file.
+ */
+GIRGS_API void savePoints(const std::vector<double>& weights, const FlatPositions& positions, const std::string& file);
+
+
+/**
+ * @brief
+ *  Memory maps a binary points file (see savePoints()) read-only.
+ *  weights() and positions() point into the mapping, so they can be passed to generateEdges() without copying
+ *  or parsing; the operating system reads the pages of the file on first access and may drop them again.
+ *  The views stay valid for the lifetime of this object.
+ *
+ *  On systems without mmap, the file is read into memory instead.
+ */
+class GIRGS_API MappedPoints {
+public:
+    /// maps file; throws std::runtime_error if the file is no valid binary points file
+    explicit MappedPoints(const std::string& file);
+    ~MappedPoints();
+
+    MappedPoints(const MappedPoints&) = delete;
+    MappedPoints& operator=(const MappedPoints&) = delete;
+
+    const BinaryPointsHeader& header() const noexcept { return *static_cast<const BinaryPointsHeader*>(m_data); }
+
+    std::size_t size() const noexcept { return static_cast<std::size_t>(header().n); }
+    unsigned int dimension() const noexcept { return header().dimension; }
+
+    /// the n weights
+    DoubleView weights() const noexcept;
+
+    /// the positions in the layout of the file
+    PositionView positions() const noexcept;
+
+private:
+    void unmap() noexcept;
+
+    const void* m_data = nullptr;   ///< begin of the mapped file
+    std::size_t m_bytes = 0;        ///< size of the mapped file
+    std::vector<double> m_buffer;   ///< holds the file if it cannot be mapped
+};
+
+
+} // namespace girgs
@@ -1,37 +1,110 @@
-
 #pragma once
 
 #include <array>
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include <girgs/Index.h>
 
 
 namespace girgs {
 
-template<unsigned int D>
+/**
+ * @brief
+ *  Stores coordinates and weights of nodes as double.
+ */
+struct ExactNodeStorage {
+    using Coordinate = double;
+    using Weight = double;
+
+    static Coordinate coordinate(double x) noexcept { return x; }
+    static double position(Coordinate c) noexcept { return c; }
+    static Weight weight(double w) noexcept { return w; }
+
+    /// distance of two coordinates on the 1-dimensional torus
+    static double torusDistance(Coordinate a, Coordinate b) noexcept {
+        const auto dist = std::abs(a - b);
+        return std::min(dist, 1.0-dist);
+    }
+};
+
+/**
+ * @brief
+ *  Stores coordinates as 32 bit fixed point numbers and weights as float.
+ *  Coordinate x in [0,1) is stored as floor(x * 2^32). This keeps the top bits that the
+ *  SpatialTreeCoordinateHelper uses to find the cell of a point (at most 32 per dimension), so
+ *  quantised points stay in their cells. The torus distance is computed exactly in integer
+ *  arithmetic (using wrap around) and converted to double without rounding.
+ */
+struct CompactNodeStorage {
+    using Coordinate = uint32_t;
+    using Weight = float;
+
+    static Coordinate coordinate(double x) noexcept {
+        assert(0.0 <= x && x < 1.0);
+        return static_cast<Coordinate>(x * 0x1.0p32);
+    }
+    static double position(Coordinate c) noexcept { return c * 0x1.0p-32; }
+    static Weight weight(double w) noexcept { return static_cast<Weight>(w); }
+
+    /// distance of two coordinates on the 1-dimensional torus
+    static double torusDistance(Coordinate a, Coordinate b) noexcept {
+        const Coordinate diff = a - b;
+        return position(std::min<Coordinate>(diff, -diff));
+    }
+};
+
+/// storage used by the SpatialTree, compact if compiled with OPTION_COMPACT_NODES
+#ifdef USE_COMPACT_NODES
+    using NodeStorage = CompactNodeStorage;
+#else
+    using NodeStorage = ExactNodeStorage;
+#endif
+
+
+/// CellId is the type of the sort key cell_id (see SpatialTreeCoordinateHelper)
+template<unsigned int D, typename Storage = ExactNodeStorage, typename CellId = uint32_t>
 struct Node {
-    std::array<double, D>   coord;
-    double                  weight;
-    int                     index;
-    int                     cell_id;
+    using Coordinate = typename Storage::Coordinate;
+    using Weight = typename Storage::Weight;
+
+    std::array<Coordinate, D>   coord;
+    Weight                      weight;
+    NodeIndex                   index;
+    CellId                      cell_id;
 
     Node() {}; // prevent default values
 
-    Node(const std::vector<double>& _coord, double weight, int index, int cell_id = 0)
-        : weight(weight), index(index), cell_id(cell_id)
+    Node(const std::vector<double>& _coord, double weight, NodeIndex index, CellId cell_id = 0)
+        : weight(Storage::weight(weight)), index(index), cell_id(cell_id)
     {
         assert(_coord.size()==D);
-        std::copy_n(_coord.cbegin(), D, coord.begin());
+        for (auto d = 0u; d < D; ++d)
+            coord[d] = Storage::coordinate(_coord[d]);
+    }
+
+    Node(const std::array<double, D>& _coord, double weight, NodeIndex index, CellId cell_id = 0)
+        : weight(Storage::weight(weight)), index(index), cell_id(cell_id)
+    {
+        for (auto d = 0u; d < D; ++d)
+            coord[d] = Storage::coordinate(_coord[d]);
+    }
+
+    /// coordinates as double
+    std::array<double, D> position() const noexcept {
+        std::array<double, D> result;
+        for (auto d = 0u; d < D; ++d)
+            result[d] = Storage::position(coord[d]);
+        return result;
     }
 
     double distance(const Node& other) const {
         auto result = 0.0;
-        for(auto d=0u; d<D; ++d){
-            auto dist = std::abs(coord[d] - other.coord[d]);
-            dist = std::min(dist, 1.0-dist);
-            result = std::max(result, dist);
-        }
+        for(auto d=0u; d<D; ++d)
+            result = std::max(result, Storage::torusDistance(coord[d], other.coord[d]));
         return result;
     }
 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+#include <girgs/Node.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Structure-of-arrays storage for the sorted nodes of a SpatialTree.
+ *  Each coordinate, the weights and the indices are kept in separate contiguous columns,
+ *  so that the type 1 kernels (see TypeIKernel.h) can load several nodes with one instruction.
+ *  Coordinates and weights are stored as described by NodeStorage.
+ *
+ * @tparam D
+ *  the dimension of the geometry
+ */
+template<unsigned int D>
+struct NodeColumns {
+    using Storage = NodeStorage;
+    using Coordinate = Storage::Coordinate;
+    using Weight = Storage::Weight;
+
+    std::array<std::vector<Coordinate>, D> coords;  ///< coords[d][k] is the d-th coordinate of the k-th node
+    std::vector<Weight> weights;                    ///< weight of the k-th node
+    std::vector<NodeIndex> indices;                 ///< original index of the k-th node
+
+    NodeColumns() = default;
+
+    /// n nodes to be filled with set()
+    explicit NodeColumns(std::size_t n)
+        : weights(n)
+        , indices(n)
+    {
+        for (auto& column : coords)
+            column.resize(n);
+    }
+
+    /// transposes nodes
+    template<typename CellId>
+    explicit NodeColumns(const std::vector<Node<D, Storage, CellId>>& nodes)
+        : NodeColumns(nodes.size())
+    {
+        const auto n = static_cast<long long>(nodes.size());
+        #pragma omp parallel for schedule(static)
+        for (long long k = 0; k < n; ++k)
+            set(k, nodes[k]);
+    }
+
+    /// stores node as the k-th node
+    template<typename CellId>
+    void set(std::size_t k, const Node<D, Storage, CellId>& node) noexcept {
+        for (auto d = 0u; d < D; ++d)
+            coords[d][k] = node.coord[d];
+        weights[k] = node.weight;
+        indices[k] = node.index;
+    }
+
+    std::size_t size() const noexcept { return weights.size(); }
+
+    std::array<Coordinate, D> coord(std::size_t k) const noexcept {
+        std::array<Coordinate, D> result;
+        for (auto d = 0u; d < D; ++d)
+            result[d] = coords[d][k];
+        return result;
+    }
+
+    /// coordinates of the k-th node as double
+    std::array<double, D> position(std::size_t k) const noexcept {
+        std::array<double, D> result;
+        for (auto d = 0u; d < D; ++d)
+            result[d] = Storage::position(coords[d][k]);
+        return result;
+    }
+
+    /// torus distance in maximum norm between the k-th and l-th node; same as Node::distance()
+    double distance(std::size_t k, std::size_t l) const noexcept {
+        auto result = 0.0;
+        for (auto d = 0u; d < D; ++d)
+            result = std::max(result, Storage::torusDistance(coords[d][k], coords[d][l]));
+        return result;
+    }
+
+    void prefetch(std::size_t k) const noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        for (auto d = 0u; d < D; ++d)
+            __builtin_prefetch(coords[d].data() + k, 0);
+        __builtin_prefetch(weights.data() + k, 0);
+        __builtin_prefetch(indices.data() + k, 0);
+#endif
+    }
+};
+
+
+} // namespace girgs
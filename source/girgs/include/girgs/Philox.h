@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Counter-based pseudo random number generator Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11).
+ *  A random block is a pure function of a 128 bit counter and a 64 bit key.
+ *  Hence, any element of any stream can be computed directly without generating its predecessors.
+ */
+class Philox4x32 {
+public:
+    using Counter = std::array<uint32_t, 4>;
+    using Key     = std::array<uint32_t, 2>;
+
+    static Counter block(Counter ctr, Key key) noexcept {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += W0;
+                key[1] += W1;
+            }
+            const auto prod0 = static_cast<uint64_t>(M0) * ctr[0];
+            const auto prod1 = static_cast<uint64_t>(M1) * ctr[2];
+            ctr = {{
+                static_cast<uint32_t>(prod1 >> 32) ^ ctr[1] ^ key[0],
+                static_cast<uint32_t>(prod1),
+                static_cast<uint32_t>(prod0 >> 32) ^ ctr[3] ^ key[1],
+                static_cast<uint32_t>(prod0)
+            }};
+        }
+        return ctr;
+    }
+
+    /**
+     * @brief
+     *  Computes count blocks at once; the i-th counter is (c0[i], c1[i], c2[i], c3[i]) and is replaced by its block.
+     *  The lanes are stored in separate arrays, so that every round becomes a SIMD loop.
+     */
+    static void blocks(uint32_t* c0, uint32_t* c1, uint32_t* c2, uint32_t* c3, std::size_t count, Key key) noexcept {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += W0;
+                key[1] += W1;
+            }
+            #pragma omp simd
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto prod0 = static_cast<uint64_t>(M0) * c0[i];
+                const auto prod1 = static_cast<uint64_t>(M1) * c2[i];
+                c0[i] = static_cast<uint32_t>(prod1 >> 32) ^ c1[i] ^ key[0];
+                c1[i] = static_cast<uint32_t>(prod1);
+                c2[i] = static_cast<uint32_t>(prod0 >> 32) ^ c3[i] ^ key[1];
+                c3[i] = static_cast<uint32_t>(prod0);
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;
+    static constexpr uint32_t W1 = 0xBB67AE85;
+};
+
+
+/**
+ * @brief
+ *  A seekable stream of 64 bit random numbers identified by a key and two stream ids.
+ *  The i-th number of the stream only depends on (key, streamA, streamB, i);
+ *  in particular, it does not depend on which thread consumes the stream.
+ *  Satisfies UniformRandomBitGenerator.
+ */
+class PhiloxStream {
+public:
+    using result_type = uint64_t;
+
+    PhiloxStream(uint64_t key, uint32_t streamA, uint32_t streamB, uint64_t position = 0) noexcept
+        : m_key{{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)}}
+        , m_streamA(streamA)
+        , m_streamB(streamB)
+    {
+        seek(position);
+    }
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() noexcept {
+        if (m_next == 2) {
+            ++m_block;
+            m_next = 0;
+            refill();
+        }
+        const auto result = (static_cast<uint64_t>(m_buffer[2*m_next]) << 32) | m_buffer[2*m_next + 1];
+        ++m_next;
+        return result;
+    }
+
+    /// continue the stream with its position-th number
+    void seek(uint64_t position) noexcept {
+        m_block = position / 2;
+        m_next = static_cast<unsigned>(position % 2);
+        refill();
+    }
+
+    /// uniform double in [0, 1) using the upper 53 bits of the next number
+    double uniform() noexcept {
+        return toUniform((*this)());
+    }
+
+    /**
+     * @brief
+     *  Writes the uniforms of the numbers first, ..., first+count-1 of the stream to out,
+     *  i.e., out[k] == PhiloxStream(key, streamA, streamB, first + k).uniform().
+     *  The blocks are computed in batches with Philox4x32::blocks().
+     */
+    static void fillUniform(double* out, std::size_t count, uint64_t key, uint32_t streamA, uint32_t streamB, uint64_t first) noexcept {
+        constexpr std::size_t kBatch = 64;
+        const auto philoxKey = Philox4x32::Key{{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)}};
+
+        std::size_t k = 0;
+        if (count > 0 && first % 2)
+            out[k++] = PhiloxStream(key, streamA, streamB, first).uniform();
+
+        alignas(64) std::array<uint32_t, kBatch> c0, c1, c2, c3;
+        while (count - k >= 2) {
+            const auto block = (first + k) / 2;
+            const auto size = std::min(kBatch, (count - k) / 2);
+            const auto low = static_cast<uint32_t>(block);
+            const auto high = static_cast<uint32_t>(block >> 32);
+            #pragma omp simd
+            for (std::size_t i = 0; i < size; ++i) {
+                c0[i] = low + static_cast<uint32_t>(i);
+                c1[i] = streamA;
+                c2[i] = streamB;
+                c3[i] = high + (c0[i] < low); // carry if the lower word wrapped around
+            }
+            Philox4x32::blocks(c0.data(), c1.data(), c2.data(), c3.data(), size, philoxKey);
+            double* batch = out + k;
+            #pragma omp simd
+            for (std::size_t i = 0; i < size; ++i) {
+                batch[2*i    ] = toUniform(c0[i], c1[i]);
+                batch[2*i + 1] = toUniform(c2[i], c3[i]);
+            }
+            k += 2 * size;
+        }
+
+        if (k < count)
+            out[k] = PhiloxStream(key, streamA, streamB, first + k).uniform();
+    }
+
+private:
+    static double toUniform(uint64_t bits) noexcept {
+        return static_cast<double>(bits >> 11) * 0x1.0p-53;
+    }
+
+    /// same as toUniform((hi << 32) | lo) but converts signed 32 bit integers only, which has SIMD instructions; all operations are exact
+    static double toUniform(uint32_t hi, uint32_t lo) noexcept {
+        const auto upper = static_cast<double>(static_cast<int32_t>(hi ^ 0x80000000u)) + 0x1.0p31;
+        return upper * 0x1.0p-32 + static_cast<double>(static_cast<int32_t>(lo >> 11)) * 0x1.0p-53;
+    }
+
+    void refill() noexcept {
+        m_buffer = Philox4x32::block({{
+            static_cast<uint32_t>(m_block), m_streamA, m_streamB, static_cast<uint32_t>(m_block >> 32)
+        }}, m_key);
+    }
+
+    Philox4x32::Key m_key;
+    uint32_t m_streamA;
+    uint32_t m_streamB;
+
+    uint64_t m_block;               ///< counter of the current block
+    unsigned m_next;                ///< next 64 bit word of the current block (0 or 1)
+    Philox4x32::Counter m_buffer;   ///< random bits of the current block
+};
+
+
+} // namespace girgs
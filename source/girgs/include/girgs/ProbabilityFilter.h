@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+
+
+namespace girgs {
+
+/**
+ * The filter is used to decide \f$ u < r^\alpha \f$ without evaluating the power for almost all pairs,
+ * where \f$ r = (w_u w_v / W) / dist^D \f$ is the weight-distance ratio of a pair and u a uniform random number in [0,1).
+ * For each stage i it stores the ratio \f$ (i/stages)^{1/\alpha} \f$ at which the connection probability is i/stages.
+ * Only if the ratio falls between the bounds of the stage of u, the exact test is required.
+ * The bounds are widened by a relative margin which is far larger than the rounding error of pow,
+ * so the decisions of the filter agree with the exact test.
+ *
+ * @tparam stages
+ *  The resolution of the filter (i.e. number of entries).
+ *  The exact test is needed for roughly one in stages pairs.
+ */
+template<std::size_t stages>
+class ProbabilityFilter {
+public:
+    /**
+     * Creates a probability filter for the girg connection probability \f$ \min(1, r^\alpha) \f$.
+     *
+     * @param alpha
+     *  The girg model parameter, must be finite.
+     */
+    explicit ProbabilityFilter(double alpha) {
+        for (std::size_t i = 0; i <= stages; i++) {
+            const auto ratio = std::pow(static_cast<double>(i) / stages, 1.0 / alpha);
+            filter_stages_lower[i] = ratio * (1.0 - margin);
+            filter_stages_upper[i] = ratio * (1.0 + margin);
+        }
+    }
+
+    /// a pair with a ratio at most the returned value has a connection probability of at most rnd
+    /// i.e. it is surely disconnected
+    double ratioForProb_lowerBound(double rnd) const {
+        assert(0.0 <= rnd && rnd < 1.0);
+        return filter_stages_lower[static_cast<std::size_t>(rnd * stages)];
+    }
+
+    /// a pair with a ratio at least the returned value has a connection probability larger than rnd
+    /// i.e. it is surely connected
+    double ratioForProb_upperBound(double rnd) const {
+        assert(0.0 <= rnd && rnd < 1.0);
+        return filter_stages_upper[static_cast<std::size_t>(rnd * stages) + 1];
+    }
+
+private:
+    static constexpr double margin = 1e-9; ///< relative safety margin against rounding errors
+
+    std::array<double, stages+1> filter_stages_lower; ///< pos i holds slightly less than the ratio with connection prob i/stages
+    std::array<double, stages+1> filter_stages_upper; ///< pos i holds slightly more than the ratio with connection prob i/stages
+};
+
+
+} // namespace girgs
@@ -1,15 +1,26 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
+#include <memory>
 #include <algorithm>
 #include <random>
 #include <limits>
 #include <numeric>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
 #include <omp.h>
 
+#include <girgs/FlatPositions.h>
+#include <girgs/Index.h>
+#include <girgs/NodeColumns.h>
+#include <girgs/Philox.h>
+#include <girgs/ProbabilityFilter.h>
 #include <girgs/SpatialTreeCoordinateHelper.h>
 #include <girgs/WeightLayer.h>
 
@@ -18,6 +29,20 @@ namespace girgs {
 
 using default_random_engine = std::mt19937_64;
 
+/**
+ * @brief
+ *  The preprocessed weights and positions of a SpatialTree.
+ *  Trees with different edge callbacks share it to sample several graphs without repeating the preprocessing
+ *  (see SpatialTree(const SpatialTree<D, OtherCallback>&, EdgeCallback&)).
+ */
+template<unsigned int D, typename CellId = uint32_t>
+struct SpatialTreePartition {
+    NodeColumns<D>                      nodes;          ///< nodes ordered by layer first and morton code second (structure of arrays)
+    std::vector<NodeOffset>             first_in_cell;  ///< prefix sums into nodes array
+    std::vector<WeightLayer<D, CellId>> weight_layers;  ///< provides access to the nodes as described in paper
+    std::vector<std::vector<uint64_t>>  non_empty;      ///< per level: bit k is set if the k-th cell of the level contains points of a layer accessed on it
+};
+
 /**
  * @brief
  *  Internal implementation of the linear time GIRG sampling algorithm following the method object pattern.
@@ -25,14 +50,38 @@ using default_random_engine = std::mt19937_64;
  *
  * @tparam D
  *  Dimension of the underlying geometry.
+ * @tparam CellId
+ *  uint32_t or uint64_t. Deep trees (large n or high D) need 64 bit cell ids, see cellIdBits().
  */
-template<unsigned int D, typename EdgeCallback>
+template<unsigned int D, typename EdgeCallback, typename CellId = uint32_t>
 class SpatialTree
 {
-    using CoordinateHelper = SpatialTreeCoordinateHelper<D>;
+    static_assert(std::is_same<CellId, uint32_t>::value || std::is_same<CellId, uint64_t>::value,
+                  "Cell ids are either 32 or 64 bit unsigned integers");
+
+    using CoordinateHelper = SpatialTreeCoordinateHelper<D, CellId>;
+    using Children = std::array<CellId, CoordinateHelper::numChildren()>;
 
 public:
-    SpatialTree(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions, double alpha, EdgeCallback& edgeCallback, bool profile = false);
+    /**
+     * @brief
+     *  Preprocesses weights and positions.
+     *
+     * @tparam WeightContainer
+     *  Either std::vector<double> or DoubleView.
+     * @tparam PositionContainer
+     *  Either std::vector<std::vector<double>>, FlatPositions, or PositionView.
+     */
+    template<typename WeightContainer, typename PositionContainer>
+    SpatialTree(const WeightContainer& weights, const PositionContainer& positions, double alpha, EdgeCallback& edgeCallback, bool profile = false);
+
+    /**
+     * @brief
+     *  Shares the preprocessed weights and positions of other instead of preprocessing them again.
+     *  Trees that share them can sample edges concurrently (e.g. for different seeds), each reporting to its own callback.
+     */
+    template<typename OtherCallback>
+    SpatialTree(const SpatialTree<D, OtherCallback, CellId>& other, EdgeCallback& edgeCallback);
 
     /**
      * @brief
@@ -46,11 +95,27 @@ public:
      *  Infinity results in a deterministic threshold case.
      *  Zero produces a clique.
      * @param seed
-     *  The seed for the edge sampling.
-     *  If OpenMP is given more than one thread, thread i uses seed+i.
-     *  This means that results are only reproducible for a combination of seed and thread number.
+     *  The seed for the edge sampling. A negative seed draws a random one.
+     *  Random numbers are taken from counter-based streams keyed by (seed, layer pair, cell pair),
+     *  so the sampled edges only depend on the seed and not on the number of threads or the schedule.
+     *  Only the order in which edges are reported may differ between runs.
+     * @param shard
+     *  Index of the shard to sample, must be less than numShards.
+     * @param numShards
+     *  Splits the edge sampling into this many shards, e.g. to spread one graph over several processes.
+     *  The cells of the shard level (see shardLevel()) are split into numShards contiguous slices in Morton order
+     *  and a shard only samples the cell pairs whose cellA lies in (or, above the shard level, starts in) its slice.
+     *  Since the random streams do not depend on the shard, the shards of one seed are disjoint and their union
+     *  is the graph sampled with numShards = 1.
      */
-    void generateEdges(int seed);
+    void generateEdges(int seed, unsigned int shard = 0, unsigned int numShards = 1);
+
+    /**
+     * @brief
+     *  The level whose cells are split into shards by generateEdges(int, unsigned int, unsigned int).
+     *  It is the first level with at least #s_cells_per_shard cells per shard (or the deepest level if there is none).
+     */
+    unsigned int shardLevel(unsigned int numShards) const;
 
 protected:
 
@@ -67,13 +132,15 @@ protected:
      * @param level
      *  The level from which A and B are, meaning cellA and cellB must be in the same level.
      */
-    void visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level);
+    void visitCellPair(CellId cellA, CellId cellB, unsigned int level);
 
     /**
      * @brief
-     *  Same as visitCellPair(unsigned int, unsigned int, unsigned int) but stops recursion before first_parallel_level.
-     *  Instead, the calls that would be made in this level are saved in parallel_calls.
-     *  The saved calls are grouped by their (level local) cellA parameter.
+     *  Same as visitCellPair(CellId, CellId, unsigned int) but used in the parallel phase.
+     *  Each child cell pair becomes an OpenMP task. Children whose cost reaches #m_task_cost_threshold
+     *  are again processed by this function (i.e. split further), all others sequentially by visitCellPair().
+     *  Large type 1 jobs are split into chunks of rows (see sampleTypeI()).
+     *  Idle threads steal the resulting tasks from the OpenMP runtime.
      *
      * @param cellA
      *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
@@ -81,15 +148,35 @@ protected:
      *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
      * @param level
      *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
-     * @param first_parallel_level
-     *  The level before which we "saw off" the recursion.
-     *  To get sufficient parallel cells (the outer size of parallel_calls) this should be computed as
-     *  \f$ 2^{dl} \geq kt \f$ solved for l (d dimension, l first_parallel_level, t threads, k tuning parameter).
-     *  We get \f$ l \geq \log_2(kt) / d \f$.
-     * @param parallel_calls
      */
-    void visitCellPair_sequentialStart(unsigned int cellA, unsigned int cellB, unsigned int level,
-            unsigned int first_parallel_level, std::vector<std::vector<unsigned int>>& parallel_calls);
+    void visitCellPairTasks(CellId cellA, CellId cellB, unsigned int level);
+
+    /**
+     * @brief
+     *  Estimates the work of visitCellPair(CellId, CellId, unsigned int) as the product of
+     *  the number of points in cellA and cellB (counting only weight layers that are still relevant on this level).
+     *  Uses WeightLayer::pointsInCell(CellId, unsigned int) const and hence takes time linear in the number of layers.
+     */
+    double cellPairCost(CellId cellA, CellId cellB, unsigned int level) const;
+
+    /**
+     * @brief
+     *  Writes the children of cell (on level+1) that contain points of a weight layer accessed on level+1 or below
+     *  to children and returns their number (see SpatialTreePartition::non_empty).
+     *  The recursion skips all other children, since their cell pairs contain no edges.
+     *  In high dimensions, this avoids most of the \f$4^D\f$ child pairs of a touching cell pair.
+     */
+    unsigned int nonEmptyChildren(CellId cell, unsigned int level, Children& children) const;
+
+    /// fills SpatialTreePartition::non_empty from the weight layers of partition, deepest level first
+    void markNonEmptyCells(SpatialTreePartition<D, CellId>& partition) const;
+
+    /**
+     * @brief
+     *  The first and last shard of the current generateEdges() call that own a cell pair with cellA as source cell
+     *  or as ancestor of the source cell. The cell pairs of cellA on this level belong to the first one.
+     */
+    std::pair<unsigned int, unsigned int> shardsOfCell(CellId cellA, unsigned int level) const;
 
     /**
      * @brief
@@ -106,8 +193,19 @@ protected:
      *  The weight layer for all considered nodes in cellA.
      * @param j
      *  The weight layer for all considered nodes in cellB.
+     * @param spawnTasks
+     *  If set and there are many node pairs, the rows (nodes in cellA) are processed in chunks by separate OpenMP tasks.
+     *  Since random numbers come from a seekable stream, this does not change the result.
      */
-    void sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    void sampleTypeI(CellId cellA, CellId cellB, unsigned int level, unsigned int i, unsigned int j, bool spawnTasks = false);
+
+    /**
+     * @brief
+     *  Samples the type 1 edges of sampleTypeI(CellId, CellId, unsigned int, unsigned int, unsigned int, bool)
+     *  between the nodes with rank rowBegin to rowEnd-1 in \f$ V_i^A \f$ and the nodes in \f$ V_j^B \f$.
+     */
+    void sampleTypeIRows(CellId cellA, CellId cellB, unsigned int level, unsigned int i, unsigned int j,
+            long long rowBegin, long long rowEnd);
 
     /**
      * @brief
@@ -125,7 +223,7 @@ protected:
      * @param j
      *  The weight layer for all considered nodes in cellB.
      */
-    void sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    void sampleTypeII(CellId cellA, CellId cellB, unsigned int level, unsigned int i, unsigned int j);
 
     /**
      * @brief
@@ -178,16 +276,37 @@ protected:
      */
     unsigned int partitioningBaseLevel(int layer1, int layer2) const;
 
+    /**
+     * @brief
+     *  The random stream used to sample the edges between \f$ V_i^A \f$ and \f$ V_j^B \f$.
+     *  Each such combination is visited at most once, so every stream is consumed by a single call.
+     *  The lower 32 bits of the cell ids select the stream; if cell ids exceed 32 bits, their upper bits (at most 15)
+     *  select a range of \f$2^{33}\f$ numbers within it, so 32 bit trees get the same streams with either cell id type.
+     */
+    PhiloxStream randomStream(CellId cellA, CellId cellB, unsigned int i, unsigned int j) const {
+        const auto upperA = static_cast<uint64_t>(cellA) >> 32;
+        const auto upperB = static_cast<uint64_t>(cellB) >> 32;
+        assert(upperA < (1u << 15) && upperB < (1u << 15));
+        return {(static_cast<uint64_t>(m_seed) << 32) | (i << 16) | j,
+                static_cast<uint32_t>(cellA), static_cast<uint32_t>(cellB), ((upperA << 15) | upperB) << 33};
+    }
+
 
-    std::vector<WeightLayer<D>> buildPartition(
-        const std::vector<double>& weights, const std::vector<std::vector<double>>& positions);
+    template<typename WeightContainer, typename PositionContainer>
+    std::shared_ptr<const SpatialTreePartition<D, CellId>> buildPartition(
+        const WeightContainer& weights, const PositionContainer& positions);
 
 
 private:
+    template<unsigned int, typename, typename> friend class SpatialTree;
+
     EdgeCallback& m_EdgeCallback; ///< called for every produced edge
     const bool m_profile;
 
     double m_alpha;             ///< girg model parameter, with higher alpha, long edges become less likely
+
+    constexpr static std::size_t filter_size = 1024;
+    ProbabilityFilter<filter_size> m_filter; ///< avoids most evaluations of pow in the binomial case
     long long m_n;              ///< number of nodes in the graph
 
     double m_w0;                ///< minimum weight
@@ -198,13 +317,21 @@ private:
     unsigned int m_layers; ///< number of layers
     unsigned int m_levels; ///< number of levels
     
-    std::vector<Node<D>>        m_nodes;            ///< nodes ordered by layer first and morton code second
-    std::vector<unsigned int>   m_first_in_cell;    ///< prefix sums into nodes array
-    std::vector<WeightLayer<D>> m_weight_layers;    ///< provides access to the nodes as described in paper
+    std::shared_ptr<const SpatialTreePartition<D, CellId>> m_partition; ///< nodes and weight layers, possibly shared with other trees
     std::vector<std::vector<std::pair<unsigned int, unsigned int>>> m_layer_pairs; ///< which pairs of weight layers to check in each level
 
 
-    std::vector<default_random_engine> m_gens; ///< random generators for each thread
+    uint32_t m_seed = 0; ///< seed of the current generateEdges call, part of the key of all random streams
+
+    unsigned int m_shard = 0;       ///< shard sampled by the current generateEdges call
+    unsigned int m_num_shards = 1;  ///< number of shards of the current generateEdges call
+    unsigned int m_shard_level = 0; ///< level whose cells are split into shards, see shardLevel()
+
+    double m_task_cost_threshold = std::numeric_limits<double>::infinity(); ///< cell pairs with at least this cost are split into tasks (see cellPairCost())
+
+    static constexpr int s_tasks_per_thread = 16;       ///< the task cost threshold is the total cost divided by this many tasks per thread
+    static constexpr long long s_type1_chunk = 1 << 15; ///< number of node pairs per task when splitting type 1 jobs
+    static constexpr unsigned int s_cells_per_shard = 4; ///< minimum number of cells per shard on the shard level
 
 #ifndef NDEBUG
     long long m_type1_checks = 0; ///< number of node pairs that are checked via a type 1 check
@@ -220,6 +347,105 @@ SpatialTree<D,EdgeCallback> makeSpatialTree(const std::vector<double>& weights,
     return {weights, positions, alpha, edgeCallback, profile};
 }
 
+/// provide automatic type deduction for constructor
+template <unsigned int D, typename EdgeCallback>
+SpatialTree<D,EdgeCallback> makeSpatialTree(const std::vector<double>& weights, const FlatPositions& positions,
+        double alpha, EdgeCallback& edgeCallback, bool profile = false) {
+    return {weights, positions, alpha, edgeCallback, profile};
+}
+
+/// provide automatic type deduction for constructor
+template <unsigned int D, typename EdgeCallback>
+SpatialTree<D,EdgeCallback> makeSpatialTree(const DoubleView& weights, const PositionView& positions,
+        double alpha, EdgeCallback& edgeCallback, bool profile = false) {
+    return {weights, positions, alpha, edgeCallback, profile};
+}
+
+/// provide automatic type deduction for constructor
+template <unsigned int D, typename OtherCallback, typename EdgeCallback, typename CellId>
+SpatialTree<D,EdgeCallback,CellId> makeSpatialTree(const SpatialTree<D, OtherCallback, CellId>& other, EdgeCallback& edgeCallback) {
+    return {other, edgeCallback};
+}
+
+
+/**
+ * @brief
+ *  The number of bits needed by the cell ids of a SpatialTree<D, EdgeCallback, CellId> for weights
+ *  with minimum w0, maximum wn and sum W (as stored, see NodeStorage).
+ *  The cell ids have to index the cells of all levels down to the deepest target level of a weight layer (plus one)
+ *  as well as the prefix sums over the target levels of all weight layers.
+ *  Both grow with \f$\log_2(W/w_0^2) \approx \log_2(n)\f$, i.e. the depth of the tree is about \f$\log_2(n)/D\f$ levels of D bits.
+ */
+template<unsigned int D>
+unsigned int cellIdBits(double w0, double wn, double W) {
+    // same levels as in SpatialTree::weightLayerTargetLevel(int) const
+    const auto baseLevelConstant = static_cast<int>(std::log2(W/w0/w0));
+    const auto layers = static_cast<int>(std::floor(std::log2(wn/w0))) + 1;
+
+    auto deepest = 0;
+    auto cells = 0.0;
+    for (auto layer = 0; layer < layers; ++layer) {
+        const auto level = std::max((baseLevelConstant - layer - 1) / static_cast<int>(D), 0);
+        deepest = std::max(deepest, level);
+        cells += std::ldexp(1.0, static_cast<int>(D) * level);
+    }
+
+    const auto levelBits = D * static_cast<unsigned int>(deepest + 1) + 1;
+    const auto prefixSumBits = static_cast<unsigned int>(std::ceil(std::log2(cells + 1.0)));
+    return std::max(levelBits, prefixSumBits);
+}
+
+/// cellIdBits(double, double, double) for the stored weights
+template<unsigned int D, typename WeightContainer>
+unsigned int cellIdBits(const WeightContainer& weights) {
+    auto w0 = std::numeric_limits<double>::infinity();
+    auto wn = 0.0;
+    auto W = 0.0;
+    for (auto w : weights) {
+        const auto stored = static_cast<double>(NodeStorage::weight(w));
+        w0 = std::min(w0, stored);
+        wn = std::max(wn, stored);
+        W += stored;
+    }
+    return cellIdBits<D>(w0, wn, W);
+}
+
+
+/// the largest dimension supported by dispatchSpatialTree()
+constexpr unsigned int kMaxSpatialTreeDimension = 10;
+
+/// dispatchSpatialTree() always uses 64 bit cell ids above this dimension (the 32 bit Morton codes cover only few levels)
+constexpr unsigned int kMaxNarrowCellDimension = 5;
+
+/**
+ * @brief
+ *  Selects the template arguments of SpatialTree for a run time dimension and weights.
+ *  Calls f(std::integral_constant<unsigned int, D>(), CellId()) with CellId uint32_t if the cell ids of the tree
+ *  fit into 32 bits (see cellIdBits()) and uint64_t otherwise.
+ *
+ * @return
+ *  false (without calling f) if the dimension is not in [1, kMaxSpatialTreeDimension].
+ */
+template<typename WeightContainer, typename Functor, unsigned int D = 1>
+bool dispatchSpatialTree(unsigned int dimension, const WeightContainer& weights, Functor&& f) {
+    if constexpr (D > kMaxSpatialTreeDimension) {
+        return false;
+    } else {
+        if (dimension != D)
+            return dispatchSpatialTree<WeightContainer, Functor, D + 1>(dimension, weights, std::forward<Functor>(f));
+
+        if constexpr (D > kMaxNarrowCellDimension) {
+            f(std::integral_constant<unsigned int, D>(), uint64_t());
+        } else {
+            if (cellIdBits<D>(weights) <= 32)
+                f(std::integral_constant<unsigned int, D>(), uint32_t());
+            else
+                f(std::integral_constant<unsigned int, D>(), uint64_t());
+        }
+        return true;
+    }
+}
+
 
 } // namespace girgs
 
@@ -1,26 +1,30 @@
 #include <girgs/IntSort.h>
 #include <girgs/ScopedTimer.h>
 #include <girgs/Helper.h>
+#include <girgs/TypeIKernel.h>
 
 
 namespace girgs {
 
 
-template<unsigned int D, typename EdgeCallback>
-SpatialTree<D, EdgeCallback>::SpatialTree(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions, double alpha, EdgeCallback& edgeCallback, bool profile)
+template<unsigned int D, typename EdgeCallback, typename CellId>
+template<typename WeightContainer, typename PositionContainer>
+SpatialTree<D, EdgeCallback, CellId>::SpatialTree(const WeightContainer& weights, const PositionContainer& positions, double alpha, EdgeCallback& edgeCallback, bool profile)
 : m_EdgeCallback(edgeCallback)
 , m_profile(profile)
 , m_alpha(alpha)
+, m_filter(alpha)
 , m_n(weights.size())
-, m_w0(*std::min_element(weights.begin(), weights.end()))
-, m_wn(*std::max_element(weights.begin(), weights.end()))
-, m_W(std::accumulate(weights.begin(), weights.end(), 0.0))
+, m_w0(NodeStorage::weight(*std::min_element(weights.begin(), weights.end()))) // the graph is sampled with the stored weights
+, m_wn(NodeStorage::weight(*std::max_element(weights.begin(), weights.end())))
+, m_W(std::accumulate(weights.begin(), weights.end(), 0.0, [] (double sum, double w) { return sum + NodeStorage::weight(w); }))
 , m_baseLevelConstant(static_cast<int>(std::log2(m_W/m_w0/m_w0))) // log2(W/w0^2)
 , m_layers(static_cast<unsigned int>(floor(std::log2(m_wn/m_w0)))+1)
 , m_levels(partitioningBaseLevel(0,0) + 1) // (log2(W/w0^2) - 2) / d
 {
-    assert(weights.size() == positions.size());
-    assert(positions.size() > 0 && positions.front().size() == D);
+    assert(weights.size() == numPoints(positions));
+    assert(numPoints(positions) > 0 && dimensionOf(positions) == D);
+    assert(cellIdBits<D>(m_w0, m_wn, m_W) <= 8 * sizeof(CellId)); // otherwise use 64 bit cell ids, see dispatchSpatialTree()
 
     ScopedTimer timer("Preprocessing", profile);
 
@@ -33,20 +37,42 @@ SpatialTree<D, EdgeCallback>::SpatialTree(const std::vector<double>& weights, co
     // sort weights into exponentially growing layers
     {
         ScopedTimer timer("Build DS", profile);
-        m_weight_layers = buildPartition(weights, positions);
+        m_partition = buildPartition(weights, positions);
     }
 }
 
 
-template<unsigned int D, typename EdgeCallback>
-void SpatialTree<D, EdgeCallback>::generateEdges(int seed) {
-
-    // one random generator and distribution for each thread
+template<unsigned int D, typename EdgeCallback, typename CellId>
+template<typename OtherCallback>
+SpatialTree<D, EdgeCallback, CellId>::SpatialTree(const SpatialTree<D, OtherCallback, CellId>& other, EdgeCallback& edgeCallback)
+: m_EdgeCallback(edgeCallback)
+, m_profile(other.m_profile)
+, m_alpha(other.m_alpha)
+, m_filter(other.m_filter)
+, m_n(other.m_n)
+, m_w0(other.m_w0)
+, m_wn(other.m_wn)
+, m_W(other.m_W)
+, m_baseLevelConstant(other.m_baseLevelConstant)
+, m_layers(other.m_layers)
+, m_levels(other.m_levels)
+, m_partition(other.m_partition)
+, m_layer_pairs(other.m_layer_pairs)
+{}
+
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::generateEdges(int seed, unsigned int shard, unsigned int numShards) {
+    assert(shard < numShards);
+
+    // all random numbers are derived from the seed and the position in the recursion, see randomStream()
     const auto num_threads = omp_get_max_threads();
-    m_gens.resize(num_threads);
-    for (int thread = 0; thread < num_threads; thread++) {
-        m_gens[thread].seed(seed >= 0 ? seed+thread : std::random_device()());
-    } 
+    m_seed = seed >= 0 ? static_cast<uint32_t>(seed) : std::random_device()();
+
+    // a shard only visits the cell pairs of its slice of the shard level, see shardsOfCell()
+    m_shard = shard;
+    m_num_shards = numShards;
+    m_shard_level = shardLevel(numShards);
 
 #ifndef NDEBUG
     // ensure that all node pairs are compared either type 1 or type 2
@@ -55,37 +81,63 @@ void SpatialTree<D, EdgeCallback>::generateEdges(int seed) {
 #endif // NDEBUG
 
     // sample all edges
-	if (num_threads == 1) { 
+    if (num_threads == 1) {
         // sequential
-		visitCellPair(0, 0, 0);
-		assert(m_type1_checks + m_type2_checks == m_n*(m_n - 1ll));
-		return;
+        visitCellPair(0, 0, 0);
+        assert(numShards > 1 || m_type1_checks + m_type2_checks == m_n*(m_n - 1ll));
+        return;
     }
 
-    // parallel see docs for visitCellPair_sequentialStart
-    const auto first_parallel_level = static_cast<unsigned int>(std::ceil(std::log2(4.0*num_threads) / D));
-    const auto parallel_cells = SpatialTreeCoordinateHelper<D>::numCellsInLevel(first_parallel_level);
-    const auto first_parallel_cell = SpatialTreeCoordinateHelper<D>::firstCellOfLevel(first_parallel_level);
-
-    // saw off recursion before "first_parallel_level" and save all calls that would be made
-    auto parallel_calls = std::vector<std::vector<unsigned int>>(parallel_cells);
-    visitCellPair_sequentialStart(0, 0, 0, first_parallel_level, parallel_calls);
-
-    // do the collected calls in parallel
-    #pragma omp parallel for schedule(static), num_threads(num_threads) // dynamic scheduling would be better but not reproducible
-    for (int i = 0; i < parallel_cells; ++i) {
-        auto current_cell = first_parallel_cell + i;
-        for (auto each : parallel_calls[i])
-            visitCellPair(current_cell, each, first_parallel_level);
+    // parallel: split every cell pair whose cost is at least a small fraction of the total cost (of this shard) into tasks
+    m_task_cost_threshold = cellPairCost(0, 0, 0) / (s_tasks_per_thread * num_threads * numShards);
+
+    #pragma omp parallel num_threads(num_threads)
+    #pragma omp single
+    visitCellPairTasks(0, 0, 0);
+
+    assert(numShards > 1 || m_type1_checks + m_type2_checks == m_n*(m_n - 1ll));
+}
+
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+unsigned int SpatialTree<D, EdgeCallback, CellId>::shardLevel(unsigned int numShards) const {
+    auto level = 0u;
+    while (level + 1 < m_levels && CoordinateHelper::numCellsInLevel(level) < static_cast<uint64_t>(s_cells_per_shard) * numShards)
+        ++level;
+    return level;
+}
+
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+std::pair<unsigned int, unsigned int> SpatialTree<D, EdgeCallback, CellId>::shardsOfCell(CellId cellA, unsigned int level) const {
+    // range of the cells on the shard level that are descendants (or the ancestor) of cellA
+    const auto index = static_cast<uint64_t>(cellA - CoordinateHelper::firstCellOfLevel(level));
+    auto first = index;
+    auto last = index;
+    if (level < m_shard_level) {
+        const auto shift = D * (m_shard_level - level);
+        first = index << shift;
+        last = ((index + 1) << shift) - 1;
+    } else {
+        first = last = index >> (D * (level - m_shard_level));
     }
 
-    assert(m_type1_checks + m_type2_checks == m_n*(m_n - 1ll));
+    // shard s owns the cells [s*cells/numShards, (s+1)*cells/numShards) of the shard level
+    const auto cells = static_cast<uint64_t>(CoordinateHelper::numCellsInLevel(m_shard_level));
+    return {static_cast<unsigned int>(first * m_num_shards / cells), static_cast<unsigned int>(last * m_num_shards / cells)};
 }
 
 
-template<unsigned int D, typename EdgeCallback>
-void SpatialTree<D, EdgeCallback>::visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level) {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::visitCellPair(CellId cellA, CellId cellB, unsigned int level) {
+    const auto shards = shardsOfCell(cellA, level);
+    if (m_shard < shards.first || shards.second < m_shard) // no cell pair of this shard below
+        return;
+    const auto ownPair = shards.first == m_shard;
+
     if(!CoordinateHelper::touching(cellA, cellB, level)) { // not touching
+        if (!ownPair)
+            return;
         // sample all type 2 occurrences with this cell pair
         #ifdef NDEBUG
 		if (m_alpha == std::numeric_limits<double>::infinity()) return; // dont trust compilter optimization
@@ -98,7 +150,7 @@ void SpatialTree<D, EdgeCallback>::visitCellPair(unsigned int cellA, unsigned in
 
     // sample all type 1 occurrences with this cell pair
     for(auto& layer_pair : m_layer_pairs[level]){
-        if(cellA != cellB || layer_pair.first <= layer_pair.second)
+        if(ownPair && (cellA != cellB || layer_pair.first <= layer_pair.second))
             sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
     }
 
@@ -108,140 +160,283 @@ void SpatialTree<D, EdgeCallback>::visitCellPair(unsigned int cellA, unsigned in
 
     // recursive call for all children pairs (a,b) where a in A and b in B
     // these will be type 1 if a and b touch or type 2 if they don't
-    for(auto a = CoordinateHelper::firstChild(cellA); a<=CoordinateHelper::lastChild(cellA); ++a)
-        for(auto b = cellA == cellB ? a : CoordinateHelper::firstChild(cellB); b<=CoordinateHelper::lastChild(cellB); ++b)
-            visitCellPair(a, b, level+1);
+    // pairs with an empty child contain no edges and are skipped
+    Children childrenA, childrenB;
+    const auto numA = nonEmptyChildren(cellA, level, childrenA);
+    const auto numB = cellA == cellB ? numA : nonEmptyChildren(cellB, level, childrenB);
+    const auto& candidatesB = cellA == cellB ? childrenA : childrenB;
+    for(auto ia = 0u; ia < numA; ++ia)
+        for(auto ib = cellA == cellB ? ia : 0u; ib < numB; ++ib)
+            visitCellPair(childrenA[ia], candidatesB[ib], level+1);
 }
 
 
 
-template<unsigned int D, typename EdgeCallback>
-void SpatialTree<D, EdgeCallback>::visitCellPair_sequentialStart(unsigned int cellA, unsigned int cellB, unsigned int level,
-                                                   unsigned int first_parallel_level,
-                                                   std::vector<std::vector<unsigned int>> &parallel_calls) {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::visitCellPairTasks(CellId cellA, CellId cellB, unsigned int level) {
     if(!CoordinateHelper::touching(cellA, cellB, level)) { // not touching
-        // sample all type 2 occurrences with this cell pair
-        #ifdef NDEBUG
-		if (m_alpha == std::numeric_limits<double>::infinity()) return; // dont trust compilter optimization
-        #endif // NDEBUG
-        for(auto l=level; l<m_levels; ++l)
-            for(auto& layer_pair : m_layer_pairs[l])
-                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
+        // type 2 jobs are cheap (expected linear in the number of edges), no need to split them
+        visitCellPair(cellA, cellB, level);
         return;
     }
 
+    const auto shards = shardsOfCell(cellA, level);
+    if (m_shard < shards.first || shards.second < m_shard) // no cell pair of this shard below
+        return;
+
     // sample all type 1 occurrences with this cell pair
     for(auto& layer_pair : m_layer_pairs[level]){
-        if(cellA != cellB || layer_pair.first <= layer_pair.second)
-            sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
+        if(shards.first == m_shard && (cellA != cellB || layer_pair.first <= layer_pair.second))
+            sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, true);
     }
 
     // break if last level reached
-    if (level == m_levels - 1) // if we are at the last level we don't need recursive calls
+    if(level == m_levels-1) // if we are at the last level we don't need recursive calls
         return;
 
-    // recursive call for all children pairs (a,b) where a in A and b in B
-    // these will be type 1 if a and b touch or type 2 if they don't
-    for(auto a = CoordinateHelper::firstChild(cellA); a<=CoordinateHelper::lastChild(cellA); ++a)
-        for(auto b = cellA == cellB ? a : CoordinateHelper::firstChild(cellB); b<=CoordinateHelper::lastChild(cellB); ++b){
-            if(level+1 == first_parallel_level)
-                parallel_calls[a-CoordinateHelper::firstCellOfLevel(first_parallel_level)].push_back(b);
-            else
-                visitCellPair_sequentialStart(a, b, level+1, first_parallel_level, parallel_calls);
+    // spawn a task for all children pairs (a,b) where a in A and b in B; expensive ones are split further
+    Children childrenA, childrenB;
+    const auto numA = nonEmptyChildren(cellA, level, childrenA);
+    const auto numB = cellA == cellB ? numA : nonEmptyChildren(cellB, level, childrenB);
+    const auto& candidatesB = cellA == cellB ? childrenA : childrenB;
+    for(auto ia = 0u; ia < numA; ++ia)
+        for(auto ib = cellA == cellB ? ia : 0u; ib < numB; ++ib) {
+            const auto a = childrenA[ia];
+            const auto b = candidatesB[ib];
+            const auto shardsOfChild = shardsOfCell(a, level+1);
+            if (m_shard < shardsOfChild.first || shardsOfChild.second < m_shard)
+                continue;
+
+            const auto cost = cellPairCost(a, b, level+1);
+            if (cost == 0) // one of the cells is empty in all relevant layers
+                continue;
+
+            if (cost >= m_task_cost_threshold) {
+                #pragma omp task
+                visitCellPairTasks(a, b, level+1);
+            } else {
+                #pragma omp task
+                visitCellPair(a, b, level+1);
+            }
         }
 }
 
 
+template<unsigned int D, typename EdgeCallback, typename CellId>
+unsigned int SpatialTree<D, EdgeCallback, CellId>::nonEmptyChildren(CellId cell, unsigned int level, Children& children) const {
+    // the children of the k-th cell of level are the cells k*2^D, ..., (k+1)*2^D-1 of level+1
+    const auto& bits = m_partition->non_empty[level+1];
+    const auto begin = static_cast<uint64_t>(cell - CoordinateHelper::firstCellOfLevel(level)) << D;
+    const auto firstOfLevel = CoordinateHelper::firstCellOfLevel(level+1);
+
+    auto count = 0u;
+    for (auto offset = 0u; offset < CoordinateHelper::numChildren(); offset += 64) {
+        const auto index = begin + offset;
+        auto word = bits[index / 64] >> (index % 64);
+        if (CoordinateHelper::numChildren() < 64)
+            word &= (uint64_t{1} << CoordinateHelper::numChildren()) - 1;
+        for (; word; word &= word - 1)
+            children[count++] = firstOfLevel + static_cast<CellId>(index + __builtin_ctzll(word));
+    }
+    return count;
+}
 
-template<unsigned int D, typename EdgeCallback>
-void SpatialTree<D, EdgeCallback>::sampleTypeI(
-        unsigned int cellA, unsigned int cellB, unsigned int level,
-        unsigned int i, unsigned int j)
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::markNonEmptyCells(SpatialTreePartition<D, CellId>& partition) const {
+    // a cell contains points of a layer accessed on its level if one of its children does (these layers are accessed
+    // on the level of the children as well) or if it contains points of a layer whose target level is its level;
+    // on the deepest level, all layers with a target level at least as deep count
+    auto& non_empty = partition.non_empty;
+    non_empty.resize(m_levels);
+    for (auto level = m_levels; level-- > 0;) {
+        const auto cells = static_cast<uint64_t>(CoordinateHelper::numCellsInLevel(level));
+        const auto first = CoordinateHelper::firstCellOfLevel(level);
+        const auto deepest = level + 1 == m_levels;
+
+        auto layers = std::vector<const WeightLayer<D, CellId>*>();
+        for (auto& layer : partition.weight_layers)
+            if (layer.targetLevel() == level || (deepest && layer.targetLevel() > level))
+                layers.push_back(&layer);
+
+        auto& bits = non_empty[level];
+        bits.assign((cells + 63) / 64, 0);
+        const auto* children = deepest ? nullptr : non_empty[level+1].data();
+
+        #pragma omp parallel for schedule(static)
+        for (long long w = 0; w < static_cast<long long>(bits.size()); ++w) {
+            uint64_t word = 0;
+            for (auto bit = 0u; bit < 64 && w * 64 + bit < cells; ++bit) {
+                const auto index = static_cast<uint64_t>(w) * 64 + bit;
+
+                auto any = false;
+                if (children) {
+                    const auto begin = index << D;
+                    for (auto offset = 0u; !any && offset < CoordinateHelper::numChildren(); offset += 64) {
+                        auto childWord = children[(begin + offset) / 64] >> ((begin + offset) % 64);
+                        if (CoordinateHelper::numChildren() < 64)
+                            childWord &= (uint64_t{1} << CoordinateHelper::numChildren()) - 1;
+                        any = childWord != 0;
+                    }
+                }
+                for (auto it = layers.begin(); !any && it != layers.end(); ++it)
+                    any = (*it)->pointsInCell(first + static_cast<CellId>(index), level) > 0;
+
+                word |= uint64_t{any} << bit;
+            }
+            bits[w] = word;
+        }
+    }
+}
+
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+double SpatialTree<D, EdgeCallback, CellId>::cellPairCost(CellId cellA, CellId cellB, unsigned int level) const {
+    // layers with a target level above level are not accessed in this cell pair or its descendants
+    auto pointsA = 0.0;
+    auto pointsB = 0.0;
+    for (auto& layer : m_partition->weight_layers) {
+        if (layer.targetLevel() < level)
+            continue;
+        pointsA += layer.pointsInCell(cellA, level);
+        pointsB += layer.pointsInCell(cellB, level);
+    }
+    return pointsA * pointsB;
+}
+
+
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::sampleTypeI(
+        CellId cellA, CellId cellB, unsigned int level,
+        unsigned int i, unsigned int j, bool spawnTasks)
 {
     assert(partitioningBaseLevel(i, j) == level || !CoordinateHelper::touching(cellA, cellB, level)); // in this case we were redirected from typeII with maxProb==1.0
 
-    auto rangeA = m_weight_layers[i].cellIterators(cellA, level);
-    auto rangeB = m_weight_layers[j].cellIterators(cellB, level);
+    auto rangeA = m_partition->weight_layers[i].cellRange(cellA, level);
+    auto rangeB = m_partition->weight_layers[j].cellRange(cellB, level);
 
     if (rangeA.first == rangeA.second || rangeB.first == rangeB.second)
         return;
 
+    const auto sizeV_i_A = static_cast<long long>(rangeA.second - rangeA.first);
+    const auto sizeV_j_B = static_cast<long long>(rangeB.second - rangeB.first);
 
 #ifndef NDEBUG
-    {
-        const auto sizeV_i_A = std::distance(rangeA.first, rangeA.second);
-        const auto sizeV_j_B = std::distance(rangeB.first, rangeB.second);
+    #pragma omp atomic
+    m_type1_checks += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1)  // all pairs in AxA without {v,v}
+                                                 : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
+#endif // NDEBUG
+
+    const auto num_pairs = (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1) / 2 : sizeV_i_A * sizeV_j_B;
 
-        #pragma omp atomic
-        m_type1_checks += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1)  // all pairs in AxA without {v,v}
-                                                     : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
+    if (!spawnTasks || num_pairs < 2 * s_type1_chunk) {
+        sampleTypeIRows(cellA, cellB, level, i, j, 0, sizeV_i_A);
+        return;
     }
-#endif // NDEBUG
 
-    std::uniform_real_distribution<> dist;
-    const auto threadId = omp_get_thread_num();
+    // split the rows into chunks of roughly s_type1_chunk pairs each
+    const auto rows_per_chunk = std::max<long long>(1, s_type1_chunk / sizeV_j_B);
+    for (long long row = 0; row < sizeV_i_A; row += rows_per_chunk) {
+        const auto rowEnd = std::min<long long>(row + rows_per_chunk, sizeV_i_A);
+        #pragma omp task
+        sampleTypeIRows(cellA, cellB, level, i, j, row, rowEnd);
+    }
+}
 
-    const auto inThresholdMode = m_alpha == std::numeric_limits<double>::infinity();
 
-    int kA = 0;
-    for(auto pointerA = rangeA.first; pointerA != rangeA.second; ++kA, ++pointerA) {
-        auto offset = (cellA == cellB && i==j) ? kA+1 : 0;
-        for (auto pointerB = rangeB.first + offset; pointerB != rangeB.second; ++pointerB) {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::sampleTypeIRows(
+        CellId cellA, CellId cellB, unsigned int level,
+        unsigned int i, unsigned int j, long long rowBegin, long long rowEnd)
+{
+    const auto& nodes = m_partition->nodes;
+    const auto rangeA = m_partition->weight_layers[i].cellRange(cellA, level);
+    const auto rangeB = m_partition->weight_layers[j].cellRange(cellB, level);
+    const auto sizeV_j_B = static_cast<long long>(rangeB.second - rangeB.first);
+    const auto triangular = (cellA == cellB && i == j);
+    assert(0 <= rowBegin && rowBegin <= rowEnd && rowEnd <= rangeA.second - rangeA.first);
+
+#ifndef NDEBUG
+    // points are in correct cells and weight layers
+    for (auto a = rangeA.first + rowBegin; a < rangeA.first + rowEnd; ++a) {
+        assert(cellA - CoordinateHelper::firstCellOfLevel(level) == CoordinateHelper::cellForPoint(nodes.position(a), level));
+        assert(i == static_cast<unsigned int>(std::log2(nodes.weights[a]/m_w0)));
+    }
+    for (auto b = rangeB.first; b < rangeB.second; ++b) {
+        assert(cellB - CoordinateHelper::firstCellOfLevel(level) == CoordinateHelper::cellForPoint(nodes.position(b), level));
+        assert(j == static_cast<unsigned int>(std::log2(nodes.weights[b]/m_w0)));
+    }
+#endif // NDEBUG
 
-            const auto& nodeInA = *pointerA;
-            const auto& nodeInB = *pointerB;
+    const auto threadId = omp_get_thread_num();
+    const auto inThresholdMode = m_alpha == std::numeric_limits<double>::infinity();
 
-			// pointer magic gives same results
-			assert(nodeInA.index == m_weight_layers[i].kthPoint(cellA, level, kA).index);
-			assert(nodeInB.index == m_weight_layers[j].kthPoint(cellB, level, std::distance(rangeB.first, pointerB)).index);
+    // each pair consumes one random number, so skip the numbers of all rows before rowBegin
+    auto gen = randomStream(cellA, cellB, i, j);
+    if (!inThresholdMode && rowBegin > 0)
+        gen.seek(triangular ? rowBegin * sizeV_j_B - rowBegin * (rowBegin + 1) / 2 : rowBegin * sizeV_j_B);
 
-            // points are in correct cells
-            assert(cellA - CoordinateHelper::firstCellOfLevel(level) == CoordinateHelper::cellForPoint(nodeInA.coord, level));
-            assert(cellB - CoordinateHelper::firstCellOfLevel(level) == CoordinateHelper::cellForPoint(nodeInB.coord, level));
+    // the kernels compare one node in A with a range of nodes in B; in the binomial case block-wise
+    constexpr auto block_size = 256u;
+    std::array<double, block_size> ratios;
 
-            // points are in correct weight layer
-            assert(i == static_cast<unsigned int>(std::log2(nodeInA.weight/m_w0)));
-            assert(j == static_cast<unsigned int>(std::log2(nodeInB.weight/m_w0)));
+    dispatchTypeIKernel<D>([&] (auto kernel) {
+        using Kernel = decltype(kernel);
 
-            assert(nodeInA.index != nodeInB.index);
-            const auto distance = nodeInA.distance(nodeInB);
-            const auto w_term = nodeInA.weight*nodeInB.weight/m_W;
-            const auto d_term = pow_to_the<D>(distance);
+        for(std::size_t a = rangeA.first + rowBegin; a < rangeA.first + rowEnd; ++a) {
+            const auto coordA = nodes.coord(a);
+            const double weightA = nodes.weights[a];
+            const auto indexA = nodes.indices[a];
+            const std::size_t firstB = triangular ? a + 1 : rangeB.first;
 
             if(inThresholdMode) {
-                if(d_term < w_term)
-                    m_EdgeCallback(nodeInA.index, nodeInB.index, threadId);
-            } else {
-                auto edge_prob = std::pow(w_term/d_term, m_alpha); // we don't need min with 1.0 here
-                if(dist(m_gens[threadId]) < edge_prob)
-                    m_EdgeCallback(nodeInA.index, nodeInB.index, threadId);
+                Kernel::threshold(coordA, weightA, m_W, nodes, firstB, rangeB.second, [&] (std::size_t b) {
+                    m_EdgeCallback(indexA, nodes.indices[b], threadId);
+                });
+                continue;
+            }
+
+            for (auto blockBegin = firstB; blockBegin < rangeB.second; blockBegin += block_size) {
+                const auto blockEnd = std::min<std::size_t>(blockBegin + block_size, rangeB.second);
+                Kernel::ratios(coordA, weightA, m_W, nodes, blockBegin, blockEnd, ratios.data());
+                for (auto b = blockBegin; b < blockEnd; ++b) {
+                    // edge iff rnd < ratio^alpha; the filter decides almost all pairs without pow
+                    const auto ratio = ratios[b - blockBegin];
+                    const auto rnd = gen.uniform();
+                    if (ratio <= m_filter.ratioForProb_lowerBound(rnd))
+                        continue;
+                    if (ratio >= m_filter.ratioForProb_upperBound(rnd) || rnd < std::pow(ratio, m_alpha)) // we don't need min with 1.0 here
+                        m_EdgeCallback(indexA, nodes.indices[b], threadId);
+                }
             }
         }
-    }
+    });
 }
 
 
-template<unsigned int D, typename EdgeCallback>
-void SpatialTree<D, EdgeCallback>::sampleTypeII(
-        unsigned int cellA, unsigned int cellB, unsigned int level,
+template<unsigned int D, typename EdgeCallback, typename CellId>
+void SpatialTree<D, EdgeCallback, CellId>::sampleTypeII(
+        CellId cellA, CellId cellB, unsigned int level,
         unsigned int i, unsigned int j)
 {
     assert(partitioningBaseLevel(i, j) >= level);
 
-    auto rangeA = m_weight_layers[i].cellIterators(cellA, level);
-    auto rangeB = m_weight_layers[j].cellIterators(cellB, level);
+    const auto& nodes = m_partition->nodes;
+    auto rangeA = m_partition->weight_layers[i].cellRange(cellA, level);
+    auto rangeB = m_partition->weight_layers[j].cellRange(cellB, level);
 
     if (rangeA.first == rangeA.second || rangeB.first == rangeB.second)
         return;
 
-    const auto sizeV_i_A = std::distance(rangeA.first, rangeA.second);
-    const auto sizeV_j_B = std::distance(rangeB.first, rangeB.second);
+    const auto sizeV_i_A = static_cast<long long>(rangeA.second - rangeA.first);
+    const auto sizeV_j_B = static_cast<long long>(rangeB.second - rangeB.first);
 
     // get upper bound for probability
     const auto w_upper_bound = m_w0*(1<<(i+1)) * m_w0*(1<<(j+1)) / m_W;
     const auto cell_distance = CoordinateHelper::dist(cellA, cellB, level);
     const auto dist_lower_bound = pow_to_the<D>(cell_distance);
-    const auto max_connection_prob = std::min(std::pow(w_upper_bound/dist_lower_bound, m_alpha), 1.0);
+    const auto max_ratio = w_upper_bound/dist_lower_bound;
+    const auto max_connection_prob = std::min(std::pow(max_ratio, m_alpha), 1.0);
     assert(dist_lower_bound > w_upper_bound); // in threshold model we would not sample anything
     const auto num_pairs = sizeV_i_A * sizeV_j_B;
     const auto expected_samples = num_pairs * max_connection_prob;
@@ -261,43 +456,49 @@ void SpatialTree<D, EdgeCallback>::sampleTypeII(
     if(expected_samples < 1e-6)
         return;
 
-    // init geometric distribution
+    // init geometric distribution (number of failures before the next success) by inversion
     auto threadId = omp_get_thread_num();
-    auto& gen = m_gens[threadId];
-    auto geo = std::geometric_distribution<unsigned long long>(max_connection_prob);
-    auto dist = std::uniform_real_distribution<>(0, max_connection_prob);
+    auto gen = randomStream(cellA, cellB, i, j);
+    const auto inv_log_fail = 1.0 / std::log1p(-max_connection_prob);
+    auto geo = [&] { return std::floor(std::log1p(-gen.uniform()) * inv_log_fail); };
 
-    for (auto r = geo(gen); r < num_pairs; r += 1 + geo(gen)) {
+    // r is kept as double since a skip may exceed the range of integers for tiny probabilities
+    for (auto rd = geo(); rd < num_pairs; rd += 1 + geo()) {
         // determine the r-th pair
-        const Node<D>& nodeInA = rangeA.first[r%sizeV_i_A];
-        const Node<D>& nodeInB = rangeB.first[r/sizeV_i_A];
+        const auto r = static_cast<long long>(rd);
+        const auto nodeInA = rangeA.first + r%sizeV_i_A;
+        const auto nodeInB = rangeB.first + r/sizeV_i_A;
 
-        nodeInB.prefetch();
-        nodeInA.prefetch();
+        nodes.prefetch(nodeInB);
+        nodes.prefetch(nodeInA);
 
         // points are in correct weight layer
-        assert(i == static_cast<unsigned int>(std::log2(nodeInA.weight/m_w0)));
-        assert(j == static_cast<unsigned int>(std::log2(nodeInB.weight/m_w0)));
+        assert(i == static_cast<unsigned int>(std::log2(nodes.weights[nodeInA]/m_w0)));
+        assert(j == static_cast<unsigned int>(std::log2(nodes.weights[nodeInB]/m_w0)));
 
-        const auto rnd = dist(gen);
+        const auto uniform = gen.uniform();
+        const auto rnd = uniform * max_connection_prob;
 
-        // get actual connection probability
-        const auto distance = nodeInA.distance(nodeInB);
-        const auto w_term = nodeInA.weight*nodeInB.weight/m_W;
+        // get actual ratio
+        const auto distance = nodes.distance(nodeInA, nodeInB);
+        const auto w_term = static_cast<double>(nodes.weights[nodeInA])*nodes.weights[nodeInB]/m_W;
         const auto d_term = pow_to_the<D>(distance);
-        const auto connection_prob = std::pow(w_term/d_term, m_alpha); // we don't need min with 1.0 here
+        const auto ratio = w_term/d_term;
         assert(w_term < w_upper_bound);
         assert(d_term >= dist_lower_bound);
 
-        if(rnd < connection_prob) {
-            m_EdgeCallback(nodeInA.index, nodeInB.index, threadId);
+        // rnd < ratio^alpha iff uniform < (ratio/max_ratio)^alpha; use the filter before computing the connection probability
+        if (ratio <= max_ratio * m_filter.ratioForProb_lowerBound(uniform))
+            continue;
+        if (ratio >= max_ratio * m_filter.ratioForProb_upperBound(uniform) || rnd < std::pow(ratio, m_alpha)) { // we don't need min with 1.0 here
+            m_EdgeCallback(nodes.indices[nodeInA], nodes.indices[nodeInB], threadId);
         }
     }
 }
 
 
-template<unsigned int D, typename EdgeCallback>
-unsigned int SpatialTree<D, EdgeCallback>::weightLayerTargetLevel(int layer) const {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+unsigned int SpatialTree<D, EdgeCallback, CellId>::weightLayerTargetLevel(int layer) const {
     // -1 coz w0 is the upper bound for layer 0 in paper and our layers are shifted by -1
     auto result = std::max((m_baseLevelConstant - layer - 1) / (int)D, 0);
 #ifndef NDEBUG
@@ -315,8 +516,8 @@ unsigned int SpatialTree<D, EdgeCallback>::weightLayerTargetLevel(int layer) con
 }
 
 
-template<unsigned int D, typename EdgeCallback>
-unsigned int SpatialTree<D, EdgeCallback>::partitioningBaseLevel(int layer1, int layer2) const {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+unsigned int SpatialTree<D, EdgeCallback, CellId>::partitioningBaseLevel(int layer1, int layer2) const {
 
     // we do the computation on signed ints but cast back after the max with 0
     // m_baseLevelConstant is just log(W/w0^2)
@@ -335,19 +536,20 @@ unsigned int SpatialTree<D, EdgeCallback>::partitioningBaseLevel(int layer1, int
     return static_cast<unsigned int>(result);
 }
 
-template<unsigned int D, typename EdgeCallback>
-std::vector<WeightLayer<D>> SpatialTree<D, EdgeCallback>::buildPartition(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions) {
+template<unsigned int D, typename EdgeCallback, typename CellId>
+template<typename WeightContainer, typename PositionContainer>
+std::shared_ptr<const SpatialTreePartition<D, CellId>> SpatialTree<D, EdgeCallback, CellId>::buildPartition(const WeightContainer& weights, const PositionContainer& positions) {
 
     const auto n = weights.size();
-    assert(positions.size() == n);
+    assert(numPoints(positions) == n);
 
     auto weight_to_layer = [=] (double weight) {
         return std::log2(weight / m_w0);
     };
 
     const auto first_cell_of_layer = [&] {
-        std::vector<unsigned int> first_cell_of_layer(m_layers + 1);
-        unsigned int sum = 0;
+        std::vector<CellId> first_cell_of_layer(m_layers + 1);
+        CellId sum = 0;
         for (auto l = 0; l < m_layers; ++l) {
             first_cell_of_layer[l] = sum;
             sum += CoordinateHelper::numCellsInLevel(weightLayerTargetLevel(l));
@@ -358,18 +560,34 @@ std::vector<WeightLayer<D>> SpatialTree<D, EdgeCallback>::buildPartition(const s
     const auto max_cell_id = first_cell_of_layer.back();
 
     // Node<D> should incur no init overhead; checked on godbolt
-    m_nodes = std::vector<Node<D>>(n); 
+    using FullNode = Node<D, NodeStorage, CellId>;
+#ifdef USE_INPLACE_SORT
+    // Only the cells and indices are sorted, and the columns are filled from the input afterwards,
+    // so that no array of nodes exists next to the columns (which are about as large).
+    struct SortNode {
+        CellId cell_id;
+        NodeIndex index;
+    };
+#else
+    using SortNode = FullNode;
+#endif
+    auto nodes = std::vector<SortNode>(n);
     // compute the cell a point belongs to
     {
         ScopedTimer timer("Classify points & precompute coordinates", m_profile);
 
         #pragma omp parallel for
-        for (int i = 0; i < n; ++i) {
-            const auto layer = weight_to_layer(weights[i]);
+        for (NodeIndex i = 0; i < static_cast<NodeIndex>(n); ++i) {
+            auto node = FullNode(coordinatesOf<D>(positions, i), weights[i], i);
+            const auto layer = weight_to_layer(node.weight);
             const auto level = weightLayerTargetLevel(layer);
-            m_nodes[i] = Node<D>(positions[i], weights[i], i);
-            m_nodes[i].cell_id = first_cell_of_layer[layer] + CoordinateHelper::cellForPoint(m_nodes[i].coord, level);
-            assert(m_nodes[i].cell_id < max_cell_id);
+            node.cell_id = first_cell_of_layer[layer] + CoordinateHelper::cellForPoint(node.position(), level);
+            assert(node.cell_id < max_cell_id);
+#ifdef USE_INPLACE_SORT
+            nodes[i] = SortNode{node.cell_id, node.index};
+#else
+            nodes[i] = node;
+#endif
         }
     }
 
@@ -377,31 +595,35 @@ std::vector<WeightLayer<D>> SpatialTree<D, EdgeCallback>::buildPartition(const s
     {
         ScopedTimer timer("Sort points", m_profile);
 
-        auto compare = [](const Node<D> &a, const Node<D> &b) { return a.cell_id < b.cell_id; };
+        auto compare = [](const SortNode &a, const SortNode &b) { return a.cell_id < b.cell_id; };
 
-        intsort::intsort(m_nodes, [](const Node<D> &p) { return p.cell_id; }, max_cell_id);
-        //alternatively: std::sort(m_nodes.begin(), m_nodes.end(), compare);
+        // nodes are created in the order of their indices, so the stable sort (and thus the graph) does not depend on the method
+        intsort::intsort_stable(nodes, [](const SortNode &p) { return p.cell_id; }, max_cell_id,
+                                [](const SortNode &a, const SortNode &b) { return a.index < b.index; });
+        //alternatively: std::stable_sort(nodes.begin(), nodes.end(), compare);
 
-        assert(std::is_sorted(m_nodes.begin(), m_nodes.end(), compare));
+        assert(std::is_sorted(nodes.begin(), nodes.end(), compare));
     }
 
 
     // compute pointers into points
-    constexpr auto gap_cell_indicator = std::numeric_limits<unsigned int>::max();
-    m_first_in_cell = std::vector<unsigned int>(max_cell_id + 1, gap_cell_indicator);
+    auto partition = std::make_shared<SpatialTreePartition<D, CellId>>();
+    auto& first_in_cell = partition->first_in_cell;
+    constexpr auto gap_cell_indicator = std::numeric_limits<NodeOffset>::max();
+    first_in_cell = std::vector<NodeOffset>(max_cell_id + 1, gap_cell_indicator);
     {
         ScopedTimer timer("Find first point in cell", m_profile);
 
-        m_first_in_cell[max_cell_id] = n;
+        first_in_cell[max_cell_id] = n;
 
         // First, we mark the begin of cells that actually contain points
         // and repair the gaps (i.e., empty cells) later. In the mean time,
         // the values of those gaps will remain at gap_cell_indicator.
-        m_first_in_cell[m_nodes[0].cell_id] = 0;
+        first_in_cell[nodes[0].cell_id] = 0;
         #pragma omp parallel for
-        for (int i = 1; i < n; ++i) {
-            if (m_nodes[i - 1].cell_id != m_nodes[i].cell_id) {
-                m_first_in_cell[m_nodes[i].cell_id] = i;
+        for (NodeIndex i = 1; i < static_cast<NodeIndex>(n); ++i) {
+            if (nodes[i - 1].cell_id != nodes[i].cell_id) {
+                first_in_cell[nodes[i].cell_id] = i;
             }
         }
 
@@ -423,10 +645,10 @@ std::vector<WeightLayer<D>> SpatialTree<D, EdgeCallback>::buildPartition(const s
             {
                 for (int r = 0; r < threads; r++) {
                     const auto end = std::min(max_cell_id, chunk_size * (r + 1));
-                    int first_non_invalid = end - 1;
-                    while (m_first_in_cell[first_non_invalid] == gap_cell_indicator)
+                    auto first_non_invalid = end - 1;
+                    while (first_in_cell[first_non_invalid] == gap_cell_indicator)
                         first_non_invalid++;
-                    m_first_in_cell[end - 1] = m_first_in_cell[first_non_invalid];
+                    first_in_cell[end - 1] = first_in_cell[first_non_invalid];
                 }
             }
 
@@ -434,43 +656,64 @@ std::vector<WeightLayer<D>> SpatialTree<D, EdgeCallback>::buildPartition(const s
 
             auto i = std::min(max_cell_id, begin + chunk_size);
             while (i-- > begin) {
-                m_first_in_cell[i] = std::min(
-                    m_first_in_cell[i],
-                    m_first_in_cell[i + 1]);
+                first_in_cell[i] = std::min(
+                    first_in_cell[i],
+                    first_in_cell[i + 1]);
             }
         }
 
         #ifndef NDEBUG
         {
-            assert(m_nodes[n-1].cell_id < max_cell_id);
+            assert(nodes[n-1].cell_id < max_cell_id);
 
             // assert that we have a prefix sum starting at 0 and ending in n
-            assert(m_first_in_cell[0] == 0);
-            assert(m_first_in_cell[max_cell_id] == n);
-            assert(std::is_sorted(m_first_in_cell.begin(), m_first_in_cell.end()));
+            assert(first_in_cell[0] == 0);
+            assert(first_in_cell[max_cell_id] == n);
+            assert(std::is_sorted(first_in_cell.begin(), first_in_cell.end()));
 
             // check that each point is in its right cell (and that the cell boundaries are correct)
-            for (auto cid = 0u; cid != max_cell_id; ++cid) {
-                const auto begin = m_first_in_cell[cid];
-                const auto end = m_first_in_cell[cid + 1];
+            for (CellId cid = 0; cid != max_cell_id; ++cid) {
+                const auto begin = first_in_cell[cid];
+                const auto end = first_in_cell[cid + 1];
                 for (auto idx = begin; idx != end; ++idx)
-                    assert(m_nodes[idx].cell_id == cid);
+                    assert(nodes[idx].cell_id == cid);
             }
         }
         #endif
     }
 
+    // the sampling kernels work on a structure of arrays; the array of structs is released at the end of this function
+    {
+        ScopedTimer timer("Transpose nodes", m_profile);
+#ifdef USE_INPLACE_SORT
+        auto& columns = partition->nodes;
+        columns = NodeColumns<D>(n);
+        #pragma omp parallel for
+        for (NodeIndex k = 0; k < static_cast<NodeIndex>(n); ++k) {
+            const auto i = nodes[k].index;
+            columns.set(k, FullNode(coordinatesOf<D>(positions, i), weights[i], i));
+        }
+#else
+        partition->nodes = NodeColumns<D>(nodes);
+#endif
+    }
+
     // build spatial structure and find insertion level for each layer based on lower bound on radius for current and smallest layer
-    std::vector<WeightLayer<D>> weight_layers;
+    auto& weight_layers = partition->weight_layers;
     weight_layers.reserve(m_layers);
     {
         ScopedTimer timer("Build data structure", m_profile);
         for (auto layer = 0u; layer < m_layers; ++layer) {
-            weight_layers.emplace_back(weightLayerTargetLevel(layer), m_nodes.data(), m_first_in_cell.data() + first_cell_of_layer[layer]);
+            weight_layers.emplace_back(weightLayerTargetLevel(layer), first_in_cell.data() + first_cell_of_layer[layer]);
         }
     }
 
-    return weight_layers;
+    {
+        ScopedTimer timer("Mark non-empty cells", m_profile);
+        markNonEmptyCells(*partition);
+    }
+
+    return partition;
 }
 
 
@@ -1,11 +1,22 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace girgs {
 
 
-template<unsigned int D>
+/**
+ * @brief
+ *  Index arithmetic of the complete 2^D-ary tree of cells. Cells of all levels are numbered consecutively
+ *  (root 0, then level 1, ...) and in Morton order within a level.
+ *
+ * @tparam D
+ *  the dimension of the geometry
+ * @tparam CellId
+ *  uint32_t or uint64_t. Cell ids of levels up to l require D*(l+1) < 8*sizeof(CellId) bits.
+ */
+template<unsigned int D, typename CellId = uint32_t>
 class SpatialTreeCoordinateHelper
 {
 public:
@@ -13,36 +24,36 @@ public:
         return 1u<<D;
     }
 
-    static constexpr unsigned int numCellsInLevel(unsigned int level) noexcept {
-        return 1u<<(D*level);
+    static constexpr CellId numCellsInLevel(unsigned int level) noexcept {
+        return CellId{1}<<(D*level);
     }
 
-    static constexpr unsigned int firstCellOfLevel(unsigned int level) noexcept {
-        return ((1u<<(D*level))-1)/(numChildren()-1);
+    static constexpr CellId firstCellOfLevel(unsigned int level) noexcept {
+        return ((CellId{1}<<(D*level))-1)/(numChildren()-1);
     }
 
-    static constexpr unsigned int parent(unsigned int cell) noexcept {
+    static constexpr CellId parent(CellId cell) noexcept {
         return (cell-1) / numChildren();
     }
 
-    static constexpr unsigned int firstChild(unsigned int cell) noexcept {
+    static constexpr CellId firstChild(CellId cell) noexcept {
         return numChildren() * cell + 1;
     }
 
-    static constexpr unsigned int lastChild(unsigned int cell) noexcept {
+    static constexpr CellId lastChild(CellId cell) noexcept {
         return firstChild(cell) + numChildren() - 1;
     }
 
 
-    static unsigned int cellOfLevel(unsigned cell) noexcept;
+    static CellId cellOfLevel(CellId cell) noexcept;
 
-    static unsigned int cellForPoint(const std::array<double, D>& position, unsigned int targetLevel) noexcept;
+    static CellId cellForPoint(const std::array<double, D>& position, unsigned int targetLevel) noexcept;
 
-    static std::array<std::pair<double,double>, D> bounds(unsigned int cell, unsigned int level) noexcept;
+    static std::array<std::pair<double,double>, D> bounds(CellId cell, unsigned int level) noexcept;
 
-    static bool touching(unsigned int cellA, unsigned int cellB, unsigned int level) noexcept;
+    static bool touching(CellId cellA, CellId cellB, unsigned int level) noexcept;
 
-    static double dist(unsigned int cellA, unsigned int cellB, unsigned int level) noexcept;
+    static double dist(CellId cellA, CellId cellB, unsigned int level) noexcept;
 
     SpatialTreeCoordinateHelper() = delete; // we want to support static accesses only
 };
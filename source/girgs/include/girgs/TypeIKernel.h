@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include <girgs/girgs_api.h>
+#include <girgs/Helper.h>
+#include <girgs/NodeColumns.h>
+
+// Load implementations; the vectorized kernels are compiled on x86-64 with gcc or clang
+// for their instruction set only and are used if the cpu supports it (see typeIKernel())
+#include <girgs/TypeIKernelGeneric.inl>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define GIRGS_HAS_AVX_KERNELS
+    // avx512f implies fma, and gcc would fuse the products and sums of the kernels into multiply-adds that
+    // round differently than the generic kernels; clang contracts only within an expression, never across intrinsics
+    #ifdef __clang__
+        #define GIRGS_TARGET_AVX2 __attribute__((target("avx2")))
+        #define GIRGS_TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+    #else
+        #define GIRGS_TARGET_AVX2 __attribute__((target("avx2"), optimize("fp-contract=off")))
+        #define GIRGS_TARGET_AVX512 __attribute__((target("avx2,avx512f"), optimize("fp-contract=off")))
+    #endif
+    #include <girgs/TypeIKernelAVX2.inl>
+    #include <girgs/TypeIKernelAVX512.inl>
+#endif
+
+namespace girgs {
+
+/// The implementations of the type I kernels, see TypeIKernelDetails.
+enum class TypeIKernelImplementation : int {
+    Generic,    ///< scalar, any cpu
+    AVX2,       ///< 4 pairs at once, needs avx2
+    AVX512      ///< 8 pairs at once, needs avx512f
+};
+
+namespace TypeIKernelDetails {
+/// the kernels used by SpatialTree, set to detectTypeIKernel() when the library is loaded
+GIRGS_API extern TypeIKernelImplementation g_selected;
+}
+
+/// @return whether impl can run on this cpu
+GIRGS_API bool typeIKernelAvailable(TypeIKernelImplementation impl) noexcept;
+
+/// @return the widest implementation the cpu supports
+GIRGS_API TypeIKernelImplementation detectTypeIKernel() noexcept;
+
+/// @return the implementation used by SpatialTree
+inline TypeIKernelImplementation typeIKernel() noexcept {
+    return TypeIKernelDetails::g_selected;
+}
+
+/**
+ * @brief
+ *  Overrides the detected implementation, e.g. for benchmarks or if AVX-512 clocks down the cpu.
+ *  Must not be called while graphs are generated.
+ *
+ * @throw std::invalid_argument if impl is not available on this cpu
+ */
+GIRGS_API void setTypeIKernel(TypeIKernelImplementation impl);
+
+/// @return the name of impl ("Generic", "AVX2" or "AVX512")
+GIRGS_API std::string typeIKernelName(TypeIKernelImplementation impl);
+
+/**
+ * @brief
+ *  Kernels that compare one node of cell A with a contiguous range of nodes of cell B (see SpatialTree::sampleTypeI).
+ *  All implementations provide
+ *   - threshold(a, weightA, W, nodes, begin, end, emit): calls emit(k) for each k in [begin, end)
+ *     with \f$ dist(a, k)^D < w_a w_k / W \f$ in increasing order of k.
+ *   - ratios(a, weightA, W, nodes, begin, end, out): writes \f$ (w_a w_k / W) / dist(a, k)^D \f$ to out[k - begin].
+ *  All implementations perform the same floating point operations and hence produce identical results.
+ *
+ *  Calls f with an object of the selected kernel type, i.e. the kernels are chosen once per call
+ *  and f is usually a generic lambda taking the kernel as auto.
+ */
+template <unsigned D, typename Functor>
+void dispatchTypeIKernel(Functor&& f) {
+    switch (typeIKernel()) {
+#ifdef GIRGS_HAS_AVX_KERNELS
+        case TypeIKernelImplementation::AVX512: return f(TypeIKernelDetails::AVX512::Implementation<D>());
+        case TypeIKernelImplementation::AVX2:   return f(TypeIKernelDetails::AVX2::Implementation<D>());
+#endif
+        default:                                return f(TypeIKernelDetails::Generic::Implementation<D>());
+    }
+}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <limits>
+
+#include <immintrin.h>
+
+namespace girgs {
+namespace TypeIKernelDetails {
+namespace AVX2 {
+template <unsigned D>
+struct Implementation {
+    static constexpr unsigned kLanes = 4;
+
+    using Scalar = Generic::Implementation<D>;
+
+    /// same multiplications as pow_to_the(), which is not compiled for the instruction set
+    template <unsigned E>
+    GIRGS_TARGET_AVX2 static __m256d power(__m256d x) noexcept {
+        if constexpr (E == 1)
+            return x;
+        else
+            return _mm256_mul_pd(power<E / 2>(x), power<(E + 1) / 2>(x));
+    }
+
+#ifdef USE_COMPACT_NODES
+    using Broadcast = __m128i; ///< one fixed point coordinate in all lanes
+
+    GIRGS_TARGET_AVX2 static Broadcast broadcast(uint32_t c) noexcept { return _mm_set1_epi32(static_cast<int>(c)); }
+
+    GIRGS_TARGET_AVX2 static __m256d distanceTerm(const Broadcast (&a)[D], const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        const auto zero = _mm_setzero_si128();
+        auto result = zero;
+        for (auto d = 0u; d < D; ++d) {
+            const auto diff = _mm_sub_epi32(a[d], _mm_loadu_si128(reinterpret_cast<const __m128i*>(nodes.coords[d].data() + k)));
+            result = _mm_max_epu32(result, _mm_min_epu32(diff, _mm_sub_epi32(zero, diff)));
+        }
+        // there is no unsigned conversion in AVX2; shift into the signed range and back
+        const auto shifted = _mm_xor_si128(result, _mm_set1_epi32(std::numeric_limits<int>::min()));
+        const auto dist = _mm256_add_pd(_mm256_cvtepi32_pd(shifted), _mm256_set1_pd(0x1.0p31));
+        return power<D>(_mm256_mul_pd(dist, _mm256_set1_pd(0x1.0p-32)));
+    }
+
+    GIRGS_TARGET_AVX2 static __m256d loadWeights(const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        return _mm256_cvtps_pd(_mm_loadu_ps(nodes.weights.data() + k));
+    }
+#else
+    using Broadcast = __m256d;
+
+    GIRGS_TARGET_AVX2 static Broadcast broadcast(double c) noexcept { return _mm256_set1_pd(c); }
+
+    GIRGS_TARGET_AVX2 static __m256d distanceTerm(const Broadcast (&a)[D], const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        const auto sign = _mm256_set1_pd(-0.0);
+        const auto one = _mm256_set1_pd(1.0);
+        auto result = _mm256_setzero_pd();
+        for (auto d = 0u; d < D; ++d) {
+            auto dist = _mm256_andnot_pd(sign, _mm256_sub_pd(a[d], _mm256_loadu_pd(nodes.coords[d].data() + k)));
+            dist = _mm256_min_pd(dist, _mm256_sub_pd(one, dist));
+            result = _mm256_max_pd(result, dist);
+        }
+        return power<D>(result);
+    }
+
+    GIRGS_TARGET_AVX2 static __m256d loadWeights(const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        return _mm256_loadu_pd(nodes.weights.data() + k);
+    }
+#endif // USE_COMPACT_NODES
+
+    template <typename Callback>
+    GIRGS_TARGET_AVX2 static void threshold(const typename Scalar::Coordinates& a, double weightA, double W,
+                          const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, Callback&& emit) {
+        Broadcast va[D];
+        for (auto d = 0u; d < D; ++d)
+            va[d] = broadcast(a[d]);
+        const auto vw = _mm256_set1_pd(weightA);
+        const auto vW = _mm256_set1_pd(W);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto w_term = _mm256_div_pd(_mm256_mul_pd(vw, loadWeights(nodes, k)), vW);
+            auto mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(distanceTerm(va, nodes, k), w_term, _CMP_LT_OQ)));
+            while (mask) {
+                emit(k + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        Scalar::threshold(a, weightA, W, nodes, k, end, emit);
+    }
+
+    GIRGS_TARGET_AVX2 static void ratios(const typename Scalar::Coordinates& a, double weightA, double W,
+                       const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, double* out) noexcept {
+        Broadcast va[D];
+        for (auto d = 0u; d < D; ++d)
+            va[d] = broadcast(a[d]);
+        const auto vw = _mm256_set1_pd(weightA);
+        const auto vW = _mm256_set1_pd(W);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto w_term = _mm256_div_pd(_mm256_mul_pd(vw, loadWeights(nodes, k)), vW);
+            _mm256_storeu_pd(out + (k - begin), _mm256_div_pd(w_term, distanceTerm(va, nodes, k)));
+        }
+
+        Scalar::ratios(a, weightA, W, nodes, k, end, out + (k - begin));
+    }
+};
+} // namespace AVX2
+} // namespace TypeIKernelDetails
+} // namespace girgs
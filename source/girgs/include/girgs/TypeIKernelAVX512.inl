@@ -0,0 +1,103 @@
+#pragma once
+
+#include <immintrin.h>
+
+namespace girgs {
+namespace TypeIKernelDetails {
+namespace AVX512 {
+template <unsigned D>
+struct Implementation {
+    static constexpr unsigned kLanes = 8;
+
+    using Scalar = Generic::Implementation<D>;
+
+    /// same multiplications as pow_to_the(), which is not compiled for the instruction set
+    template <unsigned E>
+    GIRGS_TARGET_AVX512 static __m512d power(__m512d x) noexcept {
+        if constexpr (E == 1)
+            return x;
+        else
+            return _mm512_mul_pd(power<E / 2>(x), power<(E + 1) / 2>(x));
+    }
+
+#ifdef USE_COMPACT_NODES
+    using Broadcast = __m256i; ///< one fixed point coordinate in all lanes
+
+    GIRGS_TARGET_AVX512 static Broadcast broadcast(uint32_t c) noexcept { return _mm256_set1_epi32(static_cast<int>(c)); }
+
+    GIRGS_TARGET_AVX512 static __m512d distanceTerm(const Broadcast (&a)[D], const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        const auto zero = _mm256_setzero_si256();
+        auto result = zero;
+        for (auto d = 0u; d < D; ++d) {
+            const auto diff = _mm256_sub_epi32(a[d], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nodes.coords[d].data() + k)));
+            result = _mm256_max_epu32(result, _mm256_min_epu32(diff, _mm256_sub_epi32(zero, diff)));
+        }
+        return power<D>(_mm512_mul_pd(_mm512_cvtepu32_pd(result), _mm512_set1_pd(0x1.0p-32)));
+    }
+
+    GIRGS_TARGET_AVX512 static __m512d loadWeights(const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        return _mm512_cvtps_pd(_mm256_loadu_ps(nodes.weights.data() + k));
+    }
+#else
+    using Broadcast = __m512d;
+
+    GIRGS_TARGET_AVX512 static Broadcast broadcast(double c) noexcept { return _mm512_set1_pd(c); }
+
+    GIRGS_TARGET_AVX512 static __m512d distanceTerm(const Broadcast (&a)[D], const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        const auto one = _mm512_set1_pd(1.0);
+        auto result = _mm512_setzero_pd();
+        for (auto d = 0u; d < D; ++d) {
+            auto dist = _mm512_abs_pd(_mm512_sub_pd(a[d], _mm512_loadu_pd(nodes.coords[d].data() + k)));
+            dist = _mm512_min_pd(dist, _mm512_sub_pd(one, dist));
+            result = _mm512_max_pd(result, dist);
+        }
+        return power<D>(result);
+    }
+
+    GIRGS_TARGET_AVX512 static __m512d loadWeights(const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        return _mm512_loadu_pd(nodes.weights.data() + k);
+    }
+#endif // USE_COMPACT_NODES
+
+    template <typename Callback>
+    GIRGS_TARGET_AVX512 static void threshold(const typename Scalar::Coordinates& a, double weightA, double W,
+                          const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, Callback&& emit) {
+        Broadcast va[D];
+        for (auto d = 0u; d < D; ++d)
+            va[d] = broadcast(a[d]);
+        const auto vw = _mm512_set1_pd(weightA);
+        const auto vW = _mm512_set1_pd(W);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto w_term = _mm512_div_pd(_mm512_mul_pd(vw, loadWeights(nodes, k)), vW);
+            auto mask = static_cast<unsigned>(_mm512_cmp_pd_mask(distanceTerm(va, nodes, k), w_term, _CMP_LT_OQ));
+            while (mask) {
+                emit(k + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        Scalar::threshold(a, weightA, W, nodes, k, end, emit);
+    }
+
+    GIRGS_TARGET_AVX512 static void ratios(const typename Scalar::Coordinates& a, double weightA, double W,
+                       const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, double* out) noexcept {
+        Broadcast va[D];
+        for (auto d = 0u; d < D; ++d)
+            va[d] = broadcast(a[d]);
+        const auto vw = _mm512_set1_pd(weightA);
+        const auto vW = _mm512_set1_pd(W);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto w_term = _mm512_div_pd(_mm512_mul_pd(vw, loadWeights(nodes, k)), vW);
+            _mm512_storeu_pd(out + (k - begin), _mm512_div_pd(w_term, distanceTerm(va, nodes, k)));
+        }
+
+        Scalar::ratios(a, weightA, W, nodes, k, end, out + (k - begin));
+    }
+};
+} // namespace AVX512
+} // namespace TypeIKernelDetails
+} // namespace girgs
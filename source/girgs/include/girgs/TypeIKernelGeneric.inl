@@ -0,0 +1,37 @@
+#pragma once
+
+namespace girgs {
+namespace TypeIKernelDetails {
+namespace Generic {
+template <unsigned D>
+struct Implementation {
+    static constexpr unsigned kLanes = 1;
+
+    using Storage = typename NodeColumns<D>::Storage;
+    using Coordinates = std::array<typename NodeColumns<D>::Coordinate, D>;
+
+    static double distanceTerm(const Coordinates& a, const NodeColumns<D>& nodes, std::size_t k) noexcept {
+        auto result = 0.0;
+        for (auto d = 0u; d < D; ++d)
+            result = std::max(result, Storage::torusDistance(a[d], nodes.coords[d][k]));
+        return pow_to_the<D>(result);
+    }
+
+    template <typename Callback>
+    static void threshold(const Coordinates& a, double weightA, double W,
+                          const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, Callback&& emit) {
+        for (auto k = begin; k < end; ++k) {
+            if (distanceTerm(a, nodes, k) < weightA * nodes.weights[k] / W)
+                emit(k);
+        }
+    }
+
+    static void ratios(const Coordinates& a, double weightA, double W,
+                       const NodeColumns<D>& nodes, std::size_t begin, std::size_t end, double* out) noexcept {
+        for (auto k = begin; k < end; ++k)
+            out[k - begin] = (weightA * nodes.weights[k] / W) / distanceTerm(a, nodes, k);
+    }
+};
+} // namespace Generic
+} // namespace TypeIKernelDetails
+} // namespace girgs
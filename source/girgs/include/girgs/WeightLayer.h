@@ -1,6 +1,9 @@
 #pragma once
 
-#include <girgs/Node.h>
+#include <utility>
+#include <cstdint>
+
+#include <girgs/Index.h>
 #include <girgs/SpatialTreeCoordinateHelper.h>
 
 
@@ -14,10 +17,12 @@ namespace girgs {
  *
  * @tparam D
  *  the dimension of the geometry
+ * @tparam CellId
+ *  the type of the cell ids (see SpatialTreeCoordinateHelper)
  */
-template<unsigned int D>
+template<unsigned int D, typename CellId = uint32_t>
 class WeightLayer {
-    using Helper = SpatialTreeCoordinateHelper<D>;
+    using Helper = SpatialTreeCoordinateHelper<D, CellId>;
 
 public:
     WeightLayer() = delete;
@@ -29,13 +34,14 @@ public:
     WeightLayer& operator=(WeightLayer&&) = default;
 
     WeightLayer(unsigned int targetLevel,
-                const Node<D>* base,
-                const unsigned int* prefix_sum)
+                const NodeOffset* prefix_sum)
         : m_target_level{targetLevel},
-          m_base{base}, 
           m_prefix_sums{prefix_sum}
     {}
 
+    /// the deepest level in which cells of this weight layer can be queried
+    unsigned int targetLevel() const noexcept { return m_target_level; }
+
     /**
      * @brief
      *  Returns the number of points of this weight layer in a cell.
@@ -48,7 +54,7 @@ public:
      * @return
      *  Returns how many points there are in cells {begin..end} using prefix sums. Begin and end are the first/last descendants of cell in target level.
      */
-    int pointsInCell(unsigned int cell, unsigned int level) const {
+    NodeOffset pointsInCell(CellId cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
         assert(cellBoundaries.first  + Helper::firstCellOfLevel(level) < Helper::firstCellOfLevel(m_target_level+1));
         assert(cellBoundaries.second + Helper::firstCellOfLevel(level) < Helper::firstCellOfLevel(m_target_level+1));
@@ -61,7 +67,7 @@ public:
      * @brief
      *  Implements the second operation required for the data structure in the paper (Lemma 4.1).
      *  The method finds the first descendant of the given cell in the target level.
-     *  Then #m_prefix_sums and #m_A are used to find the requested point.
+     *  Then #m_prefix_sums is used to find the requested point.
      *
      * @param cell
      *  The cell that contains the points.
@@ -71,19 +77,20 @@ public:
      * @param k
      *  The point we want to access.
      *  This should be less than the number of points of this weight layer in the given cell
-     *  (i.e. less than what was returned by pointsInCell(unsigned int, unsigned int) const ).
+     *  (i.e. less than what was returned by pointsInCell(CellId, unsigned int) const ).
      * @return
-     *  Returns the requested node.
+     *  Returns the position of the requested node in the sorted node array.
      */
-    const Node<D>& kthPoint(unsigned int cell, unsigned int level, int k) const {
+    NodeOffset kthPoint(CellId cell, unsigned int level, NodeOffset k) const {
         auto cellBoundaries = levelledCell(cell, level);
-        return m_base[m_prefix_sums[cellBoundaries.first] + k];
+        return m_prefix_sums[cellBoundaries.first] + k;
     }
 
 
     /**
      * @brief
-     *  Return points to the first element of the cell ("begin") and the first element after the cell ("end")
+     *  Returns the position of the first node of the cell ("begin") and of the first node after the cell ("end")
+     *  in the sorted node array.
      *
      * @param cell
      *  The cell that contains the points.
@@ -93,17 +100,17 @@ public:
      * @return
      *  {begin, end}
      */
-    std::pair<const Node<D>*, const Node<D>*> cellIterators(unsigned int cell, unsigned int level) const {
+    std::pair<NodeOffset, NodeOffset> cellRange(CellId cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
-        const auto begin_end = std::make_pair(m_base + m_prefix_sums[cellBoundaries.first],
-                                              m_base + m_prefix_sums[cellBoundaries.second+1]);
+        const auto begin_end = std::make_pair(m_prefix_sums[cellBoundaries.first],
+                                              m_prefix_sums[cellBoundaries.second+1]);
         assert(begin_end.first <= begin_end.second);
         return begin_end;
     }
 
 protected:
 
-    std::pair<unsigned int, unsigned int> levelledCell(unsigned int cell, unsigned int level) const {
+    std::pair<CellId, CellId> levelledCell(CellId cell, unsigned int level) const {
         assert(level <= m_target_level);
         assert(Helper::firstCellOfLevel(level) <= cell && cell < Helper::firstCellOfLevel(level + 1)); // cell is from fromLevel
 
@@ -123,8 +130,7 @@ protected:
 protected:
 
     const unsigned int  m_target_level;     ///< the insertion level for the current weight layer (v(i) = wiw0/W)
-    const Node<D>*      m_base;             ///< sorted array of all nodes
-    const unsigned int* m_prefix_sums;      ///< for each cell c in target level: sum of nodes in m_base before first node in c
+    const NodeOffset*   m_prefix_sums;      ///< for each cell c in target level: number of nodes in the sorted node array before the first node in c
 };
 
 } // namespace girgs
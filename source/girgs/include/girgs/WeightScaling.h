@@ -1,15 +1,151 @@
 #pragma once
 
+#include <map>
 #include <vector>
+#include <limits>
+#include <utility>
+#include <cstddef>
 
 #include <girgs/girgs_api.h>
 
 
 namespace girgs {
 
+
+/**
+ * @brief
+ *  Sorts a copy of the weights in descending order, but only as far as needed:
+ *  after sortDownto(t), all weights >= t form a sorted prefix.
+ *  The unsorted remainder is partitioned and the new part of the prefix is sorted by all threads.
+ */
+class GIRGS_API LazySorter {
+public:
+    explicit LazySorter(std::vector<double> weights);
+
+    /**
+     * @brief
+     *  Extends the sorted prefix to all weights >= thresh.
+     *
+     * @return
+     *  The number of weights larger than thresh (or equal if they were not sorted before).
+     */
+    std::size_t sortDownto(double thresh);
+
+    /// the weights; the first sortedSize() of them are sorted in descending order
+    const std::vector<double>& weights() const noexcept { return m_sweights; }
+
+    std::size_t sortedSize() const noexcept { return m_sorted_end; }
+
+private:
+    std::vector<double> m_sweights;
+    std::size_t m_sorted_end = 0;
+    double m_lower = std::numeric_limits<double>::max(); ///< all unsorted weights are smaller
+};
+
+
+/**
+ * @brief
+ *  Sums over the weights that estimateWeightScaling() and estimateWeightScalingThreshold() need,
+ *  together with the lazily sorted rich club and prefix sums over it.
+ *  Constructing the object reads all weights once. Passing the same object to several estimations
+ *  (e.g. for different degrees, dimensions, or alphas) reuses the sums and the sorted rich club.
+ *
+ *  All sums are reduced in fixed blocks, so the estimates do not depend on the number of threads.
+ */
+class GIRGS_API WeightStatistics {
+public:
+    explicit WeightStatistics(const std::vector<double>& weights);
+
+    std::size_t size() const noexcept { return m_sorter.weights().size(); }
+    double totalWeight() const noexcept { return m_total; }     ///< sum of all weights
+    double sumOfSquares() const noexcept { return m_squares; }  ///< sum of all squared weights
+    double maxWeight() const noexcept { return m_max; }
+
+    /// sum of w^alpha over all weights; cached per alpha
+    double powerSum(double alpha);
+    /// sum of w^(2 alpha) over all weights; cached per alpha
+    double squaredPowerSum(double alpha);
+
+    /// computes powerSum() and squaredPowerSum() of all alphas that are not cached yet with a single pass over the weights
+    void preparePowerSums(const std::vector<double>& alphas);
+
+    /// sorts the rich club of all weights >= thresh and returns its size (see LazySorter::sortDownto())
+    std::size_t richClub(double thresh);
+
+    /// i-th largest weight; i has to be in the sorted rich club
+    double sorted(std::size_t i) const noexcept { return m_sorter.weights()[i]; }
+
+    /// sum of the i largest weights; i has to be at most the size of the last rich club
+    double prefixSum(std::size_t i) const noexcept { return m_prefix[i]; }
+
+    /// powers of the sorted rich club for one alpha (see preparePowers())
+    struct RichClubPowers {
+        std::vector<double> powers;                 ///< powers[i] = sorted(i)^alpha
+        std::vector<long double> prefix {0.0};      ///< prefix[i] = sum of the first i entries of powers
+    };
+
+    /**
+     * @brief
+     *  Computes the powers of the first size weights of the rich club for alpha.
+     *  The powers are cached per alpha; the returned reference stays valid for the lifetime of this object.
+     */
+    const RichClubPowers& preparePowers(double alpha, std::size_t size);
+
+private:
+    LazySorter m_sorter;
+    double m_total = 0.0;
+    double m_squares = 0.0;
+    double m_max = 0.0;
+
+    std::map<double, std::pair<double, double>> m_power_sums;  ///< alpha -> (powerSum(), squaredPowerSum())
+    std::vector<double> m_prefix;                               ///< m_prefix[i] = sum of the i largest weights
+    std::map<double, RichClubPowers> m_powers;                  ///< alpha -> powers of the rich club
+};
+
+
+/// A desired average degree for one combination of dimension and alpha (see WeightScalingSolver).
+struct WeightScalingTarget {
+    double desiredAvgDegree;
+    int dimension;
+    double alpha;
+};
+
+/**
+ * @brief
+ *  Answers many weight scaling queries for the same weights, e.g. in parameter sweeps.
+ *  The solver sorts the rich club and computes the sums over the weights only as far as needed
+ *  and reuses them for all later queries.
+ *
+ *  scalings() solves all targets together: their searches advance in lockstep, so that
+ *  the rich club is extended once per step for all of them, the power sums of all alphas
+ *  are computed in a single pass, and the estimates of the targets are evaluated in parallel.
+ *  The results equal those of scaleWeights() and do not depend on the number of threads.
+ */
+class GIRGS_API WeightScalingSolver {
+public:
+    explicit WeightScalingSolver(const std::vector<double>& weights);
+
+    /// the scaling that scaleWeights() applies for these parameters; throws for alpha <= 0 or alpha == 1
+    double scaling(double desiredAvgDegree, int dimension, double alpha);
+
+    /// scaling() of all targets in the same order, computed together
+    std::vector<double> scalings(const std::vector<WeightScalingTarget>& targets);
+
+    WeightStatistics& statistics() noexcept { return m_statistics; }
+
+private:
+    WeightStatistics m_statistics;
+};
+
+
 GIRGS_API double estimateWeightScaling(const std::vector<double> &weights, double desiredAvgDegree, int dimension, double alpha);
 
+/// Same as estimateWeightScaling(const std::vector<double>&, double, int, double) with precomputed statistics of the weights.
+GIRGS_API double estimateWeightScaling(WeightStatistics& statistics, double desiredAvgDegree, int dimension, double alpha);
+
 GIRGS_API double estimateWeightScalingThreshold(const std::vector<double>& weights, double desiredAvgDegree, int dimension);
 
-} // namespace girgs
+/// Same as estimateWeightScalingThreshold(const std::vector<double>&, double, int) with precomputed statistics of the weights.
+GIRGS_API double estimateWeightScalingThreshold(WeightStatistics& statistics, double desiredAvgDegree, int dimension);
 
+} // namespace girgs
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <girgs/BitManipulation.h>
+
+
+namespace girgs {
+
+namespace {
+
+// deposits and extracts the cells of a 2D and a 3D grid and returns the fastest of a few runs in nanoseconds
+template<template<unsigned, typename> class Impl>
+long long timeMorton(const std::vector<uint32_t>& cells) {
+    auto best = std::numeric_limits<long long>::max();
+    for (auto run = 0; run < 5; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        auto checksum = uint32_t{0};
+        for (auto cell : cells) {
+            checksum += Impl<2, uint32_t>::deposit(Impl<2, uint32_t>::extract(cell));
+            checksum += Impl<3, uint32_t>::deposit(Impl<3, uint32_t>::extract(cell));
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        // keeps the compiler from dropping the loop
+        static volatile uint32_t sink;
+        sink = checksum;
+
+        best = std::min<long long>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+
+bool mortonImplementationAvailable(MortonImplementation impl) noexcept {
+    switch (impl) {
+        case MortonImplementation::Generic:
+        case MortonImplementation::LUT:
+            return true;
+        case MortonImplementation::BMI2:
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
+            // may run before the constructors of the runtime library, which initialise the cpu model otherwise
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("bmi2");
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+MortonImplementation calibrateMortonImplementation() {
+    auto cells = std::vector<uint32_t>(2048);
+    auto gen = std::mt19937(42);
+    for (auto& cell : cells)
+        cell = gen();
+
+    auto best = MortonImplementation::Generic;
+    auto bestTime = timeMorton<BitManipulationDetails::Generic::Implementation>(cells);
+
+    const auto lutTime = timeMorton<BitManipulationDetails::LUT::Implementation>(cells);
+    if (lutTime < bestTime) {
+        best = MortonImplementation::LUT;
+        bestTime = lutTime;
+    }
+
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
+    if (mortonImplementationAvailable(MortonImplementation::BMI2)) {
+        const auto bmi2Time = timeMorton<BitManipulationDetails::BMI2::Implementation>(cells);
+        if (bmi2Time < bestTime)
+            best = MortonImplementation::BMI2;
+    }
+#endif
+
+    return best;
+}
+
+void setMortonImplementation(MortonImplementation impl) {
+    if (!mortonImplementationAvailable(impl))
+        throw std::invalid_argument{"Error: Morton implementation " + mortonImplementationName(impl) + " is not available on this cpu"};
+    BitManipulationDetails::g_selected = impl;
+}
+
+std::string mortonImplementationName(MortonImplementation impl) {
+    switch (impl) {
+        case MortonImplementation::Generic: return BitManipulationDetails::Generic::Implementation<1>::name();
+        case MortonImplementation::LUT:     return BitManipulationDetails::LUT::Implementation<1>::name();
+        case MortonImplementation::BMI2:    return "BMI2";
+        default:                            return "unknown";
+    }
+}
+
+namespace BitManipulationDetails {
+MortonImplementation g_selected = calibrateMortonImplementation();
+}
+
+
+} // namespace girgs
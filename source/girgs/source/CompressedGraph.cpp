@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <cassert>
+
+#include <omp.h>
+
+#include <girgs/CompressedGraph.h>
+#include <girgs/IntSort.h>
+#include <girgs/SpatialTreeCoordinateHelper.h>
+#include <girgs/TextWriter.h>
+
+
+namespace girgs {
+
+
+namespace {
+
+template<unsigned int D, typename CellId, typename PositionContainer>
+std::vector<NodeIndex> mortonLabelsImpl(const PositionContainer& positions) {
+    // finest level whose cell ids fit into CellId
+    constexpr auto level = sizeof(CellId) == 4 ? std::min(30u, 32u / D) : 63u / D;
+    constexpr auto max_cell = static_cast<CellId>((uint64_t{1} << (D * level)) - 1);
+
+    struct SortNode {
+        CellId cell;
+        NodeIndex index;
+    };
+
+    const auto n = static_cast<NodeIndex>(numPoints(positions));
+    auto nodes = std::vector<SortNode>(n);
+    #pragma omp parallel for schedule(static)
+    for (NodeIndex i = 0; i < n; ++i)
+        nodes[i] = {SpatialTreeCoordinateHelper<D, CellId>::cellForPoint(coordinatesOf<D>(positions, i), level), i};
+
+    // the radix sort is stable, so nodes in the same cell keep their order
+    intsort::intsort(nodes, [](const SortNode& node) { return node.cell; }, max_cell);
+
+    auto labels = std::vector<NodeIndex>(n);
+    #pragma omp parallel for schedule(static)
+    for (NodeIndex k = 0; k < n; ++k)
+        labels[nodes[k].index] = k;
+    return labels;
+}
+
+template<typename PositionContainer>
+std::vector<NodeIndex> mortonLabelsDispatch(const PositionContainer& positions) {
+    switch(dimensionOf(positions)) {
+        case 1: return mortonLabelsImpl<1, uint32_t>(positions);
+        case 2: return mortonLabelsImpl<2, uint32_t>(positions);
+        case 3: return mortonLabelsImpl<3, uint32_t>(positions);
+        case 4: return mortonLabelsImpl<4, uint32_t>(positions);
+        case 5: return mortonLabelsImpl<5, uint32_t>(positions);
+        case 6: return mortonLabelsImpl<6, uint64_t>(positions);
+        case 7: return mortonLabelsImpl<7, uint64_t>(positions);
+        case 8: return mortonLabelsImpl<8, uint64_t>(positions);
+        case 9: return mortonLabelsImpl<9, uint64_t>(positions);
+        case 10: return mortonLabelsImpl<10, uint64_t>(positions);
+        default:
+            throw std::invalid_argument{"Error: Morton labels support dimensions 1 to 10"};
+    }
+}
+
+void appendVarint(std::string& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer += static_cast<char>(value);
+}
+
+} // namespace
+
+
+std::vector<NodeIndex> mortonLabels(const FlatPositions& positions) {
+    return mortonLabelsDispatch(positions);
+}
+
+std::vector<NodeIndex> mortonLabels(const std::vector<std::vector<double>>& positions) {
+    return mortonLabelsDispatch(positions);
+}
+
+std::vector<NodeIndex> mortonLabels(const PositionView& positions) {
+    return mortonLabelsDispatch(positions);
+}
+
+
+void saveCompressed(CompressedGraphHeader header, NodeIndex n, const std::vector<Edge>& graph,
+                    const std::vector<NodeIndex>& labels, const std::string& file) {
+    assert(labels.empty() || labels.size() == static_cast<std::size_t>(n));
+    header.n = static_cast<uint64_t>(n);
+    header.m = graph.size();
+    header.relabelled = labels.empty() ? 0 : 1;
+
+    auto label = [&] (NodeIndex v) { return labels.empty() ? v : labels[v]; };
+
+    // build the upper half of the adjacency array: edge {u,v} is stored at min(u,v) only
+    // (same two passes as CSRBuilder; the order within a neighbourhood is fixed by sorting it below)
+    const auto m = static_cast<long long>(graph.size());
+    std::vector<std::size_t> offsets(static_cast<std::size_t>(n) + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (long long k = 0; k < m; ++k) {
+        const auto u = std::min(label(graph[k].first), label(graph[k].second));
+        #pragma omp atomic
+        offsets[u + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<NodeIndex> neighbours(graph.size());
+    {
+        auto cursor = std::vector<std::size_t>(offsets.begin(), offsets.end() - 1);
+        #pragma omp parallel for schedule(static)
+        for (long long k = 0; k < m; ++k) {
+            const auto u = label(graph[k].first);
+            const auto v = label(graph[k].second);
+            std::size_t pos;
+            #pragma omp atomic capture
+            pos = cursor[std::min(u, v)]++;
+            neighbours[pos] = std::max(u, v);
+        }
+    }
+
+    // sort the neighbourhoods; the gaps are only defined if each neighbour is larger than its predecessor,
+    // i.e. if the graph has neither duplicate edges nor self loops
+    auto invalid = false;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(||:invalid)
+    for (long long u = 0; u < static_cast<long long>(n); ++u) {
+        const auto begin = neighbours.begin() + offsets[u];
+        const auto end = neighbours.begin() + offsets[u+1];
+        std::sort(begin, end);
+        invalid = invalid || (begin != end && *begin == u) || std::adjacent_find(begin, end) != end;
+    }
+    if (invalid)
+        throw std::invalid_argument{"Error: the graph contains duplicate edges or self loops"};
+
+    std::ofstream f{file, std::ios::binary};
+    if (!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // every thread encodes the neighbourhoods of its chunk of nodes
+    writeChunked(f, static_cast<std::size_t>(n), [&] (std::size_t u, std::string& buffer) {
+        const auto begin = neighbours.begin() + offsets[u];
+        const auto end = neighbours.begin() + offsets[u+1];
+
+        appendVarint(buffer, static_cast<uint64_t>(end - begin));
+        auto previous = static_cast<uint64_t>(u);
+        for (auto it = begin; it != end; ++it) {
+            assert(static_cast<uint64_t>(*it) > previous);
+            appendVarint(buffer, static_cast<uint64_t>(*it) - previous - 1);
+            previous = static_cast<uint64_t>(*it);
+        }
+    });
+
+    if (!f)
+        throw std::runtime_error{"Error: failed to write file \"" + file + '\"'};
+}
+
+
+CompressedGraphReader::CompressedGraphReader(const std::string& file)
+    : m_name(file)
+    , m_stream(file, std::ios::binary)
+    , m_buffer(1 << 20)
+{
+    if (!m_stream.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+
+    const auto expected = CompressedGraphHeader();
+    if (!m_stream.read(reinterpret_cast<char*>(&m_header), sizeof(m_header))
+        || m_header.magic != expected.magic || m_header.version != expected.version || m_header.coding != expected.coding)
+        throw std::runtime_error{"Error: \"" + file + "\" is no compressed adjacency file of version 1"};
+}
+
+bool CompressedGraphReader::next(std::vector<NodeIndex>& neighbours) {
+    neighbours.clear();
+    if (m_node + 1 >= m_header.n) {
+        m_node = m_header.n;
+        return false;
+    }
+    ++m_node;
+
+    const auto degree = readVarint();
+    neighbours.resize(degree);
+    auto previous = m_node;
+    for (auto& v : neighbours) {
+        previous += readVarint() + 1;
+        v = static_cast<NodeIndex>(previous);
+    }
+
+    return true;
+}
+
+uint64_t CompressedGraphReader::readVarint() {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (m_begin == m_end)
+            refill();
+        const auto byte = static_cast<unsigned char>(m_buffer[m_begin++]);
+        result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return result;
+    }
+    throw std::runtime_error{"Error: corrupted varint in \"" + m_name + '\"'};
+}
+
+void CompressedGraphReader::refill() {
+    m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_begin = 0;
+    m_end = static_cast<std::size_t>(m_stream.gcount());
+    if (m_end == 0)
+        throw std::runtime_error{"Error: unexpected end of file \"" + m_name + '\"'};
+}
+
+
+} // namespace girgs
@@ -0,0 +1,166 @@
+#include <random>
+#include <variant>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include <girgs/EdgeSampler.h>
+#include <girgs/EdgeBuffer.h>
+#include <girgs/EdgeCollector.h>
+#include <girgs/CSRBuilder.h>
+#include <girgs/SpatialTree.h>
+
+
+namespace girgs {
+
+
+namespace {
+
+/// edge callback of the trees that only hold the preprocessed weights and positions
+struct NoEdges {
+    void operator()(NodeIndex, NodeIndex, int) const {}
+};
+
+/// buffers the edges of one sample of an ensemble, which is sampled by a single thread (so the thread id is ignored)
+class SampleBuffer {
+public:
+    SampleBuffer(const SampleBlockCallback& consumer, std::size_t sample, std::size_t blockSize)
+        : m_consumer(consumer)
+        , m_sample(sample)
+        , m_block_size(blockSize)
+    {
+        m_edges.reserve(blockSize);
+    }
+
+    void operator()(NodeIndex u, NodeIndex v, int) {
+        m_edges.emplace_back(u, v);
+        if (m_edges.size() == m_block_size)
+            flush();
+    }
+
+    void flush() {
+        if (m_edges.empty())
+            return;
+        m_consumer(m_sample, m_edges.data(), m_edges.size());
+        m_edges.clear();
+    }
+
+private:
+    const SampleBlockCallback& m_consumer;
+    const std::size_t m_sample;
+    const std::size_t m_block_size;
+    std::vector<Edge> m_edges;
+};
+
+} // namespace
+
+
+class EdgeSampler::Impl {
+public:
+    template<typename PositionContainer>
+    Impl(const std::vector<double>& weights, const PositionContainer& positions, double alpha)
+        : m_n(static_cast<NodeIndex>(weights.size()))
+    {
+        const auto supported = dispatchSpatialTree(dimensionOf(positions), weights, [&] (auto dim, auto cellId) {
+            using Tree = SpatialTree<decltype(dim)::value, NoEdges, decltype(cellId)>;
+            m_tree = std::make_unique<Tree>(weights, positions, alpha, m_no_edges);
+        });
+        if (!supported)
+            throw std::invalid_argument{"Error: EdgeSampler supports dimensions 1 to 10"};
+    }
+
+    NodeIndex numNodes() const noexcept { return m_n; }
+
+    /// samples the edges of seed with a tree that shares the preprocessed nodes and reports them to callback
+    template<typename EdgeCallback>
+    void sample(int seed, EdgeCallback& callback, unsigned int shard = 0, unsigned int numShards = 1) const {
+        std::visit([&] (const auto& prototype) {
+            makeSpatialTree(*prototype, callback).generateEdges(seed, shard, numShards);
+        }, m_tree);
+    }
+
+private:
+    template<unsigned int D>
+    using NarrowTree = std::unique_ptr<SpatialTree<D, NoEdges, uint32_t>>;
+    template<unsigned int D>
+    using WideTree = std::unique_ptr<SpatialTree<D, NoEdges, uint64_t>>;
+
+    NodeIndex m_n;
+    NoEdges m_no_edges;
+    std::variant< // the alternatives of dispatchSpatialTree()
+        NarrowTree<1>, NarrowTree<2>, NarrowTree<3>, NarrowTree<4>, NarrowTree<5>,
+        WideTree<1>, WideTree<2>, WideTree<3>, WideTree<4>, WideTree<5>,
+        WideTree<6>, WideTree<7>, WideTree<8>, WideTree<9>, WideTree<10>
+    > m_tree;
+};
+
+
+EdgeSampler::EdgeSampler(const std::vector<double>& weights, const std::vector<std::vector<double>>& positions, double alpha)
+    : m_impl(std::make_unique<Impl>(weights, positions, alpha))
+{}
+
+EdgeSampler::EdgeSampler(const std::vector<double>& weights, const FlatPositions& positions, double alpha)
+    : m_impl(std::make_unique<Impl>(weights, positions, alpha))
+{}
+
+EdgeSampler::~EdgeSampler() = default;
+EdgeSampler::EdgeSampler(EdgeSampler&&) noexcept = default;
+EdgeSampler& EdgeSampler::operator=(EdgeSampler&&) noexcept = default;
+
+NodeIndex EdgeSampler::numNodes() const noexcept {
+    return m_impl->numNodes();
+}
+
+std::vector<Edge> EdgeSampler::generateEdges(int samplingSeed) const {
+    auto collector = EdgeCollector();
+    m_impl->sample(samplingSeed, collector);
+    return collector.collect();
+}
+
+void EdgeSampler::generateEdges(int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize,
+        unsigned int shard, unsigned int numShards) const {
+    auto buffer = EdgeBuffer<const EdgeBlockCallback>(consumer, blockSize);
+    m_impl->sample(samplingSeed, buffer, shard, numShards);
+    buffer.flushAll();
+}
+
+CSRGraph EdgeSampler::generateCSR(int samplingSeed) const {
+    // both passes have to produce the same edges, so we must not draw a fresh random seed per pass
+    if (samplingSeed < 0)
+        samplingSeed = static_cast<int>(std::random_device{}() >> 1);
+
+    auto builder = CSRBuilder(static_cast<std::size_t>(m_impl->numNodes()));
+    m_impl->sample(samplingSeed, builder);
+    builder.finishCounting();
+    m_impl->sample(samplingSeed, builder);
+    return builder.finish();
+}
+
+void EdgeSampler::generateEnsemble(const std::vector<int>& samplingSeeds, const SampleBlockCallback& consumer,
+        std::size_t blockSize) const {
+    const auto num_samples = static_cast<long long>(samplingSeeds.size());
+
+    #pragma omp parallel
+    {
+        // the sampling of one graph is sequential within this thread
+        omp_set_num_threads(1);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long long s = 0; s < num_samples; ++s) {
+            auto buffer = SampleBuffer(consumer, static_cast<std::size_t>(s), blockSize);
+            m_impl->sample(samplingSeeds[s], buffer);
+            buffer.flush();
+        }
+    }
+}
+
+std::vector<std::vector<Edge>> EdgeSampler::generateEnsemble(const std::vector<int>& samplingSeeds) const {
+    auto graphs = std::vector<std::vector<Edge>>(samplingSeeds.size());
+    generateEnsemble(samplingSeeds, [&] (std::size_t sample, const Edge* edges, std::size_t count) {
+        graphs[sample].insert(graphs[sample].end(), edges, edges + count);
+    });
+    return graphs;
+}
+
+
+} // namespace girgs
@@ -3,22 +3,32 @@
 #include <iomanip>
 #include <random>
 #include <functional>
-#include <mutex>
 #include <ios>
 
 #include <omp.h>
 
 #include <girgs/Generator.h>
+#include <girgs/EdgeBuffer.h>
+#include <girgs/EdgeCollector.h>
+#include <girgs/CSRBuilder.h>
 #include <girgs/SpatialTree.h>
+#include <girgs/TextWriter.h>
+#include <girgs/Variates.h>
 #include <girgs/WeightScaling.h>
 
 
 namespace girgs {
 
-std::vector<double> generateWeights(int n, double ple, int weightSeed, bool parallel) {
-    const auto threads = parallel ? std::max(1, std::min(omp_get_max_threads(), n / 10000)) : 1;
+// streams of generateVariates()
+constexpr uint32_t kWeightStream = 1;
+constexpr uint32_t kPositionStream = 2;
+
+std::vector<double> generateWeights(NodeIndex n, double ple, int weightSeed, bool parallel) {
     auto result = std::vector<double>(n);
 
+#ifdef USE_LEGACY_VARIATES
+    const auto threads = parallel ? static_cast<int>(std::max<NodeIndex>(1, std::min<NodeIndex>(omp_get_max_threads(), n / 10000))) : 1;
+
     #pragma omp parallel num_threads(threads)
     {
         const auto tid = omp_get_thread_num();
@@ -26,18 +36,29 @@ std::vector<double> generateWeights(int n, double ple, int weightSeed, bool para
         auto dist = std::uniform_real_distribution<>{};
 
         #pragma omp for schedule(static)
-        for (int i = 0; i < n; ++i) {
+        for (NodeIndex i = 0; i < n; ++i) {
             result[i] = std::pow((std::pow(0.5*n, -ple + 1) - 1) * dist(gen) + 1, 1 / (-ple + 1));
         }
     }
+#else
+    // inverse CDF of the power law with the loop invariant power hoisted
+    const auto scale = std::pow(0.5*n, -ple + 1) - 1;
+    const auto exponent = 1 / (-ple + 1);
+    generateVariates(n, weightSeed, kWeightStream, parallel, [&] (std::size_t first, const double* uniforms, std::size_t size) {
+        for (std::size_t k = 0; k < size; ++k)
+            result[first + k] = std::pow(scale * uniforms[k] + 1, exponent);
+    });
+#endif
 
     return result;
 }
 
-std::vector<std::vector<double>> generatePositions(int n, int dimension, int positionSeed, bool parallel) {
-    const auto threads = parallel ? std::max(1, std::min(omp_get_max_threads(), n / 10000)) : 1;
+std::vector<std::vector<double>> generatePositions(NodeIndex n, int dimension, int positionSeed, bool parallel) {
     auto result = std::vector<std::vector<double>>(n, std::vector<double>(dimension));
 
+#ifdef USE_LEGACY_VARIATES
+    const auto threads = parallel ? static_cast<int>(std::max<NodeIndex>(1, std::min<NodeIndex>(omp_get_max_threads(), n / 10000))) : 1;
+
     #pragma omp parallel num_threads(threads)
     {
         const auto tid = omp_get_thread_num();
@@ -45,23 +66,57 @@ std::vector<std::vector<double>> generatePositions(int n, int dimension, int pos
         auto dist = std::uniform_real_distribution<>{};
 
         #pragma omp for schedule(static)
-        for(int i=0; i<n; ++i)
+        for(NodeIndex i=0; i<n; ++i)
             for (int d=0; d<dimension; ++d)
                 result[i][d] = dist(gen);
     }
+#else
+    // the variates are the coordinates in row-major order
+    generateVariates(static_cast<std::size_t>(n) * dimension, positionSeed, kPositionStream, parallel,
+            [&] (std::size_t first, const double* uniforms, std::size_t size) {
+        for (std::size_t k = 0; k < size; ++k)
+            result[(first + k) / dimension][(first + k) % dimension] = uniforms[k];
+    });
+#endif
 
     return result;
 }
 
+void generatePositions(FlatPositions& positions, int positionSeed, bool parallel) {
+    const auto n = static_cast<NodeIndex>(positions.size());
+    const auto dimension = positions.dimension();
+
+#ifdef USE_LEGACY_VARIATES
+    const auto threads = parallel ? static_cast<int>(std::max<NodeIndex>(1, std::min<NodeIndex>(omp_get_max_threads(), n / 10000))) : 1;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        const auto tid = omp_get_thread_num();
+        auto gen = default_random_engine{positionSeed >= 0 ? (positionSeed+tid) : std::random_device()()};
+        auto dist = std::uniform_real_distribution<>{};
+
+        #pragma omp for schedule(static)
+        for(NodeIndex i=0; i<n; ++i)
+            for (auto d=0u; d<dimension; ++d)
+                positions(i, d) = dist(gen);
+    }
+#else
+    // the variates are the coordinates in row-major order, as for the nested positions
+    generateVariates(static_cast<std::size_t>(n) * dimension, positionSeed, kPositionStream, parallel,
+            [&] (std::size_t first, const double* uniforms, std::size_t size) {
+        if (positions.layout() == FlatPositions::Layout::RowMajor) {
+            std::copy(uniforms, uniforms + size, positions.data() + first);
+        } else {
+            for (std::size_t k = 0; k < size; ++k)
+                positions((first + k) / dimension, (first + k) % dimension) = uniforms[k];
+        }
+    });
+#endif
+}
+
 double scaleWeights(std::vector<double>& weights, double desiredAvgDegree, int dimension, double alpha) {
     // estimate scaling with binary search
-    double scaling;
-    if(alpha > 8.0)
-        scaling = estimateWeightScalingThreshold(weights, desiredAvgDegree, dimension);
-    else if(alpha > 0.0 && alpha != 1.0)
-        scaling = estimateWeightScaling(weights, desiredAvgDegree, dimension, alpha);
-    else
-        throw("I do not know how to scale weights for desired alpha :(");
+    const auto scaling = WeightScalingSolver(weights).scaling(desiredAvgDegree, dimension, alpha);
 
     // scale weights
     for(auto& each : weights)
@@ -69,75 +124,179 @@ double scaleWeights(std::vector<double>& weights, double desiredAvgDegree, int d
     return scaling;
 }
 
-std::vector<std::pair<int, int>> generateEdges(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
+double scaleWeights(std::vector<double>& weights, double desiredAvgDegree, const FlatPositions& positions, double alpha) {
+    return scaleWeights(weights, desiredAvgDegree, static_cast<int>(positions.dimension()), alpha);
+}
+
+template<typename WeightContainer, typename PositionContainer, typename EdgeCallback>
+static void sampleEdges(const WeightContainer &weights, const PositionContainer &positions,
+        double alpha, int samplingSeed, EdgeCallback& callback, unsigned int shard = 0, unsigned int numShards = 1) {
+
+    auto dimension = dimensionOf(positions);
+
+    const auto supported = dispatchSpatialTree(dimension, weights, [&] (auto dim, auto cellId) {
+        using Tree = SpatialTree<decltype(dim)::value, EdgeCallback, decltype(cellId)>;
+        Tree(weights, positions, alpha, callback).generateEdges(samplingSeed, shard, numShards);
+    });
+
+    if (!supported) {
+        std::cout << "Dimension " << dimension << " not supported." << std::endl;
+        std::cout << "No edges generated." << std::endl;
+    }
+}
+
+template<typename WeightContainer, typename PositionContainer>
+static void generateEdgesImpl(const WeightContainer &weights, const PositionContainer &positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize,
+        unsigned int shard, unsigned int numShards) {
+
+    auto buffer = EdgeBuffer<const EdgeBlockCallback>(consumer, blockSize);
+    sampleEdges(weights, positions, alpha, samplingSeed, buffer, shard, numShards);
+    buffer.flushAll();
+}
+
+template<typename WeightContainer, typename PositionContainer>
+static std::vector<Edge> generateEdgesImpl(const WeightContainer &weights, const PositionContainer &positions,
         double alpha, int samplingSeed) {
 
-    using edge_vector = std::vector<std::pair<int, int>>;
-    edge_vector result;
+    auto collector = EdgeCollector();
+    sampleEdges(weights, positions, alpha, samplingSeed, collector);
+    return collector.collect();
+}
 
-    std::vector<std::pair<
-            edge_vector,
-            uint64_t[31] /* avoid false sharing */
-    > > local_edges(omp_get_max_threads());
+template<typename WeightContainer, typename PositionContainer>
+static CSRGraph generateCSRImpl(const WeightContainer &weights, const PositionContainer &positions,
+        double alpha, int samplingSeed) {
 
-    constexpr auto block_size = size_t{1} << 20;
+    // both passes have to produce the same edges, so we must not draw a fresh random seed per pass
+    if (samplingSeed < 0)
+        samplingSeed = static_cast<int>(std::random_device{}() >> 1);
 
-    std::mutex m;
-    auto flush = [&] (const edge_vector& local) {
-        std::lock_guard<std::mutex> lock(m);
-        result.insert(result.end(), local.cbegin(), local.cend());
-    };
+    auto builder = CSRBuilder(weights.size());
 
-    auto addEdge = [&](int u, int v, int tid) {
-        auto& local = local_edges[tid].first;
-        local.emplace_back(u,v);
-        if (local.size() == block_size) {
-            flush(local);
-            local.clear();
-        }
+    auto dimension = dimensionOf(positions);
+    auto generate = [&] (auto& tree) {
+        tree.generateEdges(samplingSeed);
+        builder.finishCounting();
+        tree.generateEdges(samplingSeed);
     };
 
-    auto dimension = positions.front().size();
-
-    switch(dimension) {
-        case 1: makeSpatialTree<1>(weights, positions, alpha, addEdge).generateEdges(samplingSeed); break;
-        case 2: makeSpatialTree<2>(weights, positions, alpha, addEdge).generateEdges(samplingSeed); break;
-        case 3: makeSpatialTree<3>(weights, positions, alpha, addEdge).generateEdges(samplingSeed); break;
-        case 4: makeSpatialTree<4>(weights, positions, alpha, addEdge).generateEdges(samplingSeed); break;
-        case 5: makeSpatialTree<5>(weights, positions, alpha, addEdge).generateEdges(samplingSeed); break;
-        default:
-            std::cout << "Dimension " << dimension << " not supported." << std::endl;
-            std::cout << "No edges generated." << std::endl;
-            break;
+    const auto supported = dispatchSpatialTree(dimension, weights, [&] (auto dim, auto cellId) {
+        auto tree = SpatialTree<decltype(dim)::value, CSRBuilder, decltype(cellId)>(weights, positions, alpha, builder);
+        generate(tree);
+    });
+
+    if (!supported) {
+        std::cout << "Dimension " << dimension << " not supported." << std::endl;
+        std::cout << "No edges generated." << std::endl;
+        builder.finishCounting();
     }
 
-    for(const auto& v : local_edges)
-        flush(v.first);
+    return builder.finish();
+}
 
-    return result;
+std::vector<Edge> generateEdges(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
+        double alpha, int samplingSeed) {
+    return generateEdgesImpl(weights, positions, alpha, samplingSeed);
 }
 
+std::vector<Edge> generateEdges(const std::vector<double> &weights, const FlatPositions &positions,
+        double alpha, int samplingSeed) {
+    return generateEdgesImpl(weights, positions, alpha, samplingSeed);
+}
 
-void saveDot(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
-             const std::vector<std::pair<int, int>> &graph, const std::string &file) {
+void generateEdges(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize,
+        unsigned int shard, unsigned int numShards) {
+    generateEdgesImpl(weights, positions, alpha, samplingSeed, consumer, blockSize, shard, numShards);
+}
+
+void generateEdges(const std::vector<double> &weights, const FlatPositions &positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize,
+        unsigned int shard, unsigned int numShards) {
+    generateEdgesImpl(weights, positions, alpha, samplingSeed, consumer, blockSize, shard, numShards);
+}
+
+CSRGraph generateCSR(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
+        double alpha, int samplingSeed) {
+    return generateCSRImpl(weights, positions, alpha, samplingSeed);
+}
+
+CSRGraph generateCSR(const std::vector<double> &weights, const FlatPositions &positions,
+        double alpha, int samplingSeed) {
+    return generateCSRImpl(weights, positions, alpha, samplingSeed);
+}
+
+std::vector<Edge> generateEdges(DoubleView weights, PositionView positions,
+        double alpha, int samplingSeed) {
+    return generateEdgesImpl(weights, positions, alpha, samplingSeed);
+}
+
+void generateEdges(DoubleView weights, PositionView positions,
+        double alpha, int samplingSeed, const EdgeBlockCallback& consumer, std::size_t blockSize,
+        unsigned int shard, unsigned int numShards) {
+    generateEdgesImpl(weights, positions, alpha, samplingSeed, consumer, blockSize, shard, numShards);
+}
+
+CSRGraph generateCSR(DoubleView weights, PositionView positions,
+        double alpha, int samplingSeed) {
+    return generateCSRImpl(weights, positions, alpha, samplingSeed);
+}
+
+
+template<typename PositionContainer>
+static void saveDotImpl(const std::vector<double> &weights, const PositionContainer &positions,
+             const std::vector<Edge> &graph, const std::string &file) {
 
     std::ofstream f{file};
     if(!f.is_open())
         throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
     f << "graph girg {\n\toverlap=scale;\n\n";
-    f << std::fixed;
-    for (int i = 0; i < weights.size(); ++i) {
-        f << '\t' << i << " [label=\""
-          << std::setprecision(2) << weights[i] << std::setprecision(6)
-          << "\", pos=\"";
-        for (auto d = 0u; d < positions[i].size(); ++d)
-            f << (d == 0 ? "" : ",") << positions[i][d];
-        f << "\"];\n";
-    }
+    writeChunked(f, weights.size(), [&] (std::size_t i, std::string& buffer) {
+        buffer += '\t';
+        appendInteger(buffer, i);
+        buffer += " [label=\"";
+        appendFixed(buffer, weights[i], 2);
+        buffer += "\", pos=\"";
+        for (auto d = 0u; d < dimensionOf(positions); ++d) {
+            if (d > 0)
+                buffer += ',';
+            appendFixed(buffer, coordinate(positions, i, d), 6);
+        }
+        buffer += "\"];\n";
+    });
     f << '\n';
-    for (auto &edge : graph)
-        f << '\t' << edge.first << "\t-- " << edge.second << ";\n";
+    writeChunked(f, graph.size(), [&] (std::size_t i, std::string& buffer) {
+        buffer += '\t';
+        appendInteger(buffer, graph[i].first);
+        buffer += "\t-- ";
+        appendInteger(buffer, graph[i].second);
+        buffer += ";\n";
+    });
     f << "}\n";
 }
 
+void saveDot(const std::vector<double> &weights, const std::vector<std::vector<double>> &positions,
+             const std::vector<Edge> &graph, const std::string &file) {
+    saveDotImpl(weights, positions, graph, file);
+}
+
+void saveDot(const std::vector<double> &weights, const FlatPositions &positions,
+             const std::vector<Edge> &graph, const std::string &file) {
+    saveDotImpl(weights, positions, graph, file);
+}
+
+void saveEdgeList(NodeIndex n, const std::vector<Edge> &graph, const std::string &file) {
+    std::ofstream f{file};
+    if(!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f << n << ' ' << graph.size() << "\n\n";
+    writeChunked(f, graph.size(), [&] (std::size_t i, std::string& buffer) {
+        appendInteger(buffer, graph[i].first);
+        buffer += ' ';
+        appendInteger(buffer, graph[i].second);
+        buffer += '\n';
+    });
+}
+
 } // namespace girgs
@@ -0,0 +1,119 @@
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <girgs/MappedPoints.h>
+
+
+namespace girgs {
+
+
+void savePoints(const std::vector<double>& weights, const FlatPositions& positions, const std::string& file) {
+    if (weights.size() != positions.size())
+        throw std::invalid_argument{"Error: need one position per weight"};
+
+    auto header = BinaryPointsHeader();
+    header.model = 0;
+    header.dimension = positions.dimension();
+    header.layout = positions.layout() == FlatPositions::Layout::RowMajor ? 0 : 1;
+    header.n = weights.size();
+
+    std::ofstream f{file, std::ios::binary};
+    if (!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    f.write(reinterpret_cast<const char*>(weights.data()), static_cast<std::streamsize>(weights.size() * sizeof(double)));
+    f.write(reinterpret_cast<const char*>(positions.data()), static_cast<std::streamsize>(positions.size() * positions.dimension() * sizeof(double)));
+    if (!f)
+        throw std::runtime_error{"Error: failed to write file \"" + file + '\"'};
+}
+
+
+MappedPoints::MappedPoints(const std::string& file) {
+    auto fail = [&] (const std::string& reason) {
+        throw std::runtime_error{"Error: \"" + file + "\" " + reason};
+    };
+
+#ifndef _WIN32
+    const auto fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        fail("cannot be opened");
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(BinaryPointsHeader))) {
+        ::close(fd);
+        fail("is no binary points file of version 1");
+    }
+    m_bytes = static_cast<std::size_t>(info.st_size);
+
+    auto* data = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED)
+        fail("cannot be mapped");
+    m_data = data;
+
+    // the generators read the weights and positions front to back
+    ::madvise(data, m_bytes, MADV_SEQUENTIAL);
+#else
+    std::ifstream f{file, std::ios::binary | std::ios::ate};
+    if (!f.is_open())
+        fail("cannot be opened");
+    m_bytes = static_cast<std::size_t>(f.tellg());
+    if (m_bytes < sizeof(BinaryPointsHeader))
+        fail("is no binary points file of version 1");
+
+    m_buffer.resize((m_bytes + sizeof(double) - 1) / sizeof(double));
+    f.seekg(0);
+    if (!f.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_bytes)))
+        fail("cannot be read");
+    m_data = m_buffer.data();
+#endif
+
+    const auto expected = BinaryPointsHeader();
+    const auto& h = header();
+    if (h.magic != expected.magic || h.version != expected.version || h.model != 0 || h.layout > 1 || h.dimension < 1 || h.dimension > 10) {
+        unmap();
+        fail("is no binary points file of version 1 with weights and torus positions");
+    }
+
+    // divide rather than multiply, as a crafted n could overflow n * (1 + dimension)
+    const auto num_values = (m_bytes - sizeof(BinaryPointsHeader)) / sizeof(double);
+    if ((m_bytes - sizeof(BinaryPointsHeader)) % sizeof(double) || num_values % (1 + h.dimension) || h.n != num_values / (1 + h.dimension)) {
+        unmap();
+        fail("is truncated or has a wrong size");
+    }
+}
+
+MappedPoints::~MappedPoints() {
+    unmap();
+}
+
+void MappedPoints::unmap() noexcept {
+#ifndef _WIN32
+    if (m_data)
+        ::munmap(const_cast<void*>(m_data), m_bytes);
+#else
+    m_buffer.clear();
+#endif
+    m_data = nullptr;
+}
+
+DoubleView MappedPoints::weights() const noexcept {
+    const auto* base = reinterpret_cast<const double*>(static_cast<const char*>(m_data) + sizeof(BinaryPointsHeader));
+    return {base, size()};
+}
+
+PositionView MappedPoints::positions() const noexcept {
+    const auto* base = reinterpret_cast<const double*>(static_cast<const char*>(m_data) + sizeof(BinaryPointsHeader));
+    const auto layout = header().layout == 0 ? PositionView::Layout::RowMajor : PositionView::Layout::ColumnMajor;
+    return {base + size(), size(), dimension(), layout};
+}
+
+
+} // namespace girgs
@@ -0,0 +1,56 @@
+#include <stdexcept>
+
+#include <girgs/TypeIKernel.h>
+
+
+namespace girgs {
+
+
+bool typeIKernelAvailable(TypeIKernelImplementation impl) noexcept {
+#ifdef GIRGS_HAS_AVX_KERNELS
+    // may run before the constructors of the runtime library, which initialise the cpu model otherwise
+    __builtin_cpu_init();
+#endif
+
+    switch (impl) {
+        case TypeIKernelImplementation::Generic:
+            return true;
+#ifdef GIRGS_HAS_AVX_KERNELS
+        case TypeIKernelImplementation::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case TypeIKernelImplementation::AVX512:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+TypeIKernelImplementation detectTypeIKernel() noexcept {
+    for (auto impl : {TypeIKernelImplementation::AVX512, TypeIKernelImplementation::AVX2})
+        if (typeIKernelAvailable(impl))
+            return impl;
+    return TypeIKernelImplementation::Generic;
+}
+
+void setTypeIKernel(TypeIKernelImplementation impl) {
+    if (!typeIKernelAvailable(impl))
+        throw std::invalid_argument{"Error: type I kernel " + typeIKernelName(impl) + " is not available on this cpu"};
+    TypeIKernelDetails::g_selected = impl;
+}
+
+std::string typeIKernelName(TypeIKernelImplementation impl) {
+    switch (impl) {
+        case TypeIKernelImplementation::Generic: return "Generic";
+        case TypeIKernelImplementation::AVX2:    return "AVX2";
+        case TypeIKernelImplementation::AVX512:  return "AVX512";
+        default:                                 return "unknown";
+    }
+}
+
+namespace TypeIKernelDetails {
+TypeIKernelImplementation g_selected = detectTypeIKernel();
+}
+
+
+} // namespace girgs
@@ -5,280 +5,653 @@
 #include <cmath>
 #include <vector>
 #include <limits>
+#include <utility>
 
+#include <omp.h>
+
+#include <girgs/Index.h>
 #include <girgs/WeightScaling.h>
 
 namespace girgs {
 
-// helper for scale weights
-static double exponentialSearch(const std::function<double(double)> &f, double desiredValue, double accuracy = 0.02, double lower = 1.0,
-                                double upper = 2.0) {
+namespace {
 
-    // scale interval up if necessary
-    while (f(upper) < desiredValue) {
-        lower = upper;
-        upper *= 2;
-    }
+/// number of elements per block of the deterministic reductions
+constexpr std::size_t kBlockSize = 1 << 14;
 
-    // scale interval down if necessary
-    while (f(lower) > desiredValue) {
-        upper = lower;
-        lower /= 2;
-    }
+/**
+ * Calls block(begin, end) for the consecutive blocks of [0, count) in parallel and returns the results in block order.
+ * Summing them up in this order makes a reduction independent of the number of threads.
+ */
+template<typename Result, typename Block>
+std::vector<Result> reduceBlocks(std::size_t count, Block block) {
+    const auto num_blocks = static_cast<long long>((count + kBlockSize - 1) / kBlockSize);
+    auto results = std::vector<Result>(num_blocks);
 
-    // do binary search
-    auto mid = f((upper + lower) / 2);
-    while (std::abs(mid - desiredValue) > accuracy) {
-        if (mid < desiredValue)
-            lower = (upper + lower) / 2;
-        else
-            upper = (upper + lower) / 2;
-        mid = f((upper + lower) / 2);
+    #pragma omp parallel for schedule(static)
+    for (long long b = 0; b < num_blocks; ++b) {
+        const auto begin = static_cast<std::size_t>(b) * kBlockSize;
+        results[b] = block(begin, std::min(begin + kBlockSize, count));
     }
 
-    return (upper + lower) / 2;
+    return results;
 }
 
+/// number of threads worth using for size elements
+int threadsFor(std::size_t size) {
+    constexpr std::size_t kMinPerThread = 1 << 16;
+    return static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(omp_get_max_threads(), size / kMinPerThread)));
+}
 
-/// Safe some time by not sorting the complete weights vector, but only the largest elements
-class LazySorter {
-public:
-    using iterator = typename std::vector<double>::iterator;
+/// moves all elements >= thresh to the front of data and returns their number; the order is unspecified
+std::size_t parallelPartition(double* data, std::size_t size, double thresh) {
+    const auto is_large = [thresh] (double x) { return x >= thresh; };
+    const auto threads = threadsFor(size);
+    if (threads == 1)
+        return static_cast<std::size_t>(std::partition(data, data + size, is_large) - data);
+
+    // every thread partitions a chunk: [bounds[t], bounds[t] + large[t]) are large, the rest of the chunk is small
+    std::vector<std::size_t> bounds(threads + 1);
+    for (int t = 0; t <= threads; ++t)
+        bounds[t] = size * t / threads;
+    std::vector<std::size_t> large(threads);
+
+    #pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int t = 0; t < threads; ++t)
+        large[t] = static_cast<std::size_t>(std::partition(data + bounds[t], data + bounds[t+1], is_large) - (data + bounds[t]));
+
+    const auto num_large = std::accumulate(large.begin(), large.end(), std::size_t{0});
+
+    // small elements in front of num_large and large elements behind are swapped pairwise
+    using Interval = std::pair<std::size_t, std::size_t>;
+    std::vector<Interval> misplaced_small, misplaced_large;
+    for (int t = 0; t < threads; ++t) {
+        const auto split = bounds[t] + large[t];
+        if (split < std::min(bounds[t+1], num_large))
+            misplaced_small.emplace_back(split, std::min(bounds[t+1], num_large));
+        if (std::max(bounds[t], num_large) < split)
+            misplaced_large.emplace_back(std::max(bounds[t], num_large), split);
+    }
 
-    LazySorter(std::vector<double>& sweights):
-        m_sweights(sweights), m_sorted_end(sweights.begin())
-    {}
+    // the i-th misplaced position of intervals
+    const auto position = [] (const std::vector<Interval>& intervals, std::size_t i) {
+        auto it = intervals.begin();
+        while (i >= it->second - it->first) {
+            i -= it->second - it->first;
+            ++it;
+        }
+        return std::make_pair(it, it->first + i);
+    };
 
-    /// Ensures that
-    iterator sort_downto(double thresh) {
-        if (m_lower > thresh) {
-            // we need more points, make sure we have more!
-            assert(m_sorted_end != m_sweights.end());
+    auto num_misplaced = std::size_t{0};
+    for (auto& interval : misplaced_small)
+        num_misplaced += interval.second - interval.first;
 
-            // move all not yet sorted elements larger than the threshold directly next to the sorted ones
-            auto new_ps_end = std::partition(m_sorted_end, m_sweights.end(), [=](double x) { return x >= thresh; });
-            if (new_ps_end == m_sorted_end) return m_sorted_end;
+    #pragma omp parallel num_threads(threads)
+    {
+        const auto tid = static_cast<std::size_t>(omp_get_thread_num());
+        const auto num_threads = static_cast<std::size_t>(omp_get_num_threads());
+        const auto begin = num_misplaced * tid / num_threads;
+        const auto end = num_misplaced * (tid + 1) / num_threads;
+
+        if (begin < end) {
+            auto small = position(misplaced_small, begin);
+            auto large = position(misplaced_large, begin);
+            for (auto i = begin; i < end; ++i) {
+                std::swap(data[small.second], data[large.second]);
+                if (++small.second == small.first->second && i + 1 < end)
+                    small.second = (++small.first)->first;
+                if (++large.second == large.first->second && i + 1 < end)
+                    large.second = (++large.first)->first;
+            }
+        }
+    }
 
-            std::sort(m_sorted_end, new_ps_end, std::greater<double>());
-            assert(std::is_sorted(m_sweights.begin(), m_sorted_end, std::greater<double>()));
+    return num_large;
+}
 
-            m_sorted_end = new_ps_end;
-            m_lower = (m_sorted_end == m_sweights.end()) ? std::numeric_limits<double>::min() : thresh;
-            return m_sorted_end;
+/// sorts data in descending order: the threads sort chunks which are then merged pairwise
+void parallelSort(double* data, std::size_t size) {
+    const auto threads = threadsFor(size);
+    std::vector<std::size_t> bounds(threads + 1);
+    for (int t = 0; t <= threads; ++t)
+        bounds[t] = size * t / threads;
+
+    #pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int t = 0; t < threads; ++t)
+        std::sort(data + bounds[t], data + bounds[t+1], std::greater<double>());
+
+    for (int width = 1; width < threads; width *= 2) {
+        #pragma omp parallel for num_threads(threads) schedule(static, 1)
+        for (int t = 0; t < threads - width; t += 2 * width)
+            std::inplace_merge(data + bounds[t], data + bounds[t + width], data + bounds[std::min(t + 2 * width, threads)],
+                               std::greater<double>());
+    }
+}
+
+/// number of the first size sorted weights that are >= thresh
+std::size_t countAtLeast(const WeightStatistics& statistics, std::size_t size, double thresh) {
+    auto lower = std::size_t{0};
+    auto upper = size;
+    while (lower < upper) {
+        const auto mid = lower + (upper - lower) / 2;
+        if (statistics.sorted(mid) >= thresh)
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+    return lower;
+}
+
+/**
+ * Exponential search for the argument c with f(c) close to desiredValue for an increasing function f.
+ * The search asks for one value of f at a time, so that several searches can advance in lockstep.
+ */
+class ExponentialSearch {
+public:
+    explicit ExponentialSearch(double desiredValue, double accuracy = 0.02, double lower = 1.0, double upper = 2.0)
+        : m_desired(desiredValue), m_accuracy(accuracy), m_lower(lower), m_upper(upper)
+    {}
 
-        } else {
-            // the splitter is within our already sorted segment
-            return std::lower_bound(m_sweights.begin(), m_sorted_end, thresh,
-                                    [&] (double x, double thresh) {return x > thresh;});
+    bool done() const noexcept { return m_phase == Phase::Done; }
 
+    /// the argument at which f has to be evaluated next
+    double point() const noexcept {
+        switch (m_phase) {
+            case Phase::ScaleUp:   return m_upper;
+            case Phase::ScaleDown: return m_lower;
+            default:               return (m_upper + m_lower) / 2;
         }
-    };
+    }
+
+    /// continues the search with value = f(point())
+    void feed(double value) {
+        switch (m_phase) {
+            case Phase::ScaleUp:
+                // scale interval up if necessary
+                if (value < m_desired) {
+                    m_lower = m_upper;
+                    m_upper *= 2;
+                } else {
+                    m_phase = Phase::ScaleDown;
+                }
+                break;
+
+            case Phase::ScaleDown:
+                // scale interval down if necessary
+                if (value > m_desired) {
+                    m_upper = m_lower;
+                    m_lower /= 2;
+                } else {
+                    m_phase = Phase::Bisect;
+                }
+                break;
+
+            case Phase::Bisect:
+                // do binary search
+                if (std::abs(value - m_desired) > m_accuracy) {
+                    if (value < m_desired)
+                        m_lower = (m_upper + m_lower) / 2;
+                    else
+                        m_upper = (m_upper + m_lower) / 2;
+                } else {
+                    m_phase = Phase::Done;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
 
+    double result() const noexcept { return (m_upper + m_lower) / 2; }
 
 private:
-    std::vector<double>& m_sweights;
-    iterator m_sorted_end;
-    double m_lower{std::numeric_limits<double>::max()};
+    enum class Phase { ScaleUp, ScaleDown, Bisect, Done };
+
+    double m_desired;
+    double m_accuracy;
+    double m_lower;
+    double m_upper;
+    Phase m_phase = Phase::ScaleUp;
 };
 
-// helper for scale weights
-double estimateWeightScalingThreshold(const std::vector<double> &weights, double desiredAvgDegree, int dimension) {
-    std::vector<double> sweights(weights.size());
-    LazySorter lazy_sorter(sweights);
 
-    // compute some constant stuff
-    const auto n = weights.size();
-    auto max_weight = 0.0;
-    auto W = 0.0, sq_W = 0.0;
+/**
+ * Estimated average degree as function of the constant c, either of the threshold model or for a finite alpha.
+ * An evaluation only reads the statistics, so the functions of several targets can be evaluated concurrently.
+ */
+class AverageDegree {
+public:
+    AverageDegree(WeightStatistics& statistics, int dimension, double alpha, bool threshold)
+        : m_dimension(dimension)
+        , m_alpha(alpha)
+        , m_threshold(threshold)
+        , m_n(static_cast<double>(statistics.size()))
+        , m_W(statistics.totalWeight())
+        , m_max_weight(statistics.maxWeight())
     {
-#ifndef _MSC_VER
-        #pragma omp parallel for reduction(+:W, sq_W), reduction(max: max_weight)
-#endif
-        for (int i = 0; i < n; ++i) {
-            const auto each = weights[i];
-            sweights[i] = each; // copy to sweights
-
-            W += each;
-            sq_W += each * each;
-            max_weight = std::max(max_weight, each);
+        if (threshold) {
+            m_sq_W = statistics.sumOfSquares();
+            return;
         }
+
+        assert(alpha != 1.0); // somehow breaks for alpha 1.0
+
+        // compute some constant stuff
+        const auto W = m_W;
+        m_W_alpha = std::pow(W, alpha);
+        const auto sum_sq_w = statistics.sumOfSquares() / W;                    // sum_{v\in V} (w_v^2/W)
+        const auto sum_sq_w_a = statistics.squaredPowerSum(alpha) / m_W_alpha;  // sum_{v\in V} (w_v^2/W)^\alpha
+
+        //   sum_{u\in V} sum_{v\in V} (wu*wv/W)^\alpha
+        // = sum_{u\in V} wu^\alpha * sum_{v\in V} (wv/W)^\alpha
+        const auto sum_wwW_a = statistics.powerSum(alpha) * (statistics.powerSum(alpha) / m_W_alpha);
+        m_max_w_W = m_max_weight / W;
+
+        m_factor1 = (W - sum_sq_w) * (1 + 1 / (alpha - 1)) * (1 << dimension);
+        m_factor2 = pow(2, alpha * dimension) / (alpha - 1) * (sum_wwW_a - sum_sq_w_a);
     }
 
-    // my function to do the exponential search on
-    auto f = [=, &sweights, &lazy_sorter](double c) {
-        
-        // compute overestimation
-        const auto pow2c = std::pow(2.0 * c, dimension);
-		const auto overestimation = pow2c * (W - sq_W / W);
+    bool threshold() const noexcept { return m_threshold; }
+    double alpha() const noexcept { return m_alpha; }
+
+    /// the evaluation at c needs the rich club of all weights >= richClubThreshold(c)
+    double richClubThreshold(double c) const {
+        if (m_threshold)
+            return m_W / std::pow(2.0 * c, m_dimension) / m_max_weight;
+        return std::exp(m_dimension * std::log(0.5 / std::pow(c, 1.0 / m_alpha / m_dimension)) - log(m_max_w_W));
+    }
 
-		// compute rich club
-		const auto richclub_end = lazy_sorter.sort_downto(W / pow2c / max_weight);
-		assert(richclub_end <= sweights.end());
+    /// the estimate at c; requires the sorted rich club of size num_richclub and for a finite alpha its powers
+    double operator()(const WeightStatistics& statistics, const WeightStatistics::RichClubPowers* powers,
+                      std::size_t num_richclub, double c) const {
+        assert(num_richclub <= statistics.size());
+        return m_threshold ? thresholdDegree(statistics, num_richclub, c)
+                           : generalDegree(statistics, powers, num_richclub, c);
+    }
+
+    /// the scaling of the weights that corresponds to the constant c
+    double scaling(double c) const {
+        if (m_threshold) {
+            /*
+             * edge iff dist < c(wi*wj/W)^(1/d)
+             *
+             * c(wi*wj/W)^(1/d)
+             * = ( c^d * wi*wj/W )^(1/d)
+             * = ( c^d*wi * c^d*wi / (c^d*W) )^(1/d)
+             *
+             * so we can just scale all weights by c^d
+             */
+            return pow(c, m_dimension);
+        }
+
+        /*
+         * Pr(edge) = Pr(c * 1/dist^ad * (wi*wj/W)^a )
+         *
+         * c * (wi*wj/W)^a
+         * = (c^{1/a} wi*wj/W)^a
+         * = (c^{1/a}wi* (c^{1/a}wj / (c^{1/a}W)^a
+         *
+         * so we can just scale all weights by (c^{1/a}
+         */
+        return pow(c, 1 / m_alpha);
+    }
+
+private:
+    double thresholdDegree(const WeightStatistics& statistics, std::size_t num_richclub, double c) const {
+        const auto W = m_W;
+
+        // compute overestimation
+        const auto pow2c = std::pow(2.0 * c, m_dimension);
+        const auto overestimation = pow2c * (W - m_sq_W / W);
+
+        // subtract error; every block of the rich club starts its sweep with a binary search
+        const auto threshold = [&] (std::size_t i) { return 1.0 / (statistics.sorted(i) / W) / pow2c; };
+        const auto blocks = reduceBlocks<double>(num_richclub, [&] (std::size_t begin, std::size_t end) {
+            auto error = 0.0;
+            auto w2 = countAtLeast(statistics, num_richclub, threshold(end - 1));
+            for (auto w1 = end; w1-- > begin; ) {
+                const auto fac = statistics.sorted(w1) / W;
+                const auto my_thres = threshold(w1);
+
+                for(; w2 < num_richclub && statistics.sorted(w2) >= my_thres; ++w2);
+
+                /**
+                  * sum_{k < j, k != i}{ std::pow(2*c,dimension)*(w1*w_k/W)-1.0 }
+                  * = sum_{k < j, k != i}{ std::pow(2*c,dimension)*(w1*w_k/W) } - j
+                  * = sum_{k < j}{ std::pow(2*c,dimension)*(w1*w_k/W) } - j - (0 if j < i else std::pow(2*c,dimension)*(w1*w_i/W) - 1)
+                  * = pow2c * w1/W * (sum_j{w_j}) - j - (0 if j < i else pow2c*(w1/W)*w_i - 1)
+                  */
+
+                error += statistics.prefixSum(w2) * pow2c * fac - static_cast<double>(w2);
+
+                if (w2 >= w1) {
+                    // we have to subtract the self-contribution of x == y
+                    error -= pow2c * fac * statistics.sorted(w1) - 1.0;
+                }
+            }
+            return error;
+        });
 
-        // subtract error
         auto error = 0.0;
+        for (auto block : blocks)
+            error += block;
+
+        return (overestimation - error) / m_n;
+    }
 
-        auto w2sum = 0.0;
-        auto w2 = sweights.cbegin();
-        for(auto w1 = richclub_end; w1 > sweights.begin(); ) {
-			--w1; // msvc throws when decrementing beyond begin iterator
-            const auto fac = *w1 / W;
-            const auto my_thres = 1.0 / fac / pow2c;
+    double generalDegree(const WeightStatistics& statistics, const WeightStatistics::RichClubPowers* powers,
+                         std::size_t num_richclub, double c) const {
+        const auto W = m_W;
+        const auto W_alpha = m_W_alpha;
+        const auto alpha = m_alpha;
+        const auto dimension = m_dimension;
 
-            for(; w2 < richclub_end && *w2 >= my_thres; w2sum += *(w2++));
+        const auto long_and_short_with_error = pow(c, 1 / alpha) * m_factor1 - c * m_factor2;
 
-            /**
-              * sum_{k < j, k != i}{ std::pow(2*c,dimension)*(w1*w_k/W)-1.0 }
-              * = sum_{k < j, k != i}{ std::pow(2*c,dimension)*(w1*w_k/W) } - j
-              * = sum_{k < j}{ std::pow(2*c,dimension)*(w1*w_k/W) } - j - (0 if j < i else std::pow(2*c,dimension)*(w1*w_i/W) - 1)
-              * = pow2c * w1/W * (sum_j{w_j}) - j - (0 if j < i else pow2c*(w1/W)*w_i - 1)
-              */
+        if (!num_richclub)
+            return long_and_short_with_error / m_n;
 
-            error += w2sum * pow2c * fac - (std::distance(sweights.cbegin(), w2));
+        // get error for long and short edges
+        const auto thresh = std::exp( (std::log(0.5) * dimension - std::log(c) / alpha) );
 
-            if (w2 >= w1) {
-                // we have to subtract the self-contribution of x == y
-                error -= pow2c * fac * (*w1) - 1.0;
+        // every block of the rich club starts its sweep with a binary search
+        struct Terms {
+            double w_terms;
+            double w_alpha_terms;
+            std::size_t num_terms;
+        };
+        const auto blocks = reduceBlocks<Terms>(num_richclub, [&] (std::size_t begin, std::size_t end) {
+            auto terms = Terms{0.0, 0.0, 0};
+            auto i2 = countAtLeast(statistics, num_richclub, thresh * W / statistics.sorted(end - 1));
+            for (auto i1 = end; i1-- > begin; ) {
+                const auto w1 = statistics.sorted(i1);
+                const auto pow_w1 = powers->powers[i1];
+                const auto my_thres = thresh * W / w1;
+                for (; i2 < num_richclub && statistics.sorted(i2) >= my_thres; ++i2);
+
+                terms.num_terms     += i2;
+                terms.w_terms       += w1     * statistics.prefixSum(i2) / W;
+                terms.w_alpha_terms += pow_w1 * powers->prefix[i2]       / W_alpha;
+
+                if (i2 >= i1) {
+                    terms.num_terms--;
+                    terms.w_terms       -= w1     * w1     / W;
+                    terms.w_alpha_terms -= pow_w1 * pow_w1 / W_alpha;
+                }
             }
+            return terms;
+        });
+
+        auto w_terms = 0.0;
+        auto w_alpha_terms = 0.0;
+        size_t num_terms = 0;
+        for (auto& block : blocks) {
+            w_terms       += block.w_terms;
+            w_alpha_terms += block.w_alpha_terms;
+            num_terms     += block.num_terms;
         }
 
-        return (overestimation - error) / n;
-    };
+        auto short_error = (1 << dimension) * pow(c, 1 / alpha) * w_terms - num_terms;
+        auto long_error = c * dimension * (1 << dimension) / (dimension - alpha * dimension) *
+            (std::pow(0.5, dimension - alpha * dimension) * w_alpha_terms -
+                std::pow(c, 1.0 / alpha - 1.0) * w_terms);
 
-    // do exponential search on expected average degree function
-    auto estimated_c = exponentialSearch(f, desiredAvgDegree);
-
-    /*
-     * edge iff dist < c(wi*wj/W)^(1/d)
-     *
-     * c(wi*wj/W)^(1/d)
-     * = ( c^d * wi*wj/W )^(1/d)
-     * = ( c^d*wi * c^d*wi / (c^d*W) )^(1/d)
-     *
-     * so we can just scale all weights by c^d
-     */
-    return pow(estimated_c, dimension); // return scaling
-}
+        return (long_and_short_with_error - short_error - long_error) / m_n;
+    }
 
+    int m_dimension;
+    double m_alpha;
+    bool m_threshold;
+    double m_n;
+    double m_W;
+    double m_max_weight;
+
+    // threshold model
+    double m_sq_W = 0.0;
+
+    // finite alpha
+    double m_W_alpha = 0.0;
+    double m_max_w_W = 0.0;
+    double m_factor1 = 0.0;
+    double m_factor2 = 0.0;
+};
 
-// helper for scale weights
-double estimateWeightScaling(const std::vector<double> &weights, double desiredAvgDegree, int dimension, double alpha) {
-    assert(alpha != 1.0); // somehow breaks for alpha 1.0
-
-    // compute some constant stuff
-    auto W = std::accumulate(weights.begin(), weights.end(), 0.0);
-    auto sum_sq_w = 0.0; // sum_{v\in V} (w_v^2/W)
-    auto sum_w_a = 0.0; // sum_{v\in V} (w_v  /W)^\alpha
-    auto sum_sq_w_a = 0.0; // sum_{v\in V} (w_v^2/W)^\alpha
-
-    //   sum_{u\in V} sum_{v\in V} (wu*wv/W)^\alpha
-    // = sum_{u\in V} sum_{v\in V} wu^\alpha * (wv/W)^\alpha
-    // = sum_{u\in V} wu^\alpha sum_{v\in V} (wv/W)^\alpha
-    auto sum_wwW_a = 0.0;
-    auto max_w = 0.;
-    const auto n = static_cast<int>(weights.size());
-
-    // this loop causes >= 70% of runtime
-    std::vector<double> sweights(n);
-    LazySorter lazy_sorter(sweights);
-    {
-#ifndef _MSC_VER
-        #pragma omp parallel for reduction(+:sum_sq_w, sum_w_a, sum_sq_w_a, sum_wwW_a), reduction(max:max_w)
-#endif
-        for (int i = 0; i < n; ++i) {
-            const auto each = weights[i];
-            sweights[i] = each; // copy in parallel
-
-            const auto each_W = each / W;
-            const auto pow_each = pow(each, alpha);
-            const auto pow_each_W = pow(each / W, alpha);
-
-            sum_sq_w += each * each_W;
-            sum_wwW_a += pow_each;
-            sum_w_a += pow_each_W;
-            sum_sq_w_a += pow_each * pow_each_W;
-            max_w = std::max(each, max_w);
+
+/**
+ * Runs the exponential searches of all functions in lockstep and returns the scalings.
+ * In each step the rich club is extended once for all searches, then the functions are evaluated in parallel.
+ */
+std::vector<double> solveScalings(WeightStatistics& statistics, const std::vector<AverageDegree>& functions,
+                                  const std::vector<double>& desiredAvgDegrees) {
+    assert(functions.size() == desiredAvgDegrees.size());
+    const auto num_functions = functions.size();
+
+    std::vector<ExponentialSearch> searches;
+    for (auto desired : desiredAvgDegrees)
+        searches.emplace_back(desired);
+
+    std::vector<std::size_t> active;
+    std::vector<std::size_t> num_richclub(num_functions);
+    std::vector<const WeightStatistics::RichClubPowers*> powers(num_functions, nullptr);
+    std::vector<double> values(num_functions);
+
+    while (true) {
+        active.clear();
+        for (std::size_t i = 0; i < num_functions; ++i)
+            if (!searches[i].done())
+                active.push_back(i);
+        if (active.empty())
+            break;
+
+        // partition the unsorted weights once for the largest rich club of this step
+        if (active.size() > 1) {
+            auto lowest = std::numeric_limits<double>::max();
+            for (auto i : active)
+                lowest = std::min(lowest, functions[i].richClubThreshold(searches[i].point()));
+            statistics.richClub(lowest);
+        }
+
+        // compute rich club and precompute new pows in case it grew
+        for (auto i : active) {
+            num_richclub[i] = statistics.richClub(functions[i].richClubThreshold(searches[i].point()));
+            if (!functions[i].threshold() && num_richclub[i])
+                powers[i] = &statistics.preparePowers(functions[i].alpha(), num_richclub[i]);
         }
+
+        const auto num_active = static_cast<long long>(active.size());
+        #pragma omp parallel for schedule(dynamic, 1) if(num_active > 1)
+        for (long long k = 0; k < num_active; ++k) {
+            const auto i = active[k];
+            values[i] = functions[i](statistics, powers[i], num_richclub[i], searches[i].point());
+        }
+
+        for (auto i : active)
+            searches[i].feed(values[i]);
     }
-    sum_wwW_a *= sum_w_a;
-    const auto max_w_W = max_w / W;
 
-    const auto factor1 = (W - sum_sq_w) * (1 + 1 / (alpha - 1)) * (1 << dimension);
-    const auto factor2 = pow(2, alpha * dimension) / (alpha - 1) * (sum_wwW_a - sum_sq_w_a);
+    std::vector<double> scalings(num_functions);
+    for (std::size_t i = 0; i < num_functions; ++i)
+        scalings[i] = functions[i].scaling(searches[i].result());
+    return scalings;
+}
+
+} // namespace
 
-    const auto W_alpha = std::pow(W, alpha);
 
-    // pow_weights[i] = std::pow(sweights[i], alpha) for all elements of the rich club
-    std::vector<double> pow_weights;
+LazySorter::LazySorter(std::vector<double> weights)
+    : m_sweights(std::move(weights))
+{}
 
-    auto f = [&] (double c) {
-        const auto long_and_short_with_error = pow(c, 1 / alpha) * factor1 - c * factor2;
+std::size_t LazySorter::sortDownto(double thresh) {
+    if (m_lower > thresh && m_sorted_end < m_sweights.size()) {
+        // move all not yet sorted elements larger than the threshold directly next to the sorted ones
+        const auto num_new = parallelPartition(m_sweights.data() + m_sorted_end, m_sweights.size() - m_sorted_end, thresh);
+        parallelSort(m_sweights.data() + m_sorted_end, num_new);
 
-        const auto rich_thresh = std::exp(dimension * std::log(0.5 / std::pow(c, 1.0 / alpha / dimension)) - log(max_w_W));
-        const auto richclub_end = lazy_sorter.sort_downto(rich_thresh);
-        const auto num_richclub = static_cast<int>(std::distance(sweights.begin(), richclub_end));
+        m_sorted_end += num_new;
+        m_lower = thresh;
+        assert(std::is_sorted(m_sweights.begin(), m_sweights.begin() + m_sorted_end, std::greater<double>()));
+        return m_sorted_end;
+    }
 
-        if (!num_richclub)
-            return long_and_short_with_error / n;
+    // the splitter is within our already sorted segment
+    return static_cast<std::size_t>(std::distance(m_sweights.cbegin(),
+        std::lower_bound(m_sweights.cbegin(), m_sweights.cbegin() + m_sorted_end, thresh,
+                         [] (double x, double thresh) { return x > thresh; })));
+}
 
-        assert(num_richclub <= n);
 
-        // precompute new pows in case the richclub grew
-        pow_weights.reserve(n / num_richclub > 2 ? num_richclub : n);
-        while(pow_weights.size() < num_richclub) {
-            pow_weights.push_back(std::pow(sweights[pow_weights.size()], alpha));
+WeightStatistics::WeightStatistics(const std::vector<double>& weights)
+    : m_sorter(weights)
+    , m_prefix(1, 0.0)
+{
+    struct Sums { double total, squares, max; };
+    const auto blocks = reduceBlocks<Sums>(weights.size(), [&] (std::size_t begin, std::size_t end) {
+        auto sums = Sums{0.0, 0.0, 0.0};
+        for (auto i = begin; i < end; ++i) {
+            sums.total += weights[i];
+            sums.squares += weights[i] * weights[i];
+            sums.max = std::max(sums.max, weights[i]);
         }
+        return sums;
+    });
 
-        // get error for long and short edges
-        const auto thresh = std::exp( (std::log(0.5) * dimension - std::log(c) / alpha) );
+    for (auto& block : blocks) {
+        m_total += block.total;
+        m_squares += block.squares;
+        m_max = std::max(m_max, block.max);
+    }
+}
 
-        int i2 = 0;
-        auto w2_sum       = 0.0;
-        long double w2_alpha_sum = 0.0;
+double WeightStatistics::powerSum(double alpha) {
+    preparePowerSums({alpha});
+    return m_power_sums.at(alpha).first;
+}
 
-        auto w_terms = 0.0;
-        auto w_alpha_terms = 0.0;
-        size_t num_terms = 0;
+double WeightStatistics::squaredPowerSum(double alpha) {
+    preparePowerSums({alpha});
+    return m_power_sums.at(alpha).second;
+}
 
-        for(auto i1 = num_richclub; i1-- > 0; ) {
-            const auto my_thres = thresh * W / sweights[i1];
-            for (; i2 < num_richclub && sweights[i2] >= my_thres; ++i2) {
-                w2_sum       += sweights[i2];
-                w2_alpha_sum += pow_weights[i2];
+void WeightStatistics::preparePowerSums(const std::vector<double>& alphas) {
+    std::vector<double> missing;
+    for (auto alpha : alphas)
+        if (!m_power_sums.count(alpha) && std::find(missing.begin(), missing.end(), alpha) == missing.end())
+            missing.push_back(alpha);
+    if (missing.empty())
+        return;
+
+    using Sums = std::vector<std::pair<double, double>>;
+    const auto& weights = m_sorter.weights();
+    const auto blocks = reduceBlocks<Sums>(weights.size(), [&] (std::size_t begin, std::size_t end) {
+        auto sums = Sums(missing.size(), std::make_pair(0.0, 0.0));
+        for (auto i = begin; i < end; ++i) {
+            for (std::size_t a = 0; a < missing.size(); ++a) {
+                const auto pow_each = std::pow(weights[i], missing[a]);
+                sums[a].first += pow_each;
+                sums[a].second += pow_each * pow_each;
             }
+        }
+        return sums;
+    });
+
+    for (std::size_t a = 0; a < missing.size(); ++a) {
+        auto sums = std::make_pair(0.0, 0.0);
+        for (auto& block : blocks) {
+            sums.first += block[a].first;
+            sums.second += block[a].second;
+        }
+        m_power_sums[missing[a]] = sums;
+    }
+}
 
-            num_terms     += i2;
-            w_terms       += sweights[i1]    * w2_sum       / W;
-            w_alpha_terms += pow_weights[i1] * w2_alpha_sum / W_alpha;
+std::size_t WeightStatistics::richClub(double thresh) {
+    const auto result = m_sorter.sortDownto(thresh);
 
-            if (i2 >= i1) {
-                num_terms--;
-                w_terms       -= sweights[i1]    * sweights[i1]    / W;
-                w_alpha_terms -= pow_weights[i1] * pow_weights[i1] / W_alpha;
-            }
-        }
+    // extend the prefix sums to the sorted part
+    const auto& weights = m_sorter.weights();
+    for (auto i = m_prefix.size() - 1; i < m_sorter.sortedSize(); ++i)
+        m_prefix.push_back(m_prefix.back() + weights[i]);
 
-        auto short_error = (1 << dimension) * pow(c, 1 / alpha) * w_terms - num_terms;
-        auto long_error = c * dimension * (1 << dimension) / (dimension - alpha * dimension) *
-            (std::pow(0.5, dimension - alpha * dimension) * w_alpha_terms -
-                std::pow(c, 1.0 / alpha - 1.0) * w_terms);
+    return result;
+}
 
-        return (long_and_short_with_error - short_error - long_error) / n;
-    };
+const WeightStatistics::RichClubPowers& WeightStatistics::preparePowers(double alpha, std::size_t size) {
+    assert(size <= m_sorter.sortedSize());
+    auto& table = m_powers[alpha];
+    if (size <= table.powers.size())
+        return table;
+
+    const auto& weights = m_sorter.weights();
+    const auto begin = static_cast<long long>(table.powers.size());
+    table.powers.resize(size);
+    #pragma omp parallel for schedule(static)
+    for (long long i = begin; i < static_cast<long long>(size); ++i)
+        table.powers[i] = std::pow(weights[i], alpha);
+
+    for (auto i = static_cast<std::size_t>(begin); i < size; ++i)
+        table.prefix.push_back(table.prefix.back() + table.powers[i]);
+
+    return table;
+}
+
+
+WeightScalingSolver::WeightScalingSolver(const std::vector<double>& weights)
+    : m_statistics(weights)
+{}
+
+double WeightScalingSolver::scaling(double desiredAvgDegree, int dimension, double alpha) {
+    return scalings({{desiredAvgDegree, dimension, alpha}}).front();
+}
+
+std::vector<double> WeightScalingSolver::scalings(const std::vector<WeightScalingTarget>& targets) {
+    // for alpha > 8 we use the estimation for threshold graphs due to numerical difficulties
+    std::vector<double> alphas;
+    for (auto& target : targets) {
+        if (target.alpha > 8.0)
+            continue;
+        if (!(target.alpha > 0.0 && target.alpha != 1.0))
+            throw("I do not know how to scale weights for desired alpha :(");
+        alphas.push_back(target.alpha);
+    }
+    m_statistics.preparePowerSums(alphas);
+
+    std::vector<AverageDegree> functions;
+    std::vector<double> desired;
+    for (auto& target : targets) {
+        functions.emplace_back(m_statistics, target.dimension, target.alpha, target.alpha > 8.0);
+        desired.push_back(target.desiredAvgDegree);
+    }
+
+    return solveScalings(m_statistics, functions, desired);
+}
+
+
+// helper for scale weights
+double estimateWeightScalingThreshold(const std::vector<double> &weights, double desiredAvgDegree, int dimension) {
+    auto statistics = WeightStatistics(weights);
+    return estimateWeightScalingThreshold(statistics, desiredAvgDegree, dimension);
+}
+
+double estimateWeightScalingThreshold(WeightStatistics& statistics, double desiredAvgDegree, int dimension) {
+    // do exponential search on expected average degree function
+    const auto function = AverageDegree(statistics, dimension, std::numeric_limits<double>::infinity(), true);
+    return solveScalings(statistics, {function}, {desiredAvgDegree}).front();
+}
+
+
+// helper for scale weights
+double estimateWeightScaling(const std::vector<double> &weights, double desiredAvgDegree, int dimension, double alpha) {
+    auto statistics = WeightStatistics(weights);
+    return estimateWeightScaling(statistics, desiredAvgDegree, dimension, alpha);
+}
 
+double estimateWeightScaling(WeightStatistics& statistics, double desiredAvgDegree, int dimension, double alpha) {
     // do exponential search on avg_degree function
-    auto estimated_c = exponentialSearch(f, desiredAvgDegree);
-
-    /*
-     * Pr(edge) = Pr(c * 1/dist^ad * (wi*wj/W)^a )
-     *
-     * c * (wi*wj/W)^a
-     * = (c^{1/a} wi*wj/W)^a
-     * = (c^{1/a}wi* (c^{1/a}wj / (c^{1/a}W)^a
-     *
-     * so we can just scale all weights by (c^{1/a}
-     */
-    return pow(estimated_c, 1 / alpha); // return scaling
+    const auto function = AverageDegree(statistics, dimension, alpha, false);
+    return solveScalings(statistics, {function}, {desiredAvgDegree}).front();
 }
 
 } // namespace girgs
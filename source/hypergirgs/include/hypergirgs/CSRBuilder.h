@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+#include <cassert>
+
+#include <omp.h>
+
+#include <hypergirgs/CSRGraph.h>
+
+
+namespace hypergirgs {
+
+
+/**
+ * @brief
+ *  Edge callback that builds a CSRGraph from two identical runs of a sampler.
+ *  In the first pass, the degrees are counted. After finishCounting(), the second pass
+ *  scatters every edge directly into its final slot. Hence, no edge list is ever materialised.
+ *
+ *  The sampler has to emit exactly the same edges in both passes
+ *  (e.g. by running it twice with the same non-negative seed and number of threads).
+ */
+class CSRBuilder {
+public:
+    explicit CSRBuilder(std::size_t n)
+        : m_counting(true)
+    {
+        m_graph.offsets.assign(n + 1, 0);
+    }
+
+    void operator()(NodeIndex u, NodeIndex v, int) {
+        if (m_counting) {
+            #pragma omp atomic
+            m_graph.offsets[u + 1]++;
+            #pragma omp atomic
+            m_graph.offsets[v + 1]++;
+        } else {
+            scatter(u, v);
+            scatter(v, u);
+        }
+    }
+
+    /// turns the degrees counted in the first pass into offsets and prepares the second pass
+    void finishCounting() {
+        assert(m_counting);
+        std::partial_sum(m_graph.offsets.begin(), m_graph.offsets.end(), m_graph.offsets.begin());
+        m_graph.neighbours.resize(m_graph.offsets.back());
+        m_cursor.assign(m_graph.offsets.begin(), m_graph.offsets.end() - 1);
+        m_counting = false;
+    }
+
+    /// sorts all neighbourhoods (the scatter order depends on thread interleaving) and returns the graph
+    CSRGraph finish() {
+        assert(!m_counting);
+        std::vector<std::size_t>().swap(m_cursor);
+
+        const auto n = static_cast<long long>(m_graph.numNodes());
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (long long v = 0; v < n; ++v)
+            std::sort(m_graph.neighbours.begin() + m_graph.offsets[v], m_graph.neighbours.begin() + m_graph.offsets[v+1]);
+
+        return std::move(m_graph);
+    }
+
+private:
+    void scatter(NodeIndex from, NodeIndex to) {
+        std::size_t pos;
+        #pragma omp atomic capture
+        pos = m_cursor[from]++;
+        assert(pos < m_graph.offsets[from + 1]);
+        m_graph.neighbours[pos] = to;
+    }
+
+    bool m_counting;                    ///< whether we are in the first (counting) pass
+    std::vector<std::size_t> m_cursor;  ///< next free slot in the neighbourhood of each node during scatter
+    CSRGraph m_graph;
+};
+
+
+} // namespace hypergirgs
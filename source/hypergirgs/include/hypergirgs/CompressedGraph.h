@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+#include <hypergirgs/hypergirgs_api.h>
+#include <hypergirgs/Generator.h>
+
+
+namespace hypergirgs {
+
+
+/**
+ * @brief
+ *  Header of a compressed adjacency file (see saveCompressed()).
+ *  The header is followed by one record per node u = 0, ..., n-1 listing the neighbours v > u of u,
+ *  so every edge is stored once. A record consists of the number of such neighbours k followed by
+ *  the gaps v_1-u-1, v_2-v_1-1, ..., v_k-v_{k-1}-1 of the sorted neighbours.
+ *  All numbers are unsigned LEB128 varints (7 bits per byte, least significant group first,
+ *  the high bit marks that another byte follows). The header is stored in the byte order of the writing machine.
+ */
+struct CompressedGraphHeader {
+    std::array<char, 8> magic {{'G','I','R','G','A','D','J','\0'}}; ///< identifies the format
+    uint32_t version     = 1;   ///< version of the format
+    uint32_t coding      = 0;   ///< coding of the records: 0 LEB128 varints
+    uint32_t model       = 0;   ///< generator of the graph: 0 girgs, 1 hypergirgs
+    uint32_t relabelled  = 0;   ///< 1 if the nodes were relabelled in locality order (see angularLabels())
+    uint64_t n           = 0;   ///< number of nodes
+    uint64_t m           = 0;   ///< number of edges
+    std::array<double, 4>  parameters {};   ///< model parameters in the order chosen by the generator (e.g. alpha, T, deg, R)
+    std::array<int64_t, 4> seeds {};        ///< seeds in the order chosen by the generator
+    std::array<uint8_t, 24> reserved {};    ///< pads the header to 128 bytes
+};
+static_assert(sizeof(CompressedGraphHeader) == 128, "the records of a compressed adjacency file start at byte 128");
+
+
+/**
+ * @brief
+ *  Computes new node labels that follow the angular order of the points, i.e., the order of the cells
+ *  of the RadiusLayers within each layer. Close nodes get close labels, which keeps the neighbour gaps
+ *  of a hyperbolic random graph small (see saveCompressed()). Nodes with equal angles keep their relative order.
+ *
+ * @param angles
+ *  Angles as used for generateEdges().
+ *
+ * @return
+ *  A permutation labels, where labels[v] is the new label of node v.
+ */
+HYPERGIRGS_API std::vector<NodeIndex> angularLabels(DoubleView angles);
+
+/**
+ * @brief
+ *  Saves a graph as compressed adjacency file (format see CompressedGraphHeader).
+ *  The neighbourhoods are gap encoded by all threads in parallel and written in node order.
+ *
+ * @param header
+ *  Model, parameters, and seeds to store. The fields n, m, and relabelled are set by this function.
+ * @param n
+ *  The number of nodes.
+ * @param graph
+ *  An edge list with zero based indices and without duplicate edges or self loops.
+ * @param labels
+ *  If not empty, node v is stored as labels[v] (e.g. angularLabels()). Must be a permutation of [0, n).
+ * @param file
+ *  The name of the output file.
+ *
+ * @throw std::invalid_argument if graph contains a duplicate edge or a self loop
+ */
+HYPERGIRGS_API void saveCompressed(CompressedGraphHeader header, NodeIndex n, const std::vector<Edge>& graph,
+                              const std::vector<NodeIndex>& labels, const std::string& file);
+
+
+/**
+ * @brief
+ *  Reads a compressed adjacency file (see saveCompressed()) node by node through a fixed size buffer,
+ *  so graphs larger than the main memory can be processed.
+ *
+ *  Example:
+ *  @code
+ *  auto reader = CompressedGraphReader("graph.adj");
+ *  std::vector<NodeIndex> neighbours;
+ *  while (reader.next(neighbours))
+ *      for (auto v : neighbours)
+ *          process(reader.node(), v);
+ *  @endcode
+ */
+class HYPERGIRGS_API CompressedGraphReader {
+public:
+    /// opens file and reads its header; throws std::runtime_error if the file is no compressed adjacency file
+    explicit CompressedGraphReader(const std::string& file);
+
+    const CompressedGraphHeader& header() const noexcept { return m_header; }
+
+    /**
+     * @brief
+     *  Decodes the record of the next node.
+     *
+     * @param neighbours
+     *  Receives the neighbours v > node() of the node in ascending order.
+     *
+     * @return
+     *  false if all nodes have been read.
+     */
+    bool next(std::vector<NodeIndex>& neighbours);
+
+    /// the node whose neighbours were returned by the last call of next()
+    NodeIndex node() const noexcept { return static_cast<NodeIndex>(m_node); }
+
+private:
+    uint64_t readVarint();
+    void refill();
+
+    std::string m_name;
+    std::ifstream m_stream;
+    CompressedGraphHeader m_header;
+    std::vector<char> m_buffer;
+    std::size_t m_begin = 0;    ///< next unread byte in m_buffer
+    std::size_t m_end = 0;      ///< end of the valid bytes in m_buffer
+    uint64_t m_node = static_cast<uint64_t>(-1);
+};
+
+
+} // namespace hypergirgs
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+
+namespace hypergirgs {
+
+
+/// Read-only view of n contiguous doubles, e.g. radii in a std::vector<double> or in a MappedPoints file.
+class DoubleView {
+public:
+    DoubleView() = default;
+    DoubleView(const double* data, std::size_t n) noexcept : m_data(data), m_n(n) {}
+    DoubleView(const std::vector<double>& values) noexcept : m_data(values.data()), m_n(values.size()) {}
+
+    std::size_t size() const noexcept { return m_n; }
+    bool empty() const noexcept { return m_n == 0; }
+    const double* data() const noexcept { return m_data; }
+    const double* begin() const noexcept { return m_data; }
+    const double* end() const noexcept { return m_data + m_n; }
+
+    double operator[](std::size_t i) const noexcept {
+        assert(i < m_n);
+        return m_data[i];
+    }
+
+private:
+    const double* m_data = nullptr;
+    std::size_t m_n = 0;
+};
+
+
+} // namespace hypergirgs
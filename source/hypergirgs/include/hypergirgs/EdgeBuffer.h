@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <omp.h>
+
+#include <hypergirgs/Index.h>
+
+
+namespace hypergirgs {
+
+/**
+ * @brief
+ *  Collects the edges emitted by a HyperbolicTree in thread local buffers and hands them
+ *  over to a consumer in blocks. Can be used directly as EdgeCallback of a HyperbolicTree.
+ *
+ * @tparam BlockConsumer
+ *  Is called as consumer(const std::pair<NodeIndex,NodeIndex>* edges, std::size_t count, int threadId).
+ *  Calls with the same threadId never overlap, calls with different threadIds may run concurrently.
+ */
+template <typename BlockConsumer>
+class EdgeBuffer {
+public:
+    using Edge = std::pair<NodeIndex, NodeIndex>;
+
+    EdgeBuffer(BlockConsumer& consumer, std::size_t blockSize, int threads = omp_get_max_threads())
+        : m_consumer(consumer)
+        , m_block_size(blockSize)
+        , m_local_edges(threads)
+    {
+        for (auto& local : m_local_edges)
+            local.first.reserve(m_block_size);
+    }
+
+    void operator()(NodeIndex u, NodeIndex v, int tid) {
+        auto& local = m_local_edges[tid].first;
+        local.emplace_back(u, v);
+        if (local.size() == m_block_size)
+            flush(tid);
+    }
+
+    /// hands the (partially filled) buffer of thread tid to the consumer
+    void flush(int tid) {
+        auto& local = m_local_edges[tid].first;
+        if (local.empty())
+            return;
+        m_consumer(local.data(), local.size(), tid);
+        local.clear();
+    }
+
+    /// hands all remaining edges to the consumer in order of thread ids; call after sampling has finished
+    void flushAll() {
+        for (int tid = 0; tid < static_cast<int>(m_local_edges.size()); ++tid)
+            flush(tid);
+    }
+
+private:
+    BlockConsumer& m_consumer;
+    const std::size_t m_block_size;
+
+    std::vector<std::pair<
+            std::vector<Edge>,
+            uint64_t[31] /* avoid false sharing */
+    > > m_local_edges;
+};
+
+} // namespace hypergirgs
@@ -2,26 +2,100 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <random>
 #include <utility>
+#include <cstddef>
+#include <functional>
 
 #include <hypergirgs/hypergirgs_api.h>
+#include <hypergirgs/CSRGraph.h>
+#include <hypergirgs/DoubleView.h>
+#include <hypergirgs/Index.h>
 
 
 namespace hypergirgs {
 
 using default_random_engine = std::mt19937_64;
 
-HYPERGIRGS_API double calculateRadius(int n, double alpha, double T, double deg);
-HYPERGIRGS_API double calculateRadiusLikeNetworKit(int n, double alpha, double T, double deg);
+/// an undirected edge with zero based node indices
+using Edge = std::pair<NodeIndex, NodeIndex>;
 
-HYPERGIRGS_API std::vector<double> sampleRadii(int n, double alpha, double R, int seed, bool parallel = true);
-HYPERGIRGS_API std::vector<double> sampleAngles(int n, int seed, bool parallel = true);
+/**
+ * @brief
+ *  Receives a block of edges emitted by one thread during edge sampling.
+ *  Calls with the same threadId never overlap, calls with different threadIds may run concurrently.
+ *  The edges are only valid during the call.
+ */
+using EdgeBlockCallback = std::function<void(const Edge* edges, std::size_t count, int threadId)>;
 
-/// If both, radii and angles, are to be sampled prefer this function of sampleRadii() and sampleAngles() for performance and quality reasons.
-HYPERGIRGS_API std::pair<std::vector<double>, std::vector<double> > sampleRadiiAndAngles(int n, double alpha, double R, int seed, bool parallel = true);
+HYPERGIRGS_API double calculateRadius(NodeIndex n, double alpha, double T, double deg);
+HYPERGIRGS_API double calculateRadiusLikeNetworKit(NodeIndex n, double alpha, double T, double deg);
 
+/// Radii and angles only depend on the seed and not on the number of threads (unless compiled with OPTION_LEGACY_VARIATES).
+HYPERGIRGS_API std::vector<double> sampleRadii(NodeIndex n, double alpha, double R, int seed, bool parallel = true);
+HYPERGIRGS_API std::vector<double> sampleAngles(NodeIndex n, int seed, bool parallel = true);
 
-HYPERGIRGS_API std::vector<std::pair<int, int> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed = 0);
+/// Same as sampleRadii() and sampleAngles() with the same seed. With OPTION_LEGACY_VARIATES, prefer this function for performance and quality reasons.
+HYPERGIRGS_API std::pair<std::vector<double>, std::vector<double> > sampleRadiiAndAngles(NodeIndex n, double alpha, double R, int seed, bool parallel = true);
+
+
+HYPERGIRGS_API std::vector<Edge> generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed = 0);
+
+/// Same as generateEdges(std::vector<double>&, std::vector<double>&, double, double, int) for views, e.g. into a MappedPoints file.
+HYPERGIRGS_API std::vector<Edge> generateEdges(DoubleView radii, DoubleView angles, double T, double R, int seed = 0);
+
+/**
+ * @brief
+ *  Samples the edges of a hyperbolic random graph and streams them to a consumer instead of returning an edge list.
+ *  Each thread buffers up to blockSize edges before handing them to the consumer.
+ *  The sampling can be split into shards (e.g. one per process) that only produce a part of the edges.
+ *
+ * @param consumer
+ *  Called for each block of edges (zero based indices) with the id of the producing thread.
+ * @param blockSize
+ *  Maximum number of edges per call of consumer.
+ * @param shard
+ *  Index of the shard to sample, must be less than numShards.
+ * @param numShards
+ *  Number of shards. For the same inputs and a non-negative seed, the shards are disjoint and together form the graph sampled with one shard.
+ */
+HYPERGIRGS_API void generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed,
+        const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+        unsigned int shard = 0, unsigned int numShards = 1);
+
+/// Same as generateEdges(std::vector<double>&, std::vector<double>&, double, double, int, const EdgeBlockCallback&, std::size_t, unsigned int, unsigned int) for views.
+HYPERGIRGS_API void generateEdges(DoubleView radii, DoubleView angles, double T, double R, int seed,
+        const EdgeBlockCallback& consumer, std::size_t blockSize = std::size_t{1} << 16,
+        unsigned int shard = 0, unsigned int numShards = 1);
+
+/**
+ * @brief
+ *  Samples the edges of a hyperbolic random graph and returns them as symmetric adjacency array.
+ *  In contrast to generateEdges(), no intermediate edge list is built:
+ *  the sampler runs twice with the same seed, first to count the degrees and then to place each edge directly.
+ *
+ * @return
+ *  The graph in CSR format with sorted neighbourhoods.
+ */
+HYPERGIRGS_API CSRGraph generateCSR(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed = 0);
+
+/// Same as generateCSR(std::vector<double>&, std::vector<double>&, double, double, int) for views.
+HYPERGIRGS_API CSRGraph generateCSR(DoubleView radii, DoubleView angles, double T, double R, int seed = 0);
+
+/**
+ * @brief
+ *  Saves the graph as text edge list.
+ *  The first line holds the number of nodes and edges, followed by an empty line and one line "u v" per edge.
+ *  The lines are formatted by all threads in parallel.
+ */
+HYPERGIRGS_API void saveEdgeList(NodeIndex n, const std::vector<Edge>& graph, const std::string& file);
+
+/**
+ * @brief
+ *  Saves the hyperbolic coordinates with one line "radius angle" per node (fixed notation with 17 decimal places).
+ *  The lines are formatted by all threads in parallel.
+ */
+HYPERGIRGS_API void saveCoordinates(DoubleView radii, DoubleView angles, const std::string& file);
 
 } // namespace hypergirgs
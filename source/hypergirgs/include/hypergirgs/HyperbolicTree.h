@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <utility>
 #include <random>
@@ -15,8 +16,11 @@
 #include <hypergirgs/AngleHelper.h>
 #include <hypergirgs/RadiusLayer.h>
 #include <hypergirgs/Point.h>
+#include <hypergirgs/PointColumns.h>
 #include <hypergirgs/DistanceFilter.h>
 #include <hypergirgs/Generator.h>
+#include <hypergirgs/Philox.h>
+#include <hypergirgs/TypeIKernel.h>
 
 
 namespace hypergirgs {
@@ -35,9 +39,29 @@ class HyperbolicTree
 {
 public:
 
-    HyperbolicTree(const std::vector<double>& radii, const std::vector<double>& angles, double T, double R, EdgeCallback& edgeCallback, bool profile = false);
-
-    void generate(int seed) const;
+    /// Preprocesses radii and angles, which may be vectors or views (e.g. into a MappedPoints file).
+    HyperbolicTree(DoubleView radii, DoubleView angles, double T, double R, EdgeCallback& edgeCallback, bool profile = false);
+
+    /**
+     * @brief
+     *  Samples the edges and reports them to the edge callback.
+     *
+     * @param seed
+     *  The seed for the edge sampling. A negative seed draws a random one.
+     *  Random numbers are taken from counter-based streams keyed by (seed, layer pair, cell pair),
+     *  so the sampled edges only depend on the seed and not on the number of threads.
+     * @param shard
+     *  Index of the shard to sample, must be less than numShards.
+     * @param numShards
+     *  Splits the edge sampling into this many shards, e.g. to spread one graph over several processes.
+     *  The cells of the shard level (see shardLevel()) are split into numShards contiguous angular slices
+     *  and a shard only samples the cell pairs whose cellA lies in (or, above the shard level, starts in) its slice.
+     *  For a non-negative seed, the shards are disjoint and their union is the graph sampled with numShards = 1.
+     */
+    void generate(int seed, unsigned int shard = 0, unsigned int numShards = 1) const;
+
+    /// The level whose cells are split into shards; the first level with at least #s_cells_per_shard cells per shard (or the deepest level)
+    unsigned int shardLevel(unsigned int numShards) const;
 
 protected:
     /// Create a set of tasks to be executed in parallel; We'll skip all sampling steps during recursion (call visitCellPairSample!)
@@ -46,13 +70,21 @@ protected:
 
     /// Performs same recursion as visitCellPairCreateTasks, but samples for cells skipp by visitCellPairCreateTasks.
     int visitCellPairSample(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int first_parallel_level,
-                                  int num_threads, int thread_shift, default_random_engine& gen) const;
+                                  int num_threads, int thread_shift) const;
 
     /// Recursively sample cellA and cellB for level and higher
-    void visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level, default_random_engine& gen) const;
+    void visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level) const;
+
+    void sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) const;
+    void sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) const;
+
+    /// First and last shard owning a cell pair with cellA as source cell or as ancestor of the source cell; the pairs of cellA on this level belong to the first
+    std::pair<unsigned int, unsigned int> shardsOfCell(unsigned int cellA, unsigned int level) const;
 
-    void sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j, default_random_engine& gen) const;
-    void sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j, default_random_engine& gen) const;
+    /// Random stream used to sample the edges between layer i in cellA and layer j in cellB; each combination is visited at most once
+    PhiloxStream randomStream(unsigned int cellA, unsigned int cellB, unsigned int i, unsigned int j) const {
+        return {(static_cast<uint64_t>(m_seed) << 32) | (i << 16) | j, cellA, cellB};
+    }
 
     /// takes lower bound on radius for two layers
     unsigned int partitioningBaseLevel(double r1, double r2) const;
@@ -60,8 +92,6 @@ protected:
     /// 1.0 / connection probability with respect to hyperbolic distance
     double connectionProbRec(double dist) const;
 
-    std::vector<default_random_engine> initialize_prngs(size_t n, unsigned seed) const;
-
 protected:
     EdgeCallback& m_edgeCallback;
     const bool m_profile;
@@ -77,7 +107,7 @@ protected:
     unsigned int m_levels; ///< number of levels
 
     std::vector<Point>          m_points;        ///< points ordered by layer first and cell second
-    std::vector<unsigned int>   m_first_in_cell; ///< prefix sums into points array
+    std::vector<NodeOffset>     m_first_in_cell; ///< prefix sums into points array
     std::vector<RadiusLayer>    m_radius_layers; ///< data structure to access the points
 
     std::vector<std::vector<std::pair<unsigned int, unsigned int> > > m_layer_pairs;
@@ -87,6 +117,14 @@ protected:
     /// filter for layer ij on level l is in  m_typeII_filter[i*m_layers+j][l-2]; -2 because level 0 and 1 have no type 2 cell pairs
     std::vector<std::vector<std::pair<DistanceFilter<filter_size>,DistanceFilter<filter_size>>>> m_typeII_filter;
 
+    mutable uint32_t m_seed{0};            ///< seed of the current generate call, part of the key of all random streams
+    mutable unsigned int m_shard{0};       ///< shard sampled by the current generate call
+    mutable unsigned int m_num_shards{1};  ///< number of shards of the current generate call
+    mutable unsigned int m_shard_level{0}; ///< level whose cells are split into shards, see shardLevel()
+    mutable std::vector<PointColumns> m_columns; ///< per thread copy of the points of cell B in sampleTypeI()
+
+    static constexpr unsigned int s_cells_per_shard = 4; ///< minimum number of cells per shard on the shard level
+
 #ifndef NDEBUG
     mutable long long m_type1_checks{0}; ///< number of node pairs per thread that are checked via a type 1 check
     mutable long long m_type2_checks{0}; ///< number of node pairs per thread that are checked via a type 2 check
@@ -94,7 +132,7 @@ protected:
 };
 
 template <typename EdgeCallback>
-inline HyperbolicTree<EdgeCallback> makeHyperbolicTree(const std::vector<double>& radii, const std::vector<double>& angles, double T, double R, EdgeCallback& edgeCallback, bool profile = false) {
+inline HyperbolicTree<EdgeCallback> makeHyperbolicTree(DoubleView radii, DoubleView angles, double T, double R, EdgeCallback& edgeCallback, bool profile = false) {
     return {radii, angles, T, R, edgeCallback, profile};
 }
 
@@ -2,7 +2,7 @@
 namespace hypergirgs {
 
 template <typename EdgeCallback>
-HyperbolicTree<EdgeCallback>::HyperbolicTree(const std::vector<double> &radii, const std::vector<double> &angles,
+HyperbolicTree<EdgeCallback>::HyperbolicTree(DoubleView radii, DoubleView angles,
     double T, double R, EdgeCallback& edgeCallback, bool enable_profiling)
     : m_edgeCallback(edgeCallback)
     , m_profile(enable_profiling)
@@ -53,17 +53,27 @@ HyperbolicTree<EdgeCallback>::HyperbolicTree(const std::vector<double> &radii, c
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::generate(int seed) const {
+void HyperbolicTree<EdgeCallback>::generate(int seed, unsigned int shard, unsigned int numShards) const {
+    assert(shard < numShards);
+
     #ifndef NDEBUG
     m_type1_checks = 0;
     m_type2_checks = 0;
     #endif
 
+    // all random numbers are derived from the seed and the position in the recursion, see randomStream()
+    m_seed = seed >= 0 ? static_cast<uint32_t>(seed) : std::random_device{}();
+
+    // a shard only visits the cell pairs of its slice of the shard level, see shardsOfCell()
+    m_shard = shard;
+    m_num_shards = numShards;
+    m_shard_level = shardLevel(numShards);
+
     const auto num_threads = omp_get_max_threads();
+    m_columns.resize(num_threads);
     if(num_threads == 1) {
-        default_random_engine master_gen(seed >= 0 ? seed : std::random_device{}());
-        visitCellPair(0,0,0, master_gen);
-        assert(m_type1_checks + m_type2_checks == static_cast<long long>(m_n-1) * m_n);
+        visitCellPair(0,0,0);
+        assert(numShards > 1 || m_type1_checks + m_type2_checks == static_cast<long long>(m_n-1) * m_n);
         return;
     }
 
@@ -78,10 +88,6 @@ void HyperbolicTree<EdgeCallback>::generate(int seed) const {
     if (m_profile)
         std::cout << "First Parallel Level: " << first_parallel_level << "\n";
 
-    // prepare seed_seq and initialize a gen per thread for initial sampling
-    auto gens = initialize_prngs(num_threads - 1 + num_tasks,
-        seed >= 0 ? seed : std::random_device{}());
-
     // We have to implement our own task queue, here's the state:
     std::vector<TaskDescription> tasks;
 
@@ -121,7 +127,7 @@ void HyperbolicTree<EdgeCallback>::generate(int seed) const {
 
         // all others will sample the cells in the first levels of the recursion tree
         if (tid + 1 < num_threads) {
-            visitCellPairSample(0, 0, 0, first_parallel_level, num_threads - 1, tid, gens[tid]);
+            visitCellPairSample(0, 0, 0, first_parallel_level, num_threads - 1, tid);
 
             // wait until tasks are ready
             if (!tasks_generated) {
@@ -137,25 +143,59 @@ void HyperbolicTree<EdgeCallback>::generate(int seed) const {
             if (i >= tasks.size()) break;
 
             auto &task = tasks[i];
-            visitCellPair(task.cellA, task.cellB, first_parallel_level, gens[num_threads - 1 + i]);
+            visitCellPair(task.cellA, task.cellB, first_parallel_level);
         }
     }
 
-    assert(m_type1_checks + m_type2_checks == static_cast<long long>(m_n-1) * m_n);
+    assert(numShards > 1 || m_type1_checks + m_type2_checks == static_cast<long long>(m_n-1) * m_n);
+}
+
+template <typename EdgeCallback>
+unsigned int HyperbolicTree<EdgeCallback>::shardLevel(unsigned int numShards) const {
+    auto level = 0u;
+    while (level + 1 < m_levels && AngleHelper::numCellsInLevel(level) < static_cast<uint64_t>(s_cells_per_shard) * numShards)
+        ++level;
+    return level;
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level, default_random_engine& gen) const {
+std::pair<unsigned int, unsigned int> HyperbolicTree<EdgeCallback>::shardsOfCell(unsigned int cellA, unsigned int level) const {
+    // range of the cells on the shard level that are descendants (or the ancestor) of cellA
+    const auto index = static_cast<uint64_t>(cellA - AngleHelper::firstCellOfLevel(level));
+    auto first = index;
+    auto last = index;
+    if (level < m_shard_level) {
+        const auto shift = m_shard_level - level;
+        first = index << shift;
+        last = ((index + 1) << shift) - 1;
+    } else {
+        first = last = index >> (level - m_shard_level);
+    }
+
+    // shard s owns the cells [s*cells/numShards, (s+1)*cells/numShards) of the shard level
+    const auto cells = static_cast<uint64_t>(AngleHelper::numCellsInLevel(m_shard_level));
+    return {static_cast<unsigned int>(first * m_num_shards / cells), static_cast<unsigned int>(last * m_num_shards / cells)};
+}
+
+template <typename EdgeCallback>
+void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level) const {
+
+    const auto shards = shardsOfCell(cellA, level);
+    if (m_shard < shards.first || shards.second < m_shard) // no cell pair of this shard below
+        return;
+    const auto ownPair = shards.first == m_shard;
 
     if(!AngleHelper::touching(cellA, cellB, level))
     {   // not touching cells
+        if (!ownPair)
+            return;
         #ifdef NDEBUG
         if(!m_T) return; // I dont trust compiler optimization
         #endif // NDEBUG
         // sample all type 2 occurrences with this cell pair
         for(auto l=level; l<m_levels; ++l)
             for(auto& layer_pair : m_layer_pairs[l])
-                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second, gen);
+                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
         return;
     }
 
@@ -163,8 +203,8 @@ void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned in
 
     // sample all type 1 occurrences with this cell pair
     for(auto& layer_pair : m_layer_pairs[level]){
-        if(cellA != cellB || layer_pair.first <= layer_pair.second)
-            sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, gen);
+        if(ownPair && (cellA != cellB || layer_pair.first <= layer_pair.second))
+            sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
     }
 
     // break if last level reached
@@ -175,11 +215,11 @@ void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned in
     // these will be type 1 if a and b touch or type 2 if they don't
     auto fA = AngleHelper::firstChild(cellA);
     auto fB = AngleHelper::firstChild(cellB);
-    visitCellPair(fA + 0, fB + 0, level+1, gen);
-    visitCellPair(fA + 0, fB + 1, level+1, gen);
-    visitCellPair(fA + 1, fB + 1, level+1, gen);
+    visitCellPair(fA + 0, fB + 0, level+1);
+    visitCellPair(fA + 0, fB + 1, level+1);
+    visitCellPair(fA + 1, fB + 1, level+1);
     if(cellA != cellB)
-        visitCellPair(fA + 1, fB + 0, level+1, gen); // if A==B we already did this call 3 lines above
+        visitCellPair(fA + 1, fB + 0, level+1); // if A==B we already did this call 3 lines above
 }
 
 template<typename EdgeCallback>
@@ -214,7 +254,7 @@ void HyperbolicTree<EdgeCallback>::visitCellPairCreateTasks(unsigned int cellA,
 
 template<typename EdgeCallback>
 int HyperbolicTree<EdgeCallback>::visitCellPairSample(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int first_parallel_level,
-                                                                int num_threads, int thread_shift, default_random_engine& gen) const {
+                                                                int num_threads, int thread_shift) const {
 
     auto isMyTurn = [&] {
         if (++thread_shift == num_threads) {
@@ -224,13 +264,20 @@ int HyperbolicTree<EdgeCallback>::visitCellPairSample(unsigned int cellA, unsign
         return false;
     };
 
+    // jobs of other shards are skipped without taking a turn
+    const auto shards = shardsOfCell(cellA, level);
+    if (m_shard < shards.first || shards.second < m_shard) // no cell pair of this shard below
+        return thread_shift;
+    const auto ownPair = shards.first == m_shard;
+
     if(!AngleHelper::touching(cellA, cellB, level))
     {   // not touching cells
         // sample all type 2 occurrences with this cell pair
-        for(auto l=level; l<m_levels; ++l)
-            for(auto& layer_pair : m_layer_pairs[l])
-                if (isMyTurn())
-                    sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second, gen);
+        if (ownPair)
+            for(auto l=level; l<m_levels; ++l)
+                for(auto& layer_pair : m_layer_pairs[l])
+                    if (isMyTurn())
+                        sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
 
         return thread_shift;
     }
@@ -239,9 +286,9 @@ int HyperbolicTree<EdgeCallback>::visitCellPairSample(unsigned int cellA, unsign
 
     // sample all type 1 occurrences with this cell pair
     for(auto& layer_pair : m_layer_pairs[level]){
-        if(cellA != cellB || layer_pair.first <= layer_pair.second)
+        if(ownPair && (cellA != cellB || layer_pair.first <= layer_pair.second))
             if (isMyTurn())
-                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, gen);
+                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
     }
 
     // break if last level reached
@@ -253,11 +300,11 @@ int HyperbolicTree<EdgeCallback>::visitCellPairSample(unsigned int cellA, unsign
     if(level+1 != first_parallel_level) {
         auto fA = AngleHelper::firstChild(cellA);
         auto fB = AngleHelper::firstChild(cellB);
-        thread_shift = visitCellPairSample(fA + 0, fB + 0, level + 1, first_parallel_level, num_threads, thread_shift, gen);
-        thread_shift = visitCellPairSample(fA + 0, fB + 1, level + 1, first_parallel_level, num_threads, thread_shift, gen);
-        thread_shift = visitCellPairSample(fA + 1, fB + 1, level + 1, first_parallel_level, num_threads, thread_shift, gen);
+        thread_shift = visitCellPairSample(fA + 0, fB + 0, level + 1, first_parallel_level, num_threads, thread_shift);
+        thread_shift = visitCellPairSample(fA + 0, fB + 1, level + 1, first_parallel_level, num_threads, thread_shift);
+        thread_shift = visitCellPairSample(fA + 1, fB + 1, level + 1, first_parallel_level, num_threads, thread_shift);
         if (cellA != cellB)
-            thread_shift = visitCellPairSample(fA + 1, fB + 0, level + 1, first_parallel_level, num_threads, thread_shift, gen);
+            thread_shift = visitCellPairSample(fA + 1, fB + 0, level + 1, first_parallel_level, num_threads, thread_shift);
     }
 
     return thread_shift;
@@ -265,7 +312,7 @@ int HyperbolicTree<EdgeCallback>::visitCellPairSample(unsigned int cellA, unsign
 
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j, default_random_engine& gen) const {
+void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) const {
     auto rangeA = m_radius_layers[i].cellIterators(cellA, level);
     auto rangeB = m_radius_layers[j].cellIterators(cellB, level);
 
@@ -279,71 +326,95 @@ void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int
         #pragma omp atomic
         m_type1_checks += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1)  // all pairs in AxA without {v,v}
                                                      : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
+
+        for (auto pointerA = rangeA.first; pointerA != rangeA.second; ++pointerA) {
+            // pointer magic gives same results
+            assert(*pointerA == m_radius_layers[i].kthPoint(cellA, level, std::distance(rangeA.first, pointerA)));
+            // points are in correct cells and radius layer
+            assert(cellA - AngleHelper::firstCellOfLevel(level) == AngleHelper::cellForPoint(pointerA->angle, level));
+            assert(m_radius_layers[i].m_r_min < pointerA->radius && pointerA->radius <= m_radius_layers[i].m_r_max);
+        }
+        for (auto pointerB = rangeB.first; pointerB != rangeB.second; ++pointerB) {
+            assert(*pointerB == m_radius_layers[j].kthPoint(cellB, level, std::distance(rangeB.first, pointerB)));
+            assert(cellB - AngleHelper::firstCellOfLevel(level) == AngleHelper::cellForPoint(pointerB->angle, level));
+            assert(m_radius_layers[j].m_r_min < pointerB->radius && pointerB->radius <= m_radius_layers[j].m_r_max);
+        }
     }
 #endif // NDEBUG
 
     const auto threadId = omp_get_thread_num();
+    assert(static_cast<std::size_t>(threadId) < m_columns.size());
 
-    int kA = 0;
-    std::uniform_real_distribution<> dist;
+    // the kernels read the points of B as columns, see PointColumns
+    auto& columns = m_columns[threadId];
+    columns.assign(rangeB.first, rangeB.second);
+    const auto sizeB = columns.size();
+
+    auto gen = randomStream(cellA, cellB, i, j);
 
     // we evalutate T == 0 and store the result in a const LOCAL variable
     // to allow the compiler to assume it's constness and hence pull out the
     // if in the for loop
     const bool inThresholdMode = (m_T <= std::numeric_limits<double_t>::epsilon());
 
-    for(auto pointerA = rangeA.first; pointerA != rangeA.second; ++kA, ++pointerA) {
-        auto offset = (cellA == cellB && i==j) ? kA+1 : 0;
-        for (auto pointerB = rangeB.first + offset; pointerB != rangeB.second; ++pointerB) {
-            const auto& nodeInA = *pointerA;
-            const auto& nodeInB = *pointerB;
-
-            // pointer magic gives same results
-            assert(nodeInA == m_radius_layers[i].kthPoint(cellA, level, kA));
-            assert(nodeInB == m_radius_layers[j].kthPoint(cellB, level, std::distance(rangeB.first, pointerB) ));
+    // the kernels compare one point in A with a range of points in B; for T > 0 block-wise
+    constexpr auto block_size = 256u;
+    std::array<double, block_size> distances_cosh;
 
-            // points are in correct cells
-            assert(cellA - AngleHelper::firstCellOfLevel(level) == AngleHelper::cellForPoint(nodeInA.angle, level));
-            assert(cellB - AngleHelper::firstCellOfLevel(level) == AngleHelper::cellForPoint(nodeInB.angle, level));
+    dispatchTypeIKernel([&] (auto kernel) {
+        using Kernel = decltype(kernel);
 
-            // points are in correct radius layer
-            assert(m_radius_layers[i].m_r_min < nodeInA.radius && nodeInA.radius <= m_radius_layers[i].m_r_max);
-            assert(m_radius_layers[j].m_r_min < nodeInB.radius && nodeInB.radius <= m_radius_layers[j].m_r_max);
+        NodeOffset kA = 0;
+        for(auto pointerA = rangeA.first; pointerA != rangeA.second; ++kA, ++pointerA) {
+            const auto& nodeInA = *pointerA;
+            const std::size_t firstB = (cellA == cellB && i==j) ? kA+1 : 0;
 
-            assert(nodeInA != nodeInB);
             if(inThresholdMode) {
-                if (nodeInA.isDistanceBelowR(nodeInB, m_coshR)) {
+                Kernel::threshold(nodeInA, m_coshR, columns, firstB, sizeB, [&] (std::size_t b) {
+                    const auto& nodeInB = rangeB.first[b];
+                    assert(nodeInA != nodeInB);
                     assert(hyperbolicDistance(nodeInA.radius, nodeInA.angle, nodeInB.radius, nodeInB.angle) < m_R);
                     m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
-                }
-            } else {
-                const auto rnd = dist(gen);
-                const auto real_dist_cosh = nodeInA.hyperbolicDistanceCosh(nodeInB);
-
-                // check if we wouldn't make it even if rnd was a little smaller
-                if (real_dist_cosh > m_typeI_filter.coshDistForProb_upperBound(rnd)) {
-                    assert(rnd * connectionProbRec(std::acosh(real_dist_cosh)) >= 1.0);
-                    continue;
-                }
-
-                // check if we would make it even if rnd was a little higher
-                if (real_dist_cosh < m_typeI_filter.coshDistForProb_lowerBound(rnd)) {
-                    assert(rnd * connectionProbRec(std::acosh(real_dist_cosh)) < 1.0);
-                    m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
-                    continue;
-                }
+                });
+                continue;
+            }
 
-                // rnd is very close to the prob at which we connect this pair
-                if(rnd * connectionProbRec(std::acosh(real_dist_cosh)) < 1.0) {
-                    m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
+            for (auto blockBegin = firstB; blockBegin < sizeB; blockBegin += block_size) {
+                const auto blockEnd = std::min<std::size_t>(blockBegin + block_size, sizeB);
+                Kernel::distancesCosh(nodeInA, columns, blockBegin, blockEnd, distances_cosh.data());
+                for (auto b = blockBegin; b < blockEnd; ++b) {
+                    const auto& nodeInB = rangeB.first[b];
+                    assert(nodeInA != nodeInB);
+
+                    const auto rnd = gen.uniform();
+                    const auto real_dist_cosh = distances_cosh[b - blockBegin];
+                    assert(real_dist_cosh == nodeInA.hyperbolicDistanceCosh(nodeInB));
+
+                    // check if we wouldn't make it even if rnd was a little smaller
+                    if (real_dist_cosh > m_typeI_filter.coshDistForProb_upperBound(rnd)) {
+                        assert(rnd * connectionProbRec(std::acosh(real_dist_cosh)) >= 1.0);
+                        continue;
+                    }
+
+                    // check if we would make it even if rnd was a little higher
+                    if (real_dist_cosh < m_typeI_filter.coshDistForProb_lowerBound(rnd)) {
+                        assert(rnd * connectionProbRec(std::acosh(real_dist_cosh)) < 1.0);
+                        m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
+                        continue;
+                    }
+
+                    // rnd is very close to the prob at which we connect this pair
+                    if(rnd * connectionProbRec(std::acosh(real_dist_cosh)) < 1.0) {
+                        m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
+                    }
                 }
             }
         }
-    }
+    });
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j, default_random_engine& gen) const {
+void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) const {
 
     const auto sizeV_i_A = static_cast<long long>(m_radius_layers[i].pointsInCell(cellA, level));
     const auto sizeV_j_B = static_cast<long long>(m_radius_layers[j].pointsInCell(cellB, level));
@@ -369,7 +440,7 @@ void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int
             #pragma omp atomic
             m_type2_checks -= 2ll * sizeV_i_A * sizeV_j_B;
         #endif // NDEBUG
-        return sampleTypeI(cellA, cellB, level, i, j, gen);
+        return sampleTypeI(cellA, cellB, level, i, j);
     }
 
 #ifndef NDEBUG
@@ -389,16 +460,19 @@ void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int
     if(expected_samples < 1e-6)
         return;
 
-    // init geometric distribution
+    // init geometric distribution (number of failures before the next success) by inversion
     const auto threadId = omp_get_thread_num();
-    auto geo = std::geometric_distribution<unsigned long long>(max_connection_prob);
-    std::uniform_real_distribution<> dist(0.0, max_connection_prob);
+    auto gen = randomStream(cellA, cellB, i, j);
+    const auto inv_log_fail = 1.0 / std::log1p(-max_connection_prob);
+    auto geo = [&] { return std::floor(std::log1p(-gen.uniform()) * inv_log_fail); };
 
     const auto* pointsA = &m_radius_layers[i].kthPoint(cellA, level, 0);
     const auto* pointsB = &m_radius_layers[j].kthPoint(cellB, level, 0);
 
-    for (auto r = geo(gen); r < num_pairs; r += 1 + geo(gen)) {
+    // r is kept as double since a skip may exceed the range of integers for tiny probabilities
+    for (auto rd = geo(); rd < num_pairs; rd += 1 + geo()) {
         // determine the r-th pair
+        const auto r = static_cast<long long>(rd);
         const auto& nodeInA = pointsA[r%sizeV_i_A];
         const auto& nodeInB = pointsB[r/sizeV_i_A];
 
@@ -413,7 +487,7 @@ void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int
         assert(m_radius_layers[i].m_r_min < nodeInA.radius && nodeInA.radius <= m_radius_layers[i].m_r_max);
         assert(m_radius_layers[j].m_r_min < nodeInB.radius && nodeInB.radius <= m_radius_layers[j].m_r_max);
 
-        const auto rnd = dist(gen);
+        const auto rnd = gen.uniform() * max_connection_prob;
 
         // get actual connection probability
         const auto real_dist_cosh = nodeInA.hyperbolicDistanceCosh(nodeInB);
@@ -443,33 +517,6 @@ void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int
 }
 
 
-template <typename EdgeCallback>
-std::vector<default_random_engine> HyperbolicTree<EdgeCallback>::initialize_prngs(size_t n, unsigned seed) const {
-    std::vector<default_random_engine> gens;
-
-    // we need a generator for each tasks and also for each but one threads
-    constexpr auto state_size = default_random_engine::state_size;
-
-    // get high quality seed values from one PRNG
-    std::vector<uint32_t> seeds(n * state_size);
-    {
-        default_random_engine master_gen(seed);
-        std::uniform_int_distribution<std::uint32_t> dist;
-        std::generate(seeds.begin(), seeds.end(), [&] {return dist(master_gen);});
-    }
-
-    // use a seed_seq to initialize all prngs
-    gens.reserve(n);
-    for(int i=0; i < n; ++i) {
-        auto begin = std::next(seeds.begin(), i * state_size);
-        auto end = std::next(begin, state_size);
-        std::seed_seq ss(begin, end);
-        gens.emplace_back(ss);
-    }
-
-    return gens;
-}
-
 template <typename EdgeCallback>
 unsigned int HyperbolicTree<EdgeCallback>::partitioningBaseLevel(double r1, double r2) const {
     return RadiusLayer::partitioningBaseLevel(r1, r2, m_R);
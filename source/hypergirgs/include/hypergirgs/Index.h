@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace hypergirgs {
+
+/**
+ * @brief
+ *  Type of node ids, used for edge end points and loops over nodes.
+ *  32 bit by default; configure with OPTION_64BIT_INDICES for graphs with \f$ 2^{31} \f$ or more nodes.
+ */
+#ifdef USE_64BIT_INDICES
+    using NodeIndex = int64_t;
+#else
+    using NodeIndex = int;
+#endif
+
+/**
+ * @brief
+ *  Type of positions in the sorted point array and of the prefix sums over cells.
+ *  Has the same width as NodeIndex.
+ */
+#ifdef USE_64BIT_INDICES
+    using NodeOffset = uint64_t;
+#else
+    using NodeOffset = unsigned int;
+#endif
+
+} // namespace hypergirgs
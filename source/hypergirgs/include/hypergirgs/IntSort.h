@@ -50,8 +50,11 @@ class IntSortImpl {
     static_assert(RADIX_WIDTH <= 8 * sizeof(T), "Radix is not allowed to exceed numer of bits in T");
 
     static constexpr size_t no_queues = 1llu << RADIX_WIDTH;
+    static constexpr size_t batches_per_thread = 8; // small buckets are grouped into about this many batches per thread
 
     using IndexArray = std::array<size_t, no_queues>;
+    // padded to avoid false sharing
+    using ThreadCounters = std::vector< std::array<size_t, no_queues + 64 / sizeof(size_t)> >;
 
 public:
     IntSortImpl(KeyExtract key_extract, const Key max_key) :
@@ -84,8 +87,11 @@ public:
         // perform the first round as MSB radix sort which will yield indendent
         // chunks which then can be sorted pleasingly parallel. We add some padding
         // to thread_counter to avoid false sharing
-        std::vector< std::array<size_t, no_queues + 64 / sizeof(size_t)> >
-            thread_counters(max_threads);
+        ThreadCounters thread_counters(max_threads);
+
+        // buckets of the MSB round sorted by all threads together and batches [first, last) of the others
+        std::vector<size_t> large_buckets;
+        std::vector<std::pair<size_t, size_t>> batches;
 
         #pragma omp parallel num_threads(max_threads)
         {
@@ -147,50 +153,25 @@ public:
                     #pragma omp barrier
                 }
 
+                #pragma omp single
+                plan_buckets(splitter, n, no_threads, large_buckets, batches);
 
-                IndexArray counters;
-
-                // Now solve parts independently
-                #pragma omp for nowait
-                for (int i = 0; i < msb_radix; ++i) {
-                    if (splitter[i] == splitter[i + 1]) continue;
-
-					const size_t size = splitter[i + 1] - splitter[i];
-                    auto input_base = buf_begin + splitter[i];
-                    auto buffer_base = begin + splitter[i];
-
-                    // iteration 0
-                    {
-                        const auto input_begin = input_base;
-                        const auto input_end = input_base + size;
-
-                        // in the first round we have to count the
-                        // elements for each queue; later we do it while
-                        // moving elements
-                        std::fill_n(counters.begin(), adaptive_no_queues, 0);
-                        for (auto it = input_begin;
-                             it != input_end; ++it) {
-                            counters[get_queue_index(key_extract(*it), 0)]++;
-                        }
-
-                        move_to_queues(input_base, input_base + size,
-                                       buffer_base, counters, 0, no_iters != 1);
-
-                        std::swap(input_base, buffer_base);
-                    }
+                // Skewed keys (e.g. many points in few cells) put most elements into
+                // a few buckets, which would leave all but a few threads idle
+                for (const auto i : large_buckets) {
+                    sort_bucket_cooperatively(buf_begin + splitter[i], begin + splitter[i],
+                                              splitter[i + 1] - splitter[i], thread_counters);
+                }
 
-                    // iterations 1 to no_iters-2
-                    for(int iteration = 1; iteration < no_iters-1; iteration++) {
-                        move_to_queues(input_base, input_base + size,
-                                       buffer_base, counters, iteration, true);
+                IndexArray counters;
 
-                        std::swap(input_base, buffer_base);
+                // Now solve the remaining parts independently
+                #pragma omp for schedule(dynamic, 1) nowait
+                for (int b = 0; b < static_cast<int>(batches.size()); ++b) {
+                    for (auto i = batches[b].first; i != batches[b].second; ++i) {
+                        sort_bucket(buf_begin + splitter[i], begin + splitter[i],
+                                    splitter[i + 1] - splitter[i], counters);
                     }
-
-                    // last iteration (no_iters - 1)
-                    if (no_iters > 1)
-                        move_to_queues(input_base, input_base + size,
-                                       buffer_base, counters, no_iters-1, false);
                 }
             }
         }
@@ -217,6 +198,121 @@ private:
         return (key >> (iteration * adaptive_width)) & mask;
     };
 
+    // buckets larger than the share of a thread are sorted by all threads together; the others are grouped
+    // into batches of consecutive buckets with at least n / (batches_per_thread * no_threads) elements each
+    template <typename Splitter>
+    void plan_buckets(const Splitter& splitter, const size_t n, const int no_threads,
+                      std::vector<size_t>& large_buckets, std::vector<std::pair<size_t, size_t>>& batches) const {
+        const size_t large = no_threads > 1 ? n / no_threads : n;
+        const size_t grain = idiv_ceil(n, batches_per_thread * no_threads);
+
+        size_t first = 0;
+        size_t batch_size = 0;
+        for (size_t i = 0; i != msb_radix; ++i) {
+            const size_t size = splitter[i + 1] - splitter[i];
+            if (size > large) {
+                if (first != i)
+                    batches.emplace_back(first, i);
+                large_buckets.push_back(i);
+                first = i + 1;
+                batch_size = 0;
+                continue;
+            }
+
+            batch_size += size;
+            if (batch_size >= grain) {
+                batches.emplace_back(first, i + 1);
+                first = i + 1;
+                batch_size = 0;
+            }
+        }
+
+        if (first != msb_radix)
+            batches.emplace_back(first, msb_radix);
+    }
+
+    // LSB radix sort of a bucket of size elements by the calling thread
+    template <typename IterT, typename CounterT>
+    void sort_bucket(IterT input_base, IterT buffer_base, const size_t size, CounterT& counters) {
+        if (!size) return;
+
+        // iteration 0
+        {
+            const auto input_begin = input_base;
+            const auto input_end = input_base + size;
+
+            // in the first round we have to count the
+            // elements for each queue; later we do it while
+            // moving elements
+            std::fill_n(counters.begin(), adaptive_no_queues, 0);
+            for (auto it = input_begin;
+                 it != input_end; ++it) {
+                counters[get_queue_index(key_extract(*it), 0)]++;
+            }
+
+            move_to_queues(input_base, input_base + size,
+                           buffer_base, counters, 0, no_iters != 1);
+
+            std::swap(input_base, buffer_base);
+        }
+
+        // iterations 1 to no_iters-2
+        for(int iteration = 1; iteration < no_iters-1; iteration++) {
+            move_to_queues(input_base, input_base + size,
+                           buffer_base, counters, iteration, true);
+
+            std::swap(input_base, buffer_base);
+        }
+
+        // last iteration (no_iters - 1)
+        if (no_iters > 1)
+            move_to_queues(input_base, input_base + size,
+                           buffer_base, counters, no_iters-1, false);
+    }
+
+    // LSB radix sort of a bucket by all threads of the enclosing parallel region, which have to call it
+    // together. Each iteration distributes the thread's chunks as in the MSB round, so the order is the
+    // same as with sort_bucket and the result ends up in the same buffer.
+    template <typename IterT>
+    void sort_bucket_cooperatively(IterT input_base, IterT buffer_base, const size_t size,
+                                   ThreadCounters& thread_counters) {
+        const auto tid = omp_get_thread_num();
+        const auto no_threads = omp_get_num_threads();
+
+        const size_t chunk_size = idiv_ceil(size, no_threads);
+        const size_t chunk_begin = std::min(chunk_size * tid, size);
+        const size_t chunk_end = std::min(chunk_size * (tid + 1), size);
+
+        IndexArray queue_pointer;
+        for (int iteration = 0; iteration < no_iters; ++iteration) {
+            auto &counters = thread_counters[tid];
+            std::fill_n(counters.begin(), adaptive_no_queues, 0);
+            for (auto it = input_base + chunk_begin; it != input_base + chunk_end; ++it) {
+                counters[get_queue_index(key_extract(*it), iteration)]++;
+            }
+
+            #pragma omp barrier
+
+            size_t index = 0;
+            for (size_t qid = 0; qid != adaptive_no_queues; ++qid) {
+                for (int ttid = 0; ttid < no_threads; ttid++) {
+                    if (ttid == tid) queue_pointer[qid] = index;
+                    index += thread_counters[ttid][qid];
+                }
+            }
+
+            for (auto it = input_base + chunk_begin; it != input_base + chunk_end; ++it) {
+                const auto index = queue_pointer[get_queue_index(key_extract(*it), iteration)]++;
+                buffer_base[index] = std::move(*it);
+            }
+
+            // the next iteration reads the moved elements and overwrites the counters
+            #pragma omp barrier
+
+            std::swap(input_base, buffer_base);
+        }
+    }
+
 
     template <typename IterT, typename BufT, typename CounterT>
     void move_to_queues (const IterT begin, const IterT end,
@@ -243,6 +339,274 @@ private:
         }
     }
 };
+struct NoTieBreak {
+    template <typename T>
+    bool operator()(const T&, const T&) const noexcept { return false; }
+};
+
+template<typename Iter, typename Key, typename KeyExtract, typename TieBreak>
+class InPlaceSortImpl {
+    static constexpr size_t kRadixWidth = 8;
+    static constexpr size_t kBuckets = 1llu << kRadixWidth;
+    static constexpr size_t kSmall = 64;            ///< smaller ranges are sorted with std::sort
+    static constexpr size_t kMinPerThread = 1 << 16; ///< smaller rounds of the parallel distribution run on one thread
+    static constexpr int kMaxParallelRounds = 4;     ///< later rounds of the parallel distribution run on one thread
+    static constexpr size_t kBatchesPerThread = 8;   ///< small ranges are grouped into about this many batches per thread
+
+    using Buckets = std::array<size_t, kBuckets>;
+
+    // the elements [first, first + size) agree on all but the lowest bits of their keys
+    struct Range {
+        size_t first;
+        size_t size;
+        size_t bits;
+    };
+
+public:
+    InPlaceSortImpl(KeyExtract key_extract, TieBreak tie_break, const Key max_key) :
+        key_extract{key_extract},
+        tie_break{tie_break},
+        max_bits{num_bits(max_key)}
+    {
+    }
+
+    void sort(const Iter begin, const size_t n) {
+        if (n < 2)
+            return;
+
+        const auto width = std::min(max_bits, kRadixWidth);
+        const auto max_threads = std::min<int>(omp_get_max_threads(), idiv_ceil(n, 1 << 17));
+        if (max_threads < 2 || width == 0) {
+            sort_sequential(begin, n, max_bits - width, width);
+            return;
+        }
+
+        // ranges larger than the share of a thread are distributed by all threads on their next digit,
+        // so skewed keys (e.g. most elements in a few buckets) do not leave threads idle
+        const size_t large = n / max_threads;
+        std::vector<Range> pending {Range{0, n, max_bits}};
+        std::vector<Range> ranges;
+        while (!pending.empty()) {
+            const auto range = pending.back();
+            pending.pop_back();
+
+            if (range.size <= large || range.bits == 0) {
+                ranges.push_back(range);
+                continue;
+            }
+
+            const auto range_width = std::min(range.bits, kRadixWidth);
+            const auto threads = std::min<int>(max_threads, idiv_ceil(range.size, 1 << 17));
+            Buckets bucket_begin;
+            distribute_parallel(begin + range.first, range.size, range.bits - range_width, range_width, threads, bucket_begin);
+
+            const auto buckets = size_t{1} << range_width;
+            for (size_t b = 0; b < buckets; ++b) {
+                const auto end = b + 1 < buckets ? bucket_begin[b + 1] : range.size;
+                if (end - bucket_begin[b] > 1)
+                    pending.push_back(Range{range.first + bucket_begin[b], end - bucket_begin[b], range.bits - range_width});
+            }
+        }
+
+        // the remaining ranges are independent sub problems, grouped into batches of similar size
+        const size_t grain = idiv_ceil(n, kBatchesPerThread * max_threads);
+        std::vector<size_t> batch_begin;
+        for (size_t i = 0, batch_size = grain; i < ranges.size(); ++i) {
+            if (batch_size >= grain) {
+                batch_begin.push_back(i);
+                batch_size = 0;
+            }
+            batch_size += ranges[i].size;
+        }
+        batch_begin.push_back(ranges.size());
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(max_threads)
+        for (int b = 0; b < static_cast<int>(batch_begin.size()) - 1; ++b) {
+            for (auto i = batch_begin[b]; i < batch_begin[b + 1]; ++i) {
+                const auto& range = ranges[i];
+                const auto range_width = std::min(range.bits, kRadixWidth);
+                sort_sequential(begin + range.first, range.size, range.bits - range_width, range_width);
+            }
+        }
+    }
+
+private:
+    KeyExtract key_extract;
+    TieBreak tie_break;
+    const size_t max_bits; ///< number of bits of max_key
+
+    static size_t num_bits(Key key) {
+        size_t bits = 0;
+        for (; key; key >>= 1)
+            ++bits;
+        return bits;
+    }
+
+    size_t digit(const Key key, const size_t shift, const size_t width) const {
+        return static_cast<size_t>((key >> shift) & ((Key{1} << width) - 1));
+    }
+
+    // orders by key and equal keys by tie_break
+    bool less(const typename std::iterator_traits<Iter>::value_type& a,
+              const typename std::iterator_traits<Iter>::value_type& b) const {
+        const Key ka = key_extract(a);
+        const Key kb = key_extract(b);
+        return ka < kb || (ka == kb && tie_break(a, b));
+    }
+
+    // American flag sort of the digit (shift, width) and recursion on the next lower digit
+    void sort_sequential(const Iter begin, const size_t n, const size_t shift, const size_t width) {
+        if (n < 2)
+            return;
+
+        if (width == 0) { // all keys are equal
+            if (!std::is_same<TieBreak, NoTieBreak>::value)
+                std::sort(begin, begin + n, tie_break);
+            return;
+        }
+
+        if (n <= kSmall) {
+            std::sort(begin, begin + n, [&] (const auto& a, const auto& b) { return less(a, b); });
+            return;
+        }
+
+        const auto buckets = size_t{1} << width;
+        Buckets counts;
+        std::fill_n(counts.begin(), buckets, 0);
+        for (auto it = begin; it != begin + n; ++it)
+            counts[digit(key_extract(*it), shift, width)]++;
+
+        Buckets heads, tails;
+        for (size_t b = 0, sum = 0; b < buckets; ++b) {
+            heads[b] = sum;
+            sum += counts[b];
+            tails[b] = sum;
+        }
+        const auto bucket_begin = heads;
+
+        // follow each cycle of the permutation until it returns to the bucket it started in
+        for (size_t b = 0; b < buckets; ++b) {
+            while (heads[b] < tails[b]) {
+                auto d = digit(key_extract(begin[heads[b]]), shift, width);
+                if (d == b) {
+                    ++heads[b];
+                    continue;
+                }
+
+                auto value = std::move(begin[heads[b]]);
+                do {
+                    std::swap(value, begin[heads[d]++]);
+                    d = digit(key_extract(value), shift, width);
+                } while (d != b);
+                begin[heads[b]++] = std::move(value);
+            }
+        }
+
+        const auto next_width = std::min(shift, kRadixWidth);
+        for (size_t b = 0; b < buckets; ++b)
+            sort_sequential(begin + bucket_begin[b], tails[b] - bucket_begin[b], shift - next_width, next_width);
+    }
+
+    // distributes by the digit (shift, width) in place with several threads (PARADIS, Cho et al. 2015):
+    // each thread permutes within its share of every bucket, and a repair step per bucket collects
+    // the elements that did not fit at the bucket's end for the next round
+    void distribute_parallel(const Iter begin, const size_t n, const size_t shift, const size_t width,
+                             const int max_threads, Buckets& bucket_begin) {
+        const auto buckets = size_t{1} << width;
+
+        // zero-initialised, as the runtime may start fewer threads than requested
+        std::vector< std::array<size_t, kBuckets + 64 / sizeof(size_t)> > thread_counters(max_threads);
+
+        #pragma omp parallel num_threads(max_threads)
+        {
+            const auto tid = omp_get_thread_num();
+            const size_t chunk_size = idiv_ceil(n, omp_get_num_threads());
+            auto& counters = thread_counters[tid];
+            for (auto i = chunk_size * tid; i < std::min(chunk_size * (tid + 1), n); ++i)
+                counters[digit(key_extract(begin[i]), shift, width)]++;
+        }
+
+        Buckets heads, tails; // the elements in [heads[b], tails[b]) are not yet in place
+        for (size_t b = 0, sum = 0; b < buckets; ++b) {
+            bucket_begin[b] = heads[b] = sum;
+            for (const auto& counters : thread_counters)
+                sum += counters[b];
+            tails[b] = sum;
+        }
+
+        std::vector<Buckets> part_heads(max_threads), part_tails(max_threads);
+        for (int round = 0;; ++round) {
+            size_t remaining = 0;
+            for (size_t b = 0; b < buckets; ++b)
+                remaining += tails[b] - heads[b];
+            if (!remaining)
+                break;
+
+            // a single thread places all elements, so the last round is sequential
+            const auto threads = (round < kMaxParallelRounds && remaining >= kMinPerThread * max_threads) ? max_threads : 1;
+            for (int t = 0; t < threads; ++t) {
+                for (size_t b = 0; b < buckets; ++b) {
+                    const auto size = tails[b] - heads[b];
+                    part_heads[t][b] = heads[b] + size * t / threads;
+                    part_tails[t][b] = heads[b] + size * (t + 1) / threads;
+                }
+            }
+
+            #pragma omp parallel for schedule(static, 1) num_threads(threads)
+            for (int t = 0; t < threads; ++t)
+                permute_part(begin, shift, width, part_heads[t], part_tails[t]);
+
+            #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+            for (int b = 0; b < static_cast<int>(buckets); ++b)
+                heads[b] = repair_bucket(begin, shift, width, b, threads, part_heads, part_tails, tails[b]);
+        }
+    }
+
+    // places elements of the thread's parts [heads[b], tails[b]) of all buckets b;
+    // afterwards [heads[b], tails[b]) holds the elements that did not fit into the thread's part of their bucket
+    void permute_part(const Iter begin, const size_t shift, const size_t width, Buckets& heads, const Buckets& tails) {
+        const auto buckets = size_t{1} << width;
+        for (size_t b = 0; b < buckets; ++b) {
+            for (auto head = heads[b]; head < tails[b]; ++head) {
+                auto value = std::move(begin[head]);
+                auto d = digit(key_extract(value), shift, width);
+                while (d != b && heads[d] < tails[d]) {
+                    std::swap(value, begin[heads[d]++]);
+                    d = digit(key_extract(value), shift, width);
+                }
+
+                if (d == b) {
+                    if (head != heads[b])
+                        begin[head] = std::move(begin[heads[b]]);
+                    begin[heads[b]++] = std::move(value);
+                } else {
+                    begin[head] = std::move(value);
+                }
+            }
+        }
+    }
+
+    // swaps the misplaced elements of bucket b to its end and returns the first index not known to be in place
+    size_t repair_bucket(const Iter begin, const size_t shift, const size_t width, const size_t b, const int threads,
+                         const std::vector<Buckets>& part_heads, const std::vector<Buckets>& part_tails, size_t tail) const {
+        for (int t = 0; t < threads; ++t) {
+            for (auto head = part_heads[t][b]; head < part_tails[t][b] && head < tail; ++head) {
+                if (digit(key_extract(begin[head]), shift, width) == b)
+                    continue;
+
+                // find an element of b at the end
+                do {
+                    --tail;
+                } while (head < tail && digit(key_extract(begin[tail]), shift, width) != b);
+
+                if (head == tail)
+                    return tail;
+                std::swap(begin[head], begin[tail]);
+            }
+        }
+        return tail;
+    }
+};
 } // ! namespace IntSortInternal
 
 
@@ -257,12 +621,12 @@ private:
  * larger than max_key.
  *
  * In the first iteration the algorithm sorts the highest relevant bits of the key,
- * resulting in several sub problems which are then sorted pleasingly parallel with
- * an LSB Radix Sort variant (i.e. starting from the least significant bits).
- * The algorithm does not included explicit load balancing measures; in the worst
- * case all elements contain the same key, which results in a single active thread
- * after the first iteration. This is typically not an issue if the input is "somewhat"
- * uniformly distributed.
+ * resulting in several sub problems which are then sorted with an LSB Radix Sort
+ * variant (i.e. starting from the least significant bits).
+ * Sub problems larger than n / #threads are sorted by all threads together, one
+ * after another; the remaining ones are grouped into batches of similar size which
+ * are sorted pleasingly parallel. Hence skewed keys (e.g. most elements in a few
+ * buckets) do not leave threads idle. The order is the same for any number of threads.
  *
  * @note RADIX_WIDTH specifies the number of bits sorted in a single iteration and
  * results in 2**RADIX_WIDTH many queues. Due to cache effects typically 7 or 8
@@ -345,6 +709,46 @@ inline void intsort(std::unique_ptr<T[]> &input, const size_t n,
 }
 
 
+/**
+ * In-place Parallel Radix Sort of the sequence [@a begin, @a end) by the keys key_extract(*it),
+ * where no key may be larger than max_key. In contrast to intsort(), no buffer of n elements is
+ * allocated, so sequences close to the size of the main memory can be sorted. It is somewhat slower.
+ *
+ * The first digit (highest RADIX_WIDTH bits) is distributed with several threads as in PARADIS
+ * (Cho et al., PARADIS: An Efficient Parallel Algorithm for In-place Radix Sort, VLDB 2015);
+ * the resulting buckets are then sorted pleasingly parallel with American flag sort (MSD, in place).
+ * Buckets larger than n / #threads are distributed in parallel again on their next digit, and the
+ * small ones are sorted in batches of similar size, so skewed keys do not leave threads idle.
+ *
+ * The sort is not stable; elements with equal keys are ordered by the comparator @a tie_break
+ * (or left in an arbitrary order without).
+ */
+template<typename Iter, typename KeyExtract, typename Key, typename TieBreak = IntSortInternal::NoTieBreak>
+inline void intsort_inplace(const Iter begin, const Iter end, KeyExtract key_extract,
+                            const Key max_key = std::numeric_limits<Key>::max(),
+                            TieBreak tie_break = TieBreak{}) {
+    IntSortInternal::InPlaceSortImpl<Iter, Key, KeyExtract, TieBreak> sorter(key_extract, tie_break, max_key);
+    sorter.sort(begin, static_cast<size_t>(std::distance(begin, end)));
+}
+
+
+/**
+ * Stable sort of @a input by key_extract (see intsort()), where @a input_order(a, b) must be true
+ * iff a is before b in the input (e.g. by comparing indices the elements have been created with).
+ * Uses intsort() by default and intsort_inplace() if compiled with USE_INPLACE_SORT
+ * (cmake option OPTION_INPLACE_SORT); both produce the same order.
+ */
+template<typename T, typename KeyExtract, typename Key, typename InputOrder>
+inline void intsort_stable(std::vector<T> &input, KeyExtract key_extract, const Key max_key, InputOrder input_order) {
+#ifdef USE_INPLACE_SORT
+    intsort_inplace(input.begin(), input.end(), key_extract, max_key, input_order);
+#else
+    (void)input_order; // the radix sort with buffer is stable
+    intsort(input, key_extract, max_key);
+#endif
+}
+
+
 } // namespace: intsort
 
 #endif // INTSORT_H_
\ No newline at end of file
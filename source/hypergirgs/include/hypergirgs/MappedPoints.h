@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <hypergirgs/hypergirgs_api.h>
+#include <hypergirgs/DoubleView.h>
+
+
+namespace hypergirgs {
+
+
+/**
+ * @brief
+ *  Header of a binary points file (see savePoints()); the same format as girgs::BinaryPointsHeader.
+ *  For hypergirgs, the header is followed by the n radii and then by the n angles,
+ *  both as doubles in the byte order of the writing machine, starting at byte offset sizeof(BinaryPointsHeader) = 128.
+ *  Hence, the file can be memory mapped and used in place (see MappedPoints).
+ */
+struct BinaryPointsHeader {
+    std::array<char, 8> magic {{'G','I','R','G','P','T','S','\0'}}; ///< identifies the format
+    uint32_t version     = 1;   ///< version of the format
+    uint32_t model       = 1;   ///< meaning of the data: 0 girgs (weights, torus coordinates), 1 hypergirgs (radii, angles)
+    uint32_t dimension   = 1;   ///< coordinates per point
+    uint32_t layout      = 0;   ///< order of the coordinates: 0 row-major, 1 column-major (the same for one coordinate)
+    uint64_t n           = 0;   ///< number of points
+    std::array<double, 4>  parameters {};   ///< model parameters; for hypergirgs the disk radius R
+    std::array<uint8_t, 64> reserved {};    ///< pads the header to 128 bytes
+};
+static_assert(sizeof(BinaryPointsHeader) == 128, "the data of a binary points file starts at byte 128");
+
+
+/**
+ * @brief
+ *  Saves radii and angles as binary points file (format see BinaryPointsHeader),
+ *  e.g. to generate graphs for them later without parsing text (see MappedPoints).
+ *
+ * @param R
+ *  The radius of the disk, which must exceed all radii.
+ */
+HYPERGIRGS_API void savePoints(const std::vector<double>& radii, const std::vector<double>& angles, double R, const std::string& file);
+
+
+/**
+ * @brief
+ *  Memory maps a binary points file of hyperbolic coordinates (see savePoints()) read-only.
+ *  radii() and angles() point into the mapping, so they can be passed to generateEdges() without copying
+ *  or parsing; the operating system reads the pages of the file on first access and may drop them again.
+ *  The views stay valid for the lifetime of this object.
+ *
+ *  On systems without mmap, the file is read into memory instead.
+ */
+class HYPERGIRGS_API MappedPoints {
+public:
+    /// maps file; throws std::runtime_error if the file is no valid binary points file with radii and angles
+    explicit MappedPoints(const std::string& file);
+    ~MappedPoints();
+
+    MappedPoints(const MappedPoints&) = delete;
+    MappedPoints& operator=(const MappedPoints&) = delete;
+
+    const BinaryPointsHeader& header() const noexcept { return *static_cast<const BinaryPointsHeader*>(m_data); }
+
+    std::size_t size() const noexcept { return static_cast<std::size_t>(header().n); }
+
+    /// the radius of the disk stored by savePoints()
+    double radius() const noexcept { return header().parameters[0]; }
+
+    DoubleView radii() const noexcept;
+    DoubleView angles() const noexcept;
+
+private:
+    void unmap() noexcept;
+
+    const void* m_data = nullptr;   ///< begin of the mapped file
+    std::size_t m_bytes = 0;        ///< size of the mapped file
+    std::vector<double> m_buffer;   ///< holds the file if it cannot be mapped
+};
+
+
+} // namespace hypergirgs
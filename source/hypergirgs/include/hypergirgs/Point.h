@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <cmath>
 
+#include <hypergirgs/Index.h>
+
 #ifndef NDEBUG
 #define POINT_WITH_ORIGINAL
 #endif
@@ -24,7 +26,7 @@ static double hyperbolicDistance(double r1, double phi1, double r2, double phi2)
 
 struct Point {
     Point() {}; // prevent initialization of members
-    Point(const int id, const double radius, const double angle, int cell_id = 0) :
+    Point(const NodeIndex id, const double radius, const double angle, int cell_id = 0) :
           id{id}
         , cell_id{cell_id}
         , invsinh_r{1.0 / std::sinh(radius)}
@@ -75,8 +77,8 @@ struct Point {
         return id != o.id;
     }
 
-    int    id;        ///< node id
-    int    cell_id;   ///< id of cell node will stored
+    NodeIndex id;        ///< node id
+    int       cell_id;   ///< id of cell node will stored
 
     double invsinh_r; ///< = 1.0 / sinh(radius)
     double coth_r;    ///< = coth(radius) = cosh(radius) / sinh(radius)
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <hypergirgs/Point.h>
+
+
+namespace hypergirgs {
+
+
+/**
+ * @brief
+ *  Structure of arrays copy of the precomputed values of a range of points, as read by the type I kernels
+ *  (see TypeIKernel.h). HyperbolicTree copies the points of cell B into columns before comparing them
+ *  with each point of cell A. Aligned to a cache line, as each thread owns one.
+ */
+struct alignas(64) PointColumns {
+    std::vector<double> cos_phi;    ///< cos_phi[k] of the k-th point
+    std::vector<double> sin_phi;    ///< sin_phi[k] of the k-th point
+    std::vector<double> coth_r;     ///< coth_r[k] of the k-th point
+    std::vector<double> invsinh_r;  ///< invsinh_r[k] of the k-th point
+
+    /// replaces the columns by the points [begin, end)
+    void assign(const Point* begin, const Point* end) {
+        const auto n = static_cast<std::size_t>(end - begin);
+        cos_phi.resize(n);
+        sin_phi.resize(n);
+        coth_r.resize(n);
+        invsinh_r.resize(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            cos_phi[k] = begin[k].cos_phi;
+            sin_phi[k] = begin[k].sin_phi;
+            coth_r[k] = begin[k].coth_r;
+            invsinh_r[k] = begin[k].invsinh_r;
+        }
+    }
+
+    std::size_t size() const noexcept { return cos_phi.size(); }
+};
+
+
+} // namespace hypergirgs
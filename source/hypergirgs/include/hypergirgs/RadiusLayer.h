@@ -6,6 +6,8 @@
 #include <utility>
 
 #include <hypergirgs/AngleHelper.h>
+#include <hypergirgs/DoubleView.h>
+#include <hypergirgs/Index.h>
 #include <hypergirgs/Point.h>
 
 #include <hypergirgs/hypergirgs_api.h>
@@ -21,9 +23,9 @@ public:
 
 	RadiusLayer(double r_min, double r_max, unsigned int targetLevel,
                 const Point* base,
-                const unsigned int* prefix_sum);
+                const NodeOffset* prefix_sum);
 
-    int pointsInCell(unsigned int cell, unsigned int level) const {
+    NodeOffset pointsInCell(unsigned int cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
         assert(cellBoundaries.first  + AngleHelper::firstCellOfLevel(level) < AngleHelper::firstCellOfLevel(m_target_level+1));
         assert(cellBoundaries.second + AngleHelper::firstCellOfLevel(level) < AngleHelper::firstCellOfLevel(m_target_level+1));
@@ -31,7 +33,7 @@ public:
         return m_prefix_sums[cellBoundaries.second+1] - m_prefix_sums[cellBoundaries.first];
     }
 
-    const Point& kthPoint(unsigned int cell, unsigned int level, int k) const {
+    const Point& kthPoint(unsigned int cell, unsigned int level, NodeOffset k) const {
         auto cellBoundaries = levelledCell(cell, level);
         return m_base[m_prefix_sums[cellBoundaries.first] + k];
     }
@@ -47,9 +49,9 @@ public:
 
     // static generation and helper
     static std::vector<RadiusLayer>
-    buildPartition(const std::vector<double>& radii, const std::vector<double>& angles,
+    buildPartition(DoubleView radii, DoubleView angles,
                    const double R, const double layer_height,
-                   std::vector<Point>& points, std::vector<unsigned int>& first_in_cell, // output parameter
+                   std::vector<Point>& points, std::vector<NodeOffset>& first_in_cell, // output parameter
                    bool enable_profiling);
 
 
@@ -93,7 +95,7 @@ public:
 
 protected:
     const Point* m_base;                ///< sorted array of all points
-    const unsigned int* m_prefix_sums;  ///< for each cell c in target level: sum of points in m_base before first node in c
+    const NodeOffset*   m_prefix_sums;  ///< for each cell c in target level: sum of points in m_base before first node in c
 
 };
 
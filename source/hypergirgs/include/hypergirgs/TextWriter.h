@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <ostream>
+#include <charconv>
+#include <algorithm>
+#include <cstddef>
+
+#include <omp.h>
+
+
+namespace hypergirgs {
+
+
+/// appends the decimal representation of value to buffer; same text as std::ostream::operator<<
+template<typename Integer>
+void appendInteger(std::string& buffer, Integer value) {
+    std::array<char, 24> digits;
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+    buffer.append(digits.data(), result.ptr);
+}
+
+/// appends value with precision digits after the decimal point; same text as std::ostream with std::fixed and std::setprecision(precision)
+inline void appendFixed(std::string& buffer, double value, int precision) {
+    std::array<char, 400> digits; // the largest double has 309 digits before the decimal point
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value, std::chars_format::fixed, precision);
+    buffer.append(digits.data(), result.ptr);
+}
+
+/**
+ * @brief
+ *  Writes the text of count items to out.
+ *  The items are split into chunks which the threads format into local buffers in parallel.
+ *  The buffers are written in the order of the chunks, while other threads already format the next chunks.
+ *
+ * @param format
+ *  Called as format(i, buffer) for each item i in [0, count); appends the text of item i to buffer.
+ *  Called concurrently for items of different chunks.
+ */
+template<typename Format>
+void writeChunked(std::ostream& out, std::size_t count, Format format) {
+    constexpr std::size_t chunk_size = 1 << 14;
+    const auto num_chunks = static_cast<long long>((count + chunk_size - 1) / chunk_size);
+
+    #pragma omp parallel
+    {
+        std::string buffer;
+
+        #pragma omp for ordered schedule(static, 1)
+        for (long long chunk = 0; chunk < num_chunks; ++chunk) {
+            const auto begin = static_cast<std::size_t>(chunk) * chunk_size;
+            const auto end = std::min(begin + chunk_size, count);
+            buffer.clear();
+            for (auto i = begin; i < end; ++i)
+                format(i, buffer);
+
+            #pragma omp ordered
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+    }
+}
+
+
+} // namespace hypergirgs
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <hypergirgs/hypergirgs_api.h>
+#include <hypergirgs/Point.h>
+#include <hypergirgs/PointColumns.h>
+
+// Load implementations; the vectorized kernels are compiled on x86-64 with gcc or clang
+// for their instruction set only and are used if the cpu supports it (see typeIKernel())
+#include <hypergirgs/TypeIKernelGeneric.inl>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define HYPERGIRGS_HAS_AVX_KERNELS
+    // avx512f implies fma, and gcc would fuse the products and sums of the kernels into multiply-adds that
+    // round differently than the generic kernels; clang contracts only within an expression, never across intrinsics
+    #ifdef __clang__
+        #define HYPERGIRGS_TARGET_AVX2 __attribute__((target("avx2")))
+        #define HYPERGIRGS_TARGET_AVX512 __attribute__((target("avx2,avx512f")))
+    #else
+        #define HYPERGIRGS_TARGET_AVX2 __attribute__((target("avx2"), optimize("fp-contract=off")))
+        #define HYPERGIRGS_TARGET_AVX512 __attribute__((target("avx2,avx512f"), optimize("fp-contract=off")))
+    #endif
+    #include <hypergirgs/TypeIKernelAVX2.inl>
+    #include <hypergirgs/TypeIKernelAVX512.inl>
+#endif
+
+namespace hypergirgs {
+
+/// The implementations of the type I kernels, see TypeIKernelDetails.
+enum class TypeIKernelImplementation : int {
+    Generic,    ///< scalar, any cpu
+    AVX2,       ///< 4 pairs at once, needs avx2
+    AVX512      ///< 8 pairs at once, needs avx512f
+};
+
+namespace TypeIKernelDetails {
+/// the kernels used by HyperbolicTree, set to detectTypeIKernel() when the library is loaded
+HYPERGIRGS_API extern TypeIKernelImplementation g_selected;
+}
+
+/// @return whether impl can run on this cpu
+HYPERGIRGS_API bool typeIKernelAvailable(TypeIKernelImplementation impl) noexcept;
+
+/// @return the widest implementation the cpu supports
+HYPERGIRGS_API TypeIKernelImplementation detectTypeIKernel() noexcept;
+
+/// @return the implementation used by HyperbolicTree
+inline TypeIKernelImplementation typeIKernel() noexcept {
+    return TypeIKernelDetails::g_selected;
+}
+
+/**
+ * @brief
+ *  Overrides the detected implementation, e.g. for benchmarks or if AVX-512 clocks down the cpu.
+ *  Must not be called while graphs are generated.
+ *
+ * @throw std::invalid_argument if impl is not available on this cpu
+ */
+HYPERGIRGS_API void setTypeIKernel(TypeIKernelImplementation impl);
+
+/// @return the name of impl ("Generic", "AVX2" or "AVX512")
+HYPERGIRGS_API std::string typeIKernelName(TypeIKernelImplementation impl);
+
+/**
+ * @brief
+ *  Kernels that compare one point a of cell A with a contiguous range of points of cell B, given as PointColumns
+ *  (see HyperbolicTree::sampleTypeI). All implementations provide
+ *   - threshold(a, coshR, points, begin, end, emit): calls emit(k) for each k in [begin, end)
+ *     with Point::isDistanceBelowR() in increasing order of k.
+ *   - distancesCosh(a, points, begin, end, out): writes Point::hyperbolicDistanceCosh() of a and k to out[k - begin].
+ *  All implementations perform the same floating point operations as Point and hence produce identical results.
+ *
+ *  Calls f with an object of the selected kernel type, i.e. the kernels are chosen once per call
+ *  and f is usually a generic lambda taking the kernel as auto.
+ */
+template <typename Functor>
+void dispatchTypeIKernel(Functor&& f) {
+    switch (typeIKernel()) {
+#ifdef HYPERGIRGS_HAS_AVX_KERNELS
+        case TypeIKernelImplementation::AVX512: return f(TypeIKernelDetails::AVX512::Implementation());
+        case TypeIKernelImplementation::AVX2:   return f(TypeIKernelDetails::AVX2::Implementation());
+#endif
+        default:                                return f(TypeIKernelDetails::Generic::Implementation());
+    }
+}
+
+} // namespace hypergirgs
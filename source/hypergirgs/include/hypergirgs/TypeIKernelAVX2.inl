@@ -0,0 +1,60 @@
+#pragma once
+
+#include <immintrin.h>
+
+namespace hypergirgs {
+namespace TypeIKernelDetails {
+namespace AVX2 {
+struct Implementation {
+    static constexpr unsigned kLanes = 4;
+
+    using Scalar = Generic::Implementation;
+
+    template <typename Callback>
+    HYPERGIRGS_TARGET_AVX2 static void threshold(const Point& a, double coshR, const PointColumns& points,
+                          std::size_t begin, std::size_t end, Callback&& emit) {
+        const auto cos_phi = _mm256_set1_pd(a.cos_phi);
+        const auto sin_phi = _mm256_set1_pd(a.sin_phi);
+        const auto coth_r = _mm256_set1_pd(a.coth_r);
+        const auto coshR_invsinh_r = _mm256_set1_pd(coshR * a.invsinh_r);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto lhs = _mm256_add_pd(_mm256_mul_pd(cos_phi, _mm256_loadu_pd(points.cos_phi.data() + k)),
+                                           _mm256_mul_pd(sin_phi, _mm256_loadu_pd(points.sin_phi.data() + k)));
+            const auto rhs = _mm256_sub_pd(_mm256_mul_pd(coth_r, _mm256_loadu_pd(points.coth_r.data() + k)),
+                                           _mm256_mul_pd(coshR_invsinh_r, _mm256_loadu_pd(points.invsinh_r.data() + k)));
+            auto mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_GT_OQ)));
+            while (mask) {
+                emit(k + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        Scalar::threshold(a, coshR, points, k, end, emit);
+    }
+
+    HYPERGIRGS_TARGET_AVX2 static void distancesCosh(const Point& a, const PointColumns& points,
+                              std::size_t begin, std::size_t end, double* out) noexcept {
+        const auto cos_phi = _mm256_set1_pd(a.cos_phi);
+        const auto sin_phi = _mm256_set1_pd(a.sin_phi);
+        const auto coth_r = _mm256_set1_pd(a.coth_r);
+        const auto invsinh_r = _mm256_set1_pd(a.invsinh_r);
+        const auto one = _mm256_set1_pd(1.0);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            auto numerator = _mm256_sub_pd(_mm256_mul_pd(coth_r, _mm256_loadu_pd(points.coth_r.data() + k)),
+                                           _mm256_mul_pd(cos_phi, _mm256_loadu_pd(points.cos_phi.data() + k)));
+            numerator = _mm256_sub_pd(numerator, _mm256_mul_pd(sin_phi, _mm256_loadu_pd(points.sin_phi.data() + k)));
+            const auto denominator = _mm256_mul_pd(invsinh_r, _mm256_loadu_pd(points.invsinh_r.data() + k));
+            // maxpd returns its second operand unless the first is larger, as std::max(1.0, x)
+            _mm256_storeu_pd(out + (k - begin), _mm256_max_pd(_mm256_div_pd(numerator, denominator), one));
+        }
+
+        Scalar::distancesCosh(a, points, k, end, out + (k - begin));
+    }
+};
+} // namespace AVX2
+} // namespace TypeIKernelDetails
+} // namespace hypergirgs
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <immintrin.h>
+
+namespace hypergirgs {
+namespace TypeIKernelDetails {
+namespace AVX512 {
+struct Implementation {
+    static constexpr unsigned kLanes = 8;
+
+    using Scalar = Generic::Implementation;
+
+    template <typename Callback>
+    HYPERGIRGS_TARGET_AVX512 static void threshold(const Point& a, double coshR, const PointColumns& points,
+                          std::size_t begin, std::size_t end, Callback&& emit) {
+        const auto cos_phi = _mm512_set1_pd(a.cos_phi);
+        const auto sin_phi = _mm512_set1_pd(a.sin_phi);
+        const auto coth_r = _mm512_set1_pd(a.coth_r);
+        const auto coshR_invsinh_r = _mm512_set1_pd(coshR * a.invsinh_r);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            const auto lhs = _mm512_add_pd(_mm512_mul_pd(cos_phi, _mm512_loadu_pd(points.cos_phi.data() + k)),
+                                           _mm512_mul_pd(sin_phi, _mm512_loadu_pd(points.sin_phi.data() + k)));
+            const auto rhs = _mm512_sub_pd(_mm512_mul_pd(coth_r, _mm512_loadu_pd(points.coth_r.data() + k)),
+                                           _mm512_mul_pd(coshR_invsinh_r, _mm512_loadu_pd(points.invsinh_r.data() + k)));
+            auto mask = static_cast<unsigned>(_mm512_cmp_pd_mask(lhs, rhs, _CMP_GT_OQ));
+            while (mask) {
+                emit(k + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        Scalar::threshold(a, coshR, points, k, end, emit);
+    }
+
+    HYPERGIRGS_TARGET_AVX512 static void distancesCosh(const Point& a, const PointColumns& points,
+                              std::size_t begin, std::size_t end, double* out) noexcept {
+        const auto cos_phi = _mm512_set1_pd(a.cos_phi);
+        const auto sin_phi = _mm512_set1_pd(a.sin_phi);
+        const auto coth_r = _mm512_set1_pd(a.coth_r);
+        const auto invsinh_r = _mm512_set1_pd(a.invsinh_r);
+        const auto one = _mm512_set1_pd(1.0);
+
+        auto k = begin;
+        for (; k + kLanes <= end; k += kLanes) {
+            auto numerator = _mm512_sub_pd(_mm512_mul_pd(coth_r, _mm512_loadu_pd(points.coth_r.data() + k)),
+                                           _mm512_mul_pd(cos_phi, _mm512_loadu_pd(points.cos_phi.data() + k)));
+            numerator = _mm512_sub_pd(numerator, _mm512_mul_pd(sin_phi, _mm512_loadu_pd(points.sin_phi.data() + k)));
+            const auto denominator = _mm512_mul_pd(invsinh_r, _mm512_loadu_pd(points.invsinh_r.data() + k));
+            // maxpd returns its second operand unless the first is larger, as std::max(1.0, x)
+            _mm512_storeu_pd(out + (k - begin), _mm512_max_pd(_mm512_div_pd(numerator, denominator), one));
+        }
+
+        Scalar::distancesCosh(a, points, k, end, out + (k - begin));
+    }
+};
+} // namespace AVX512
+} // namespace TypeIKernelDetails
+} // namespace hypergirgs
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+
+namespace hypergirgs {
+namespace TypeIKernelDetails {
+namespace Generic {
+struct Implementation {
+    static constexpr unsigned kLanes = 1;
+
+    /// same as a.isDistanceBelowR() for the k-th point
+    static bool isDistanceBelowR(const Point& a, double coshR, const PointColumns& points, std::size_t k) noexcept {
+        return a.cos_phi * points.cos_phi[k] + a.sin_phi * points.sin_phi[k] >
+            a.coth_r * points.coth_r[k] - coshR * a.invsinh_r * points.invsinh_r[k];
+    }
+
+    template <typename Callback>
+    static void threshold(const Point& a, double coshR, const PointColumns& points,
+                          std::size_t begin, std::size_t end, Callback&& emit) {
+        for (auto k = begin; k < end; ++k) {
+            if (isDistanceBelowR(a, coshR, points, k))
+                emit(k);
+        }
+    }
+
+    static void distancesCosh(const Point& a, const PointColumns& points,
+                              std::size_t begin, std::size_t end, double* out) noexcept {
+        for (auto k = begin; k < end; ++k)
+            out[k - begin] = std::max(1.0, (a.coth_r * points.coth_r[k] - a.cos_phi * points.cos_phi[k] - a.sin_phi * points.sin_phi[k])
+                                           / (a.invsinh_r * points.invsinh_r[k]));
+    }
+};
+} // namespace Generic
+} // namespace TypeIKernelDetails
+} // namespace hypergirgs
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <omp.h>
+
+#include <hypergirgs/Philox.h>
+
+
+namespace hypergirgs {
+
+
+/**
+ * @brief
+ *  Generates count uniform variates in [0, 1) in chunks and passes each chunk to store.
+ *  The k-th variate is the k-th number of the PhiloxStream (key, stream, 0) with key = seed.
+ *  Hence, the variates do not depend on the number of threads.
+ *  The chunks are filled with PhiloxStream::fillUniform(), so store should transform them in a tight loop.
+ *
+ * @param seed
+ *  A negative seed draws a random key from std::random_device.
+ * @param stream
+ *  Distinguishes the variates of different quantities that use the same seed.
+ * @param parallel
+ *  Whether multiple threads are used.
+ * @param store
+ *  Called as store(first, uniforms, size) with the variates first, ..., first+size-1.
+ *  Called concurrently for different chunks.
+ */
+template<typename Store>
+void generateVariates(std::size_t count, int seed, uint32_t stream, bool parallel, Store store) {
+    constexpr std::size_t kChunkSize = 1 << 12;
+    constexpr std::size_t kMinPerThread = 10000;
+
+    const auto key = seed >= 0 ? static_cast<uint64_t>(seed)
+        : (static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()();
+    const auto num_chunks = static_cast<long long>((count + kChunkSize - 1) / kChunkSize);
+    const auto threads = parallel ? static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(omp_get_max_threads(), count / kMinPerThread))) : 1;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        auto uniforms = std::vector<double>(kChunkSize);
+
+        #pragma omp for schedule(static)
+        for (long long chunk = 0; chunk < num_chunks; ++chunk) {
+            const auto first = static_cast<std::size_t>(chunk) * kChunkSize;
+            const auto size = std::min(kChunkSize, count - first);
+            PhiloxStream::fillUniform(uniforms.data(), size, key, stream, 0, first);
+            store(first, uniforms.data(), size);
+        }
+    }
+}
+
+
+} // namespace hypergirgs
@@ -4,17 +4,23 @@
 #include <random>
 #include <fstream>
 #include <cmath>
-#include <mutex>
+#include <limits>
+#include <stdexcept>
 
 #include <omp.h>
 
+#include <hypergirgs/CSRBuilder.h>
+#include <hypergirgs/EdgeBuffer.h>
+#include <hypergirgs/EdgeCollector.h>
 #include <hypergirgs/HyperbolicTree.h>
+#include <hypergirgs/TextWriter.h>
+#include <hypergirgs/Variates.h>
 
 
 namespace hypergirgs {
 
 
-double calculateRadius(int n, double alpha, double T, double deg) {
+double calculateRadius(NodeIndex n, double alpha, double T, double deg) {
     return 2 * log(n * 2 * alpha * alpha * (T == 0 ? 1 / PI : T / sin(PI * T)) /
                    (deg * (alpha - 0.5) * (alpha - 0.5)));
 }
@@ -75,21 +81,22 @@ static double getTargetRadius(double n, double m, double alpha=1, double T=0, do
 }
 ////////////////////////////////// END NETWORKIT COPY ////////////////////
 
-double calculateRadiusLikeNetworKit(int n, double alpha, double T, double deg) {
+double calculateRadiusLikeNetworKit(NodeIndex n, double alpha, double T, double deg) {
     return getTargetRadius(n, 0.5*deg*n, alpha, T);
 }
 
 template <bool Radii, bool Angles>
 static std::pair<std::vector<double>, std::vector<double>> sampleRadiiAndAnglesHelper(
-    const int n, const double alpha, const double R, const int seed, const bool parallel
+    const NodeIndex n, const double alpha, const double R, const int seed, const bool parallel
 ) {
     static_assert(Radii || Angles, "At least one output is required");
 
     std::vector<double> radii(n * Radii);
     std::vector<double> angles(n * Angles);
 
+#ifdef USE_LEGACY_VARIATES
     constexpr auto kMinChunkSize = 10000;
-    const auto threads = parallel ? std::min<int>(omp_get_max_threads(), (n + kMinChunkSize - 1) / kMinChunkSize) : 1;
+    const auto threads = parallel ? static_cast<int>(std::min<NodeIndex>(omp_get_max_threads(), (n + kMinChunkSize - 1) / kMinChunkSize)) : 1;
 
     const auto invalpha = 1.0 / alpha;
     #pragma omp parallel num_threads(threads)
@@ -100,11 +107,11 @@ static std::pair<std::vector<double>, std::vector<double>> sampleRadiiAndAnglesH
 
         // warm-up generator
         constexpr int kMinWarmup = 1000;
-        for (int i = 0; i < std::max<int>(n / threads / 5, kMinWarmup); ++i)
+        for (NodeIndex i = 0; i < std::max<NodeIndex>(n / threads / 5, kMinWarmup); ++i)
             gen();
 
         #pragma omp for schedule(static)
-        for (int i = 0; i < n; ++i) {
+        for (NodeIndex i = 0; i < n; ++i) {
             if (Angles)
                 angles[i] = adist(gen);
 
@@ -112,62 +119,124 @@ static std::pair<std::vector<double>, std::vector<double>> sampleRadiiAndAnglesH
                 radii[i] = acosh(rdist(gen)) * invalpha;
         }
     }
+#else
+    // streams of generateVariates()
+    constexpr uint32_t kRadiusStream = 1;
+    constexpr uint32_t kAngleStream = 2;
+
+    if (Angles) {
+        // scaling may round up to 2pi, which is not a valid angle
+        const auto max_angle = std::nextafter(2*PI, 0.0);
+        generateVariates(n, seed, kAngleStream, parallel, [&] (std::size_t first, const double* uniforms, std::size_t size) {
+            for (std::size_t k = 0; k < size; ++k)
+                angles[first + k] = std::min(uniforms[k] * (2*PI), max_angle);
+        });
+    }
+
+    if (Radii) {
+        // inverse CDF of the radial density, cosh(alpha r) is uniform in (1, cosh(alpha R))
+        const auto invalpha = 1.0 / alpha;
+        const auto lower = std::nextafter(1.0, 2.0);
+        const auto width = std::cosh(alpha * R) - lower;
+        generateVariates(n, seed, kRadiusStream, parallel, [&] (std::size_t first, const double* uniforms, std::size_t size) {
+            for (std::size_t k = 0; k < size; ++k)
+                radii[first + k] = std::acosh(lower + width * uniforms[k]) * invalpha;
+        });
+    }
+#endif
 
     return {radii, angles};
 }
 
 
-std::vector<double> sampleRadii(int n, double alpha, double R, int seed, bool parallel) {
+std::vector<double> sampleRadii(NodeIndex n, double alpha, double R, int seed, bool parallel) {
     return sampleRadiiAndAnglesHelper<true, false>(n, alpha, R, seed, parallel).first;
 }
 
-std::vector<double> sampleAngles(int n, int seed, bool parallel) {
+std::vector<double> sampleAngles(NodeIndex n, int seed, bool parallel) {
     return sampleRadiiAndAnglesHelper<false, true>(n, /*unused*/1.0, /*unused*/10.0, seed, parallel).second;
 
 }
 
-std::pair<std::vector<double>, std::vector<double>> sampleRadiiAndAngles(int n, double alpha, double R, int seed, bool parallel) {
+std::pair<std::vector<double>, std::vector<double>> sampleRadiiAndAngles(NodeIndex n, double alpha, double R, int seed, bool parallel) {
     return sampleRadiiAndAnglesHelper<true, true>(n, alpha, R, seed, parallel);
 }
 
-std::vector<std::pair<int, int> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed) {
+void generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed,
+        const EdgeBlockCallback& consumer, std::size_t blockSize, unsigned int shard, unsigned int numShards) {
+    generateEdges(DoubleView(radii), DoubleView(angles), T, R, seed, consumer, blockSize, shard, numShards);
+}
 
-    using edge_vector = std::vector<std::pair<int, int>>;
-    edge_vector result;
+std::vector<Edge> generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed) {
+    return generateEdges(DoubleView(radii), DoubleView(angles), T, R, seed);
+}
 
-    std::vector<std::pair<
-            edge_vector,
-            uint64_t[31] /* avoid false sharing */
-    > > local_edges(omp_get_max_threads());
+CSRGraph generateCSR(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed) {
+    return generateCSR(DoubleView(radii), DoubleView(angles), T, R, seed);
+}
 
-    constexpr auto block_size = size_t{1} << 20;
+void generateEdges(DoubleView radii, DoubleView angles, double T, double R, int seed,
+        const EdgeBlockCallback& consumer, std::size_t blockSize, unsigned int shard, unsigned int numShards) {
 
-    for(auto& v : local_edges)
-        v.first.reserve(block_size);
+    auto buffer = EdgeBuffer<const EdgeBlockCallback>(consumer, blockSize);
 
-    std::mutex m;
-    auto flush = [&] (const edge_vector& local) {
-        std::lock_guard<std::mutex> lock(m);
-        result.insert(result.end(), local.cbegin(), local.cend());
-    };
+    auto generator = hypergirgs::makeHyperbolicTree(radii, angles, T, R, buffer);
+    generator.generate(seed, shard, numShards);
 
-    auto addEdge = [&](int u, int v, int tid) {
-        auto& local = local_edges[tid].first;
-        local.emplace_back(u,v);
-        if (local.size() == block_size) {
-            flush(local);
-            local.clear();
-            local.reserve(block_size); // just in case
-        }
-    };
+    buffer.flushAll();
+}
+
+std::vector<Edge> generateEdges(DoubleView radii, DoubleView angles, double T, double R, int seed) {
+
+    auto collector = EdgeCollector();
+
+    auto generator = hypergirgs::makeHyperbolicTree(radii, angles, T, R, collector);
+    generator.generate(seed);
+
+    return collector.collect();
+}
+
+CSRGraph generateCSR(DoubleView radii, DoubleView angles, double T, double R, int seed) {
+
+    // both passes have to produce the same edges, so we must not draw a fresh random seed per pass
+    if (seed < 0)
+        seed = static_cast<int>(std::random_device{}() >> 1);
+
+    auto builder = CSRBuilder(radii.size());
 
-    auto generator = hypergirgs::makeHyperbolicTree(radii, angles, T, R, addEdge);
+    auto generator = hypergirgs::makeHyperbolicTree(radii, angles, T, R, builder);
+    generator.generate(seed);
+    builder.finishCounting();
     generator.generate(seed);
 
-    for(const auto& v : local_edges)
-        flush(v.first);
+    return builder.finish();
+}
 
-    return result;
+void saveEdgeList(NodeIndex n, const std::vector<Edge>& graph, const std::string& file) {
+    std::ofstream f{file};
+    if(!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f << n << ' ' << graph.size() << "\n\n";
+    writeChunked(f, graph.size(), [&] (std::size_t i, std::string& buffer) {
+        appendInteger(buffer, graph[i].first);
+        buffer += ' ';
+        appendInteger(buffer, graph[i].second);
+        buffer += '\n';
+    });
+}
+
+void saveCoordinates(DoubleView radii, DoubleView angles, const std::string& file) {
+    assert(radii.size() == angles.size());
+    std::ofstream f{file};
+    if(!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    constexpr auto precision = std::numeric_limits<double>::max_digits10;
+    writeChunked(f, radii.size(), [&] (std::size_t i, std::string& buffer) {
+        appendFixed(buffer, radii[i], precision);
+        buffer += ' ';
+        appendFixed(buffer, angles[i], precision);
+        buffer += '\n';
+    });
 }
 
 } // namespace hypergirgs
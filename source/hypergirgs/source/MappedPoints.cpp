@@ -0,0 +1,116 @@
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <hypergirgs/MappedPoints.h>
+
+
+namespace hypergirgs {
+
+
+void savePoints(const std::vector<double>& radii, const std::vector<double>& angles, double R, const std::string& file) {
+    if (radii.size() != angles.size())
+        throw std::invalid_argument{"Error: need one angle per radius"};
+
+    auto header = BinaryPointsHeader();
+    header.n = radii.size();
+    header.parameters[0] = R;
+
+    std::ofstream f{file, std::ios::binary};
+    if (!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    f.write(reinterpret_cast<const char*>(radii.data()), static_cast<std::streamsize>(radii.size() * sizeof(double)));
+    f.write(reinterpret_cast<const char*>(angles.data()), static_cast<std::streamsize>(angles.size() * sizeof(double)));
+    if (!f)
+        throw std::runtime_error{"Error: failed to write file \"" + file + '\"'};
+}
+
+
+MappedPoints::MappedPoints(const std::string& file) {
+    auto fail = [&] (const std::string& reason) {
+        throw std::runtime_error{"Error: \"" + file + "\" " + reason};
+    };
+
+#ifndef _WIN32
+    const auto fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        fail("cannot be opened");
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(BinaryPointsHeader))) {
+        ::close(fd);
+        fail("is no binary points file of version 1");
+    }
+    m_bytes = static_cast<std::size_t>(info.st_size);
+
+    auto* data = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED)
+        fail("cannot be mapped");
+    m_data = data;
+
+    // the generators read the weights and positions front to back
+    ::madvise(data, m_bytes, MADV_SEQUENTIAL);
+#else
+    std::ifstream f{file, std::ios::binary | std::ios::ate};
+    if (!f.is_open())
+        fail("cannot be opened");
+    m_bytes = static_cast<std::size_t>(f.tellg());
+    if (m_bytes < sizeof(BinaryPointsHeader))
+        fail("is no binary points file of version 1");
+
+    m_buffer.resize((m_bytes + sizeof(double) - 1) / sizeof(double));
+    f.seekg(0);
+    if (!f.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_bytes)))
+        fail("cannot be read");
+    m_data = m_buffer.data();
+#endif
+
+    const auto expected = BinaryPointsHeader();
+    const auto& h = header();
+    if (h.magic != expected.magic || h.version != expected.version || h.model != 1 || h.dimension != 1) {
+        unmap();
+        fail("is no binary points file of version 1 with radii and angles");
+    }
+
+    // divide rather than multiply, as a crafted n could overflow 2 * n
+    const auto num_values = (m_bytes - sizeof(BinaryPointsHeader)) / sizeof(double);
+    if ((m_bytes - sizeof(BinaryPointsHeader)) % sizeof(double) || num_values % 2 || h.n != num_values / 2) {
+        unmap();
+        fail("is truncated or has a wrong size");
+    }
+}
+
+MappedPoints::~MappedPoints() {
+    unmap();
+}
+
+void MappedPoints::unmap() noexcept {
+#ifndef _WIN32
+    if (m_data)
+        ::munmap(const_cast<void*>(m_data), m_bytes);
+#else
+    m_buffer.clear();
+#endif
+    m_data = nullptr;
+}
+
+DoubleView MappedPoints::radii() const noexcept {
+    const auto* base = reinterpret_cast<const double*>(static_cast<const char*>(m_data) + sizeof(BinaryPointsHeader));
+    return {base, size()};
+}
+
+DoubleView MappedPoints::angles() const noexcept {
+    const auto* base = reinterpret_cast<const double*>(static_cast<const char*>(m_data) + sizeof(BinaryPointsHeader));
+    return {base + size(), size()};
+}
+
+
+} // namespace hypergirgs
@@ -13,7 +13,7 @@ namespace hypergirgs {
 
 RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel,
                          const Point* base,
-                         const unsigned int* prefix_sum)
+                         const NodeOffset* prefix_sum)
     : m_r_min{r_min}, 
       m_r_max{r_max}, 
       m_target_level{targetLevel}, 
@@ -34,9 +34,9 @@ RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel,
 #endif
 }
 
-std::vector<RadiusLayer> RadiusLayer::buildPartition(const std::vector<double>& radii, const std::vector<double>& angles,
+std::vector<RadiusLayer> RadiusLayer::buildPartition(DoubleView radii, DoubleView angles,
                             const double R, const double layer_height, 
-                            std::vector<Point>& points, std::vector<unsigned int>& first_in_cell, // output parameter
+                            std::vector<Point>& points, std::vector<NodeOffset>& first_in_cell, // output parameter
                             bool enable_profiling) {
 
     assert(radii.size() == angles.size());
@@ -83,7 +83,7 @@ std::vector<RadiusLayer> RadiusLayer::buildPartition(const std::vector<double>&
         ScopedTimer timer("Classify points & precompute coordinates", enable_profiling);
 
         #pragma omp parallel for
-        for (int i = 0; i < n; ++i) {
+        for (NodeIndex i = 0; i < static_cast<NodeIndex>(n); ++i) {
             assert(0 <= radii[i] && radii[i] < R);
             assert(0 <= angles[i] && angles[i] < 2*PI);
 
@@ -100,8 +100,10 @@ std::vector<RadiusLayer> RadiusLayer::buildPartition(const std::vector<double>&
 
         auto compare = [](const Point &a, const Point &b) { return a.cell_id < b.cell_id; };
 
-        intsort::intsort(points, [](const Point &p) { return p.cell_id; }, max_cell_id + 1);
-        //alternatively: std::sort(points.begin(), points.end(), compare);
+        // points are created in the order of their ids, so the stable sort (and thus the graph) does not depend on the method
+        intsort::intsort_stable(points, [](const Point &p) { return p.cell_id; }, max_cell_id + 1,
+                                [](const Point &a, const Point &b) { return a.id < b.id; });
+        //alternatively: std::stable_sort(points.begin(), points.end(), compare);
 
         assert(std::is_sorted(points.begin(), points.end(), compare));
     }
@@ -110,8 +112,8 @@ std::vector<RadiusLayer> RadiusLayer::buildPartition(const std::vector<double>&
     for (num_layers = 1; first_cell_of_layer[num_layers - 1] > points[0].cell_id; ++num_layers) {}
 
     // compute pointers (prefix sums) into points
-    constexpr auto gap_cell_indicator = std::numeric_limits<unsigned int>::max();
-    first_in_cell = std::vector<unsigned int>(max_cell_id + 1, gap_cell_indicator);
+    constexpr auto gap_cell_indicator = std::numeric_limits<NodeOffset>::max();
+    first_in_cell = std::vector<NodeOffset>(max_cell_id + 1, gap_cell_indicator);
     {
         ScopedTimer timer("Find first point in cell", enable_profiling);
 
@@ -122,7 +124,7 @@ std::vector<RadiusLayer> RadiusLayer::buildPartition(const std::vector<double>&
         first_in_cell[max_cell_id] = n;
 
         #pragma omp parallel for
-        for (int i = 1; i < n; ++i) {
+        for (NodeIndex i = 1; i < static_cast<NodeIndex>(n); ++i) {
             if (points[i - 1].cell_id != points[i].cell_id) {
                 first_in_cell[points[i].cell_id] = i;
             }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <tuple>
+
+#include <satgirgs/satgirgs_api.h>
+#include <satgirgs/Generator.h>
+
+
+namespace satgirgs {
+
+
+/**
+ * @brief
+ *  Header of a binary edge list file (see saveBinary()).
+ *  The header is followed by m rows of #columns unsigned integers with #index_bytes bytes each,
+ *  starting at byte offset sizeof(BinaryEdgeListHeader) = 128. All values are stored in the byte order of the writing machine.
+ *  Hence, the file can be memory mapped and the rows can be accessed in place.
+ */
+struct BinaryEdgeListHeader {
+    std::array<char, 8> magic {{'G','I','R','G','B','I','N','\0'}}; ///< identifies the format
+    uint32_t version     = 1;   ///< version of the format
+    uint32_t index_bytes = 4;   ///< bytes per stored integer: 4 if n <= 2^32, 8 otherwise
+    uint32_t columns     = 2;   ///< integers per row: 2 (u v) or 3 (u v multiplicity)
+    uint32_t model       = 0;   ///< generator of the graph: 0 girgs, 1 hypergirgs, 2 satgirgs
+    uint64_t n           = 0;   ///< number of nodes
+    uint64_t m           = 0;   ///< number of rows
+    std::array<double, 4>  parameters {};   ///< model parameters in the order chosen by the generator (e.g. d, ple, alpha, deg)
+    std::array<int64_t, 4> seeds {};        ///< seeds in the order chosen by the generator
+    std::array<uint8_t, 24> reserved {};    ///< pads the header to 128 bytes
+};
+static_assert(sizeof(BinaryEdgeListHeader) == 128, "the edge data of a binary edge list starts at byte 128");
+
+
+/**
+ * @brief
+ *  Saves an edge list in binary format.
+ *  The threads pack disjoint ranges of edges and write them to their precomputed offsets in the file
+ *  (with pwrite on POSIX systems), so the output bandwidth scales with the number of threads.
+ *
+ * @param header
+ *  Model, parameters, and seeds to store. The fields n, m, index_bytes, and columns are set by this function.
+ * @param n
+ *  The number of nodes.
+ * @param graph
+ *  A deduplicated edge list (see deduplicateEdges()) with zero based indices; stored with 3 columns (u v multiplicity).
+ * @param file
+ *  The name of the output file.
+ */
+SATGIRGS_API void saveBinary(BinaryEdgeListHeader header, int n, const std::vector<std::tuple<int,int,int>>& graph, const std::string& file);
+
+
+} // namespace satgirgs
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <omp.h>
+
+
+namespace satgirgs {
+
+/**
+ * @brief
+ *  Gathers the edges emitted by the clause sampler into a single edge list without locking.
+ *  Each thread appends to its own list of fixed size blocks (so growing never copies edges).
+ *  After sampling, collect() computes the offset of each thread by a prefix sum over the
+ *  per thread edge counts and copies all blocks into one preallocated vector in parallel.
+ */
+class EdgeCollector {
+public:
+    using Edge = std::pair<int, int>;
+
+    explicit EdgeCollector(std::size_t blockSize = std::size_t{1} << 16, int threads = omp_get_max_threads())
+        : m_block_size(blockSize)
+        , m_local_blocks(threads)
+    {}
+
+    void operator()(int u, int v, int tid) {
+        auto& blocks = m_local_blocks[tid].first;
+        if (blocks.empty() || blocks.back().size() == m_block_size) {
+            blocks.emplace_back();
+            blocks.back().reserve(m_block_size);
+        }
+        blocks.back().emplace_back(u, v);
+    }
+
+    /// number of edges collected so far; must not be called during sampling
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& local : m_local_blocks)
+            for (const auto& block : local.first)
+                total += block.size();
+        return total;
+    }
+
+    /**
+     * @brief
+     *  Moves all collected edges into one vector.
+     *  The edges of thread 0 come first, followed by those of thread 1 and so on.
+     *  The collector is empty afterwards.
+     */
+    std::vector<Edge> collect() {
+        const auto threads = static_cast<int>(m_local_blocks.size());
+
+        // offsets[t] = number of edges of all threads before t
+        std::vector<std::size_t> offsets(threads + 1, 0);
+        for (int tid = 0; tid < threads; ++tid) {
+            std::size_t local = 0;
+            for (const auto& block : m_local_blocks[tid].first)
+                local += block.size();
+            offsets[tid + 1] = offsets[tid] + local;
+        }
+
+        std::vector<Edge> result(offsets[threads]);
+
+        #pragma omp parallel for schedule(static, 1), num_threads(threads)
+        for (int tid = 0; tid < threads; ++tid) {
+            auto* out = result.data() + offsets[tid];
+            auto& blocks = m_local_blocks[tid].first;
+            for (auto& block : blocks) {
+                out = std::copy(block.cbegin(), block.cend(), out);
+                std::vector<Edge>().swap(block); // release memory early to keep the peak low
+            }
+            blocks.clear();
+        }
+
+        return result;
+    }
+
+private:
+    const std::size_t m_block_size;
+
+    std::vector<std::pair<
+            std::vector<std::vector<Edge>>,
+            uint64_t[31] /* avoid false sharing */
+    > > m_local_blocks;
+};
+
+} // namespace satgirgs
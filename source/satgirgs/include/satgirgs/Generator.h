@@ -2,6 +2,9 @@
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <cstddef>
+#include <functional>
 
 #include <satgirgs/satgirgs_api.h>
 #include <satgirgs/Node.h>
@@ -9,6 +12,17 @@
 
 namespace satgirgs {
 
+/// an undirected edge with zero based node indices
+using Edge = std::pair<int, int>;
+
+/**
+ * @brief
+ *  Receives a block of edges emitted by one thread during edge sampling.
+ *  Calls with the same threadId never overlap, calls with different threadIds may run concurrently.
+ *  The edges are only valid during the call.
+ */
+using EdgeBlockCallback = std::function<void(const Edge* edges, std::size_t count, int threadId)>;
+
 
 /**
  * @brief
@@ -86,11 +100,25 @@ SATGIRGS_API std::vector<std::tuple<int,int,int>> deduplicateEdges(std::vector<s
 SATGIRGS_API std::vector<std::pair<int,int>> generateEdges(const std::vector<Node2D>& c_nodes,
         const std::vector<Node2D> &nc_nodes, bool debugMode = false);
 
+/**
+ * @brief
+ *  Same as generateEdges(const std::vector<Node2D>&, const std::vector<Node2D>&, bool) but streams the edges to a consumer.
+ *  Each thread buffers up to blockSize edges before handing them to the consumer.
+ *
+ * @param consumer
+ *  Called for each block of edges (zero based indices, smaller index first) with the id of the producing thread.
+ * @param blockSize
+ *  Maximum number of edges per call of consumer.
+ */
+SATGIRGS_API void generateEdges(const std::vector<Node2D>& c_nodes, const std::vector<Node2D> &nc_nodes,
+        const EdgeBlockCallback& consumer, bool debugMode = false, std::size_t blockSize = std::size_t{1} << 16);
+
 
 /**
  * @brief
  *  Saves the graph in .dot format (graphviz).
  *  The weight is saved as a label and the coordinates as a position attribute for each Node.
+ *  The lines are formatted by all threads in parallel.
  *
  * @param c_nodes
  *  Clause nodes
@@ -106,6 +134,21 @@ SATGIRGS_API std::vector<std::pair<int,int>> generateEdges(const std::vector<Nod
 SATGIRGS_API void saveDot(const std::vector<Node2D>& c_nodes, const std::vector<Node2D>& nc_nodes,
         const std::vector<std::tuple<int,int,int>> &graph, const std::string &file, bool debugMode = false);
 
+/**
+ * @brief
+ *  Saves the graph as text edge list.
+ *  The first line holds the number of nodes and edges, followed by an empty line and one line "u v weight" per edge.
+ *  The lines are formatted by all threads in parallel.
+ *
+ * @param n
+ *  The number of nodes.
+ * @param graph
+ *  An edge list with zero based indices (tuple: node, node, weight).
+ * @param file
+ *  The name of the output file.
+ */
+SATGIRGS_API void saveEdgeList(int n, const std::vector<std::tuple<int,int,int>> &graph, const std::string &file);
+
 
 
 } // namespace satgirgs
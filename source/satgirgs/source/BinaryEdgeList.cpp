@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <omp.h>
+
+#include <satgirgs/BinaryEdgeList.h>
+
+
+namespace satgirgs {
+
+
+namespace {
+
+/// output file that can be written at arbitrary offsets by several threads concurrently
+class BinaryFile {
+public:
+    BinaryFile(const std::string& file, uint64_t size) : m_name(file) {
+#ifndef _WIN32
+        m_fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0 || ::ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            fail();
+#else
+        m_stream.open(file, std::ios::binary | std::ios::trunc);
+        if (!m_stream.is_open())
+            fail();
+        (void)size;
+#endif
+    }
+
+    ~BinaryFile() {
+#ifndef _WIN32
+        if (m_fd >= 0)
+            ::close(m_fd);
+#endif
+    }
+
+    BinaryFile(const BinaryFile&) = delete;
+    BinaryFile& operator=(const BinaryFile&) = delete;
+
+    void write(const void* data, std::size_t bytes, uint64_t offset) {
+#ifndef _WIN32
+        auto begin = static_cast<const char*>(data);
+        while (bytes > 0) {
+            const auto written = ::pwrite(m_fd, begin, bytes, static_cast<off_t>(offset));
+            if (written <= 0)
+                fail();
+            begin += written;
+            offset += written;
+            bytes -= written;
+        }
+#else
+        #pragma omp critical (satgirgs_binary_file)
+        {
+            m_stream.seekp(offset);
+            m_stream.write(static_cast<const char*>(data), bytes);
+        }
+        if (!m_stream)
+            fail();
+#endif
+    }
+
+private:
+    [[noreturn]] void fail() const {
+        throw std::runtime_error{"Error: failed to write file \"" + m_name + '\"'};
+    }
+
+    std::string m_name;
+#ifndef _WIN32
+    int m_fd = -1;
+#else
+    std::ofstream m_stream;
+#endif
+};
+
+
+/// packs rows [begin, end) of the edge list as Index and writes them to their position in the file
+template<typename Index>
+void writeRows(BinaryFile& out, const std::vector<std::tuple<int,int,int>>& graph, std::size_t begin, std::size_t end, std::vector<Index>& buffer) {
+    buffer.resize(3 * (end - begin));
+    for (auto k = begin; k < end; ++k) {
+        buffer[3 * (k - begin)    ] = static_cast<Index>(std::get<0>(graph[k]));
+        buffer[3 * (k - begin) + 1] = static_cast<Index>(std::get<1>(graph[k]));
+        buffer[3 * (k - begin) + 2] = static_cast<Index>(std::get<2>(graph[k]));
+    }
+    out.write(buffer.data(), buffer.size() * sizeof(Index), sizeof(BinaryEdgeListHeader) + 3 * sizeof(Index) * begin);
+}
+
+} // namespace
+
+
+void saveBinary(BinaryEdgeListHeader header, int n, const std::vector<std::tuple<int,int,int>>& graph, const std::string& file) {
+    header.n = static_cast<uint64_t>(n);
+    header.m = graph.size();
+    header.index_bytes = 4; // node indices and multiplicities are int
+    header.columns = 3;
+
+    auto out = BinaryFile(file, sizeof(header) + header.m * header.columns * header.index_bytes);
+    out.write(&header, sizeof(header), 0);
+
+    // each block is packed in a thread local buffer and written with a single call
+    constexpr auto rows_per_block = std::size_t{1} << 16;
+    const auto num_blocks = static_cast<long long>((graph.size() + rows_per_block - 1) / rows_per_block);
+    bool failed = false;
+
+    #pragma omp parallel
+    {
+        std::vector<uint32_t> buffer32;
+        std::vector<uint64_t> buffer64;
+
+        #pragma omp for schedule(static)
+        for (long long block = 0; block < num_blocks; ++block) {
+            const auto begin = static_cast<std::size_t>(block) * rows_per_block;
+            const auto end = std::min(begin + rows_per_block, graph.size());
+            try {
+                if (header.index_bytes == 4)
+                    writeRows(out, graph, begin, end, buffer32);
+                else
+                    writeRows(out, graph, begin, end, buffer64);
+            } catch (const std::runtime_error&) {
+                #pragma omp atomic write
+                failed = true;
+            }
+        }
+    }
+
+    if (failed)
+        throw std::runtime_error{"Error: failed to write file \"" + file + '\"'};
+}
+
+
+} // namespace satgirgs
@@ -3,13 +3,15 @@
 #include <iomanip>
 #include <random>
 #include <functional>
-#include <mutex>
 #include <ios>
 #include <tuple>
 
 #include <omp.h>
 
 #include <satgirgs/Generator.h>
+#include <satgirgs/EdgeBuffer.h>
+#include <satgirgs/EdgeCollector.h>
+#include <satgirgs/TextWriter.h>
 
 
 namespace satgirgs {
@@ -83,33 +85,13 @@ std::vector<std::tuple<int,int,int>> deduplicateEdges(std::vector<std::pair<int,
 }
 
 // we could make this more efficient using a k-d-tree (refer to https://rosettacode.org/wiki/K-d_tree#C.2B.2B for this)
-std::vector<std::pair<int, int>> generateEdges(const std::vector<Node2D> &c_nodes,
-        const std::vector<Node2D> &nc_nodes, bool debugMode) {
-
-    using edge_vector = std::vector<std::pair<int, int>>;
-    edge_vector result;
-
-    std::vector<std::pair<
-            edge_vector,
-            uint64_t[31] /* avoid false sharing */
-    > > local_edges(omp_get_max_threads());
-
-    constexpr auto block_size = size_t{1} << 20;
-
-    std::mutex m;
-    auto flush = [&] (const edge_vector& local) {
-        std::lock_guard<std::mutex> lock(m);
-        result.insert(result.end(), local.cbegin(), local.cend());
-    };
+template<typename EdgeCallback>
+static void sampleEdges(const std::vector<Node2D> &c_nodes, const std::vector<Node2D> &nc_nodes,
+        bool debugMode, EdgeCallback& callback) {
 
     auto addEdge = [&](int u, int v, int tid) {
-        auto& local = local_edges[tid].first;
         if(u > v) std::swap(u, v);
-        local.emplace_back(u,v);
-        if (local.size() == block_size) {
-            flush(local);
-            local.clear();
-        }
+        callback(u, v, tid);
     };
 
     const auto num_threads = omp_get_max_threads();
@@ -136,11 +118,22 @@ std::vector<std::pair<int, int>> generateEdges(const std::vector<Node2D> &c_node
             addEdge(nearest->index, secondNearest->index, threadId);
         }
     }
+}
 
-    for(const auto& v : local_edges)
-        flush(v.first);
+void generateEdges(const std::vector<Node2D> &c_nodes, const std::vector<Node2D> &nc_nodes,
+        const EdgeBlockCallback& consumer, bool debugMode, std::size_t blockSize) {
 
-    return result;
+    auto buffer = EdgeBuffer<const EdgeBlockCallback>(consumer, blockSize);
+    sampleEdges(c_nodes, nc_nodes, debugMode, buffer);
+    buffer.flushAll();
+}
+
+std::vector<std::pair<int, int>> generateEdges(const std::vector<Node2D> &c_nodes,
+        const std::vector<Node2D> &nc_nodes, bool debugMode) {
+
+    auto collector = EdgeCollector();
+    sampleEdges(c_nodes, nc_nodes, debugMode, collector);
+    return collector.collect();
 }
 
 
@@ -151,31 +144,51 @@ void saveDot(const std::vector<Node2D>& c_nodes, const std::vector<Node2D>& nc_n
     if(!f.is_open())
         throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
     f << "graph girg {\n\toverlap=scale;\n\n";
-    f << std::fixed;
-    for (int i = 0; i < nc_nodes.size(); ++i) {
-        f << '\t' << nc_nodes[i].index << " [label=\""
-          << std::setprecision(2) << nc_nodes[i].weight << std::setprecision(6)
-          << "\", pos=\"";
-        for (auto d = 0u; d < nc_nodes[i].coord.size(); ++d)
-            f << (d == 0 ? "" : ",") << nc_nodes[i].coord[d];
-        f << "!\"];\n";
-    }
-    f << std::fixed;
-    if(debugMode){
-        for (int i = 0; i < c_nodes.size(); ++i) {
-            f << '\t' << c_nodes[i].index << " [color=\"red\",style=\"filled\", label=\""
-            << std::setprecision(2) << c_nodes[i].weight << std::setprecision(6)
-            << "\", pos=\"";
-            for (auto d = 0u; d < c_nodes[i].coord.size(); ++d)
-                f << (d == 0 ? "" : ",") << c_nodes[i].coord[d];
-            f << "!\"];\n";
-        }
-    }
+    auto writeNodes = [&f] (const std::vector<Node2D>& nodes, const char* attributes) {
+        writeChunked(f, nodes.size(), [&] (std::size_t i, std::string& buffer) {
+            buffer += '\t';
+            appendInteger(buffer, nodes[i].index);
+            buffer += attributes;
+            buffer += "label=\"";
+            appendFixed(buffer, nodes[i].weight, 2);
+            buffer += "\", pos=\"";
+            for (auto d = 0u; d < nodes[i].coord.size(); ++d) {
+                if (d > 0)
+                    buffer += ',';
+                appendFixed(buffer, nodes[i].coord[d], 6);
+            }
+            buffer += "!\"];\n";
+        });
+    };
+    writeNodes(nc_nodes, " [");
+    if(debugMode)
+        writeNodes(c_nodes, " [color=\"red\",style=\"filled\", ");
     f << '\n';
-    int u, v, w;
-    for (const auto &[u, v, w] : graph)
-        f << '\t' << u << "\t-- " << v << "[label=\"" << w << "\"];\n";
+    writeChunked(f, graph.size(), [&] (std::size_t i, std::string& buffer) {
+        buffer += '\t';
+        appendInteger(buffer, std::get<0>(graph[i]));
+        buffer += "\t-- ";
+        appendInteger(buffer, std::get<1>(graph[i]));
+        buffer += "[label=\"";
+        appendInteger(buffer, std::get<2>(graph[i]));
+        buffer += "\"];\n";
+    });
     f << "}\n";
 }
 
+void saveEdgeList(int n, const std::vector<std::tuple<int, int, int>> &graph, const std::string &file) {
+    std::ofstream f{file};
+    if(!f.is_open())
+        throw std::runtime_error{"Error: failed to open file \"" + file + '\"'};
+    f << n << ' ' << graph.size() << "\n\n";
+    writeChunked(f, graph.size(), [&] (std::size_t i, std::string& buffer) {
+        appendInteger(buffer, std::get<0>(graph[i]));
+        buffer += ' ';
+        appendInteger(buffer, std::get<1>(graph[i]));
+        buffer += ' ';
+        appendInteger(buffer, std::get<2>(graph[i]));
+        buffer += '\n';
+    });
+}
+
 } // namespace satgirgs
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <girgs/BinaryEdgeList.h>
+
+
+// reads back the header and rows of a binary edge list with 32 bit integers
+static std::pair<girgs::BinaryEdgeListHeader, std::vector<uint32_t>> readBinary(const std::string& file) {
+    std::ifstream f{file, std::ios::binary};
+    std::vector<char> bytes{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+
+    girgs::BinaryEdgeListHeader header;
+    EXPECT_GE(bytes.size(), sizeof(header));
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    std::vector<uint32_t> rows((bytes.size() - sizeof(header)) / sizeof(uint32_t));
+    std::memcpy(rows.data(), bytes.data() + sizeof(header), rows.size() * sizeof(uint32_t));
+    return {header, rows};
+}
+
+
+TEST(BinaryEdgeList_test, testRoundTrip)
+{
+    const auto file = std::string("BinaryEdgeList_test.bin");
+
+    // enough edges for several blocks, one of them partial
+    const auto n = 100000;
+    std::vector<girgs::Edge> graph;
+    for (auto i = 0; i < 3 * (1 << 16) + 17; ++i)
+        graph.emplace_back(i % n, (7 * i + 3) % n);
+
+    auto header = girgs::BinaryEdgeListHeader();
+    header.model = 0;
+    header.parameters = {{2.0, 2.5, 1.5, 10.0}};
+    header.seeds = {{12, 130, 1400, 0}};
+    girgs::saveBinary(header, n, graph, file);
+
+    const auto result = readBinary(file);
+    const auto& read = result.first;
+    EXPECT_EQ(std::string(read.magic.data()), "GIRGBIN");
+    EXPECT_EQ(read.version, 1u);
+    EXPECT_EQ(read.index_bytes, 4u);
+    EXPECT_EQ(read.columns, 2u);
+    EXPECT_EQ(read.n, static_cast<uint64_t>(n));
+    EXPECT_EQ(read.m, graph.size());
+    EXPECT_EQ(read.parameters, header.parameters);
+    EXPECT_EQ(read.seeds, header.seeds);
+
+    const auto& rows = result.second;
+    ASSERT_EQ(rows.size(), 2 * graph.size());
+    for (auto k = 0u; k < graph.size(); ++k) {
+        EXPECT_EQ(rows[2*k],   static_cast<uint32_t>(graph[k].first));
+        EXPECT_EQ(rows[2*k+1], static_cast<uint32_t>(graph[k].second));
+    }
+
+    std::remove(file.c_str());
+}
+
+
+TEST(BinaryEdgeList_test, testEmptyGraph)
+{
+    const auto file = std::string("BinaryEdgeList_test_empty.bin");
+
+    girgs::saveBinary(girgs::BinaryEdgeListHeader(), 5, {}, file);
+
+    const auto result = readBinary(file);
+    EXPECT_EQ(result.first.n, 5u);
+    EXPECT_EQ(result.first.m, 0u);
+    EXPECT_TRUE(result.second.empty());
+
+    std::remove(file.c_str());
+}
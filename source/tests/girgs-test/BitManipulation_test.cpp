@@ -2,6 +2,8 @@
 #include <array>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
 // must be here to make ADL work on clang
 template<typename T, size_t D>
@@ -18,14 +20,20 @@ std::ostream &operator<<(std::ostream &o, const std::array<T, D> &c) {
 #include <gtest/gtest.h>
 #include <girgs/BitManipulation.h>
 
+// the BMI2 implementation is compiled on all x86 cpus, but only runs on those with the instruction set
 template <typename T>
 class BitManipulationTest : public ::testing::Test {
 public:
     using Implementation = T;
+
+    void SetUp() override {
+        if (T::name() == "BMI2" && !girgs::mortonImplementationAvailable(girgs::MortonImplementation::BMI2))
+            GTEST_SKIP();
+    }
 };
 
 using Implementations = ::testing::Types<
-#ifdef USE_BMI2
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
     girgs::BitManipulationDetails::BMI2::Implementation<1>,
     girgs::BitManipulationDetails::BMI2::Implementation<2>,
     girgs::BitManipulationDetails::BMI2::Implementation<3>,
@@ -36,7 +44,14 @@ using Implementations = ::testing::Types<
     girgs::BitManipulationDetails::Generic::Implementation<2>,
     girgs::BitManipulationDetails::Generic::Implementation<3>,
     girgs::BitManipulationDetails::Generic::Implementation<4>,
-    girgs::BitManipulationDetails::Generic::Implementation<5>
+    girgs::BitManipulationDetails::Generic::Implementation<5>,
+    girgs::BitManipulationDetails::LUT::Implementation<1>,
+    girgs::BitManipulationDetails::LUT::Implementation<2>,
+    girgs::BitManipulationDetails::LUT::Implementation<3>,
+    girgs::BitManipulationDetails::LUT::Implementation<4>,
+    girgs::BitManipulationDetails::LUT::Implementation<5>,
+    girgs::BitManipulation<2>,
+    girgs::BitManipulation<3>
 >;
 
 TYPED_TEST_SUITE(BitManipulationTest, Implementations,);
@@ -177,3 +192,128 @@ TYPED_TEST(BitManipulationTest, XRef) {
         ASSERT_EQ(cell, depo) << extr;
     }
 }
+
+
+template <typename T>
+class BitManipulation64Test : public BitManipulationTest<T> {};
+
+using Implementations64 = ::testing::Types<
+#ifdef GIRGS_HAS_BMI2_IMPLEMENTATION
+    girgs::BitManipulationDetails::BMI2::Implementation<1, uint64_t>,
+    girgs::BitManipulationDetails::BMI2::Implementation<2, uint64_t>,
+    girgs::BitManipulationDetails::BMI2::Implementation<3, uint64_t>,
+    girgs::BitManipulationDetails::BMI2::Implementation<5, uint64_t>,
+    girgs::BitManipulationDetails::BMI2::Implementation<7, uint64_t>,
+    girgs::BitManipulationDetails::BMI2::Implementation<10, uint64_t>,
+#endif
+    girgs::BitManipulationDetails::Generic::Implementation<1, uint64_t>,
+    girgs::BitManipulationDetails::Generic::Implementation<2, uint64_t>,
+    girgs::BitManipulationDetails::Generic::Implementation<3, uint64_t>,
+    girgs::BitManipulationDetails::Generic::Implementation<5, uint64_t>,
+    girgs::BitManipulationDetails::Generic::Implementation<7, uint64_t>,
+    girgs::BitManipulationDetails::Generic::Implementation<10, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<1, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<2, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<3, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<5, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<7, uint64_t>,
+    girgs::BitManipulationDetails::LUT::Implementation<10, uint64_t>,
+    girgs::BitManipulation<4, uint64_t>
+>;
+
+TYPED_TEST_SUITE(BitManipulation64Test, Implementations64,);
+
+template <unsigned D>
+static uint64_t ReferenceDeposite64(const std::array<uint64_t, D>& coord) {
+    uint64_t res = 0;
+
+    for(int i = 0; i < 64; ++i) {
+        const auto d = i % D;
+        res |= ((coord[d] >> (i / D)) & 1) << i;
+    }
+
+    return res;
+}
+
+template <unsigned D>
+static std::array<uint64_t, D> ReferenceExtract64(uint64_t x) {
+    std::array<uint64_t, D> res;
+    std::fill_n(res.begin(), D, 0);
+
+    for(int i = 0; i < 64; ++i) {
+        const auto d = i % D;
+        const auto k = i / D;
+        res[d] |= ((x >> i) & 1) << k;
+    }
+
+    return res;
+}
+
+// bits of a coordinate beyond its share of the 64 bits are ignored, so random words are valid input
+TYPED_TEST(BitManipulation64Test, DepositeAll) {
+    using Impl = typename TestFixture::Implementation;
+    constexpr auto D = Impl::kDimensions;
+    std::mt19937_64 prng(1 + D);
+
+    for(int i=0; i < 10000; i++) {
+        std::array<uint64_t, D> coord;
+        for (auto& x : coord)
+            x = prng();
+
+        ASSERT_EQ(Impl::deposit(coord), ReferenceDeposite64<D>(coord)) << coord;
+    }
+}
+
+TYPED_TEST(BitManipulation64Test, ExtractAll) {
+    using Impl = typename TestFixture::Implementation;
+    constexpr auto D = Impl::kDimensions;
+    std::mt19937_64 prng(1 + D);
+
+    for(int i=0; i < 10000; i++) {
+        const auto cell = prng();
+        ASSERT_EQ(Impl::extract(cell), ReferenceExtract64<D>(cell)) << cell;
+    }
+}
+
+TYPED_TEST(BitManipulation64Test, XRef) {
+    using Impl = typename TestFixture::Implementation;
+    constexpr auto D = Impl::kDimensions;
+    std::mt19937_64 prng(1 + D);
+
+    for(int i=0; i < 10000; i++) {
+        const auto cell = prng();
+        ASSERT_EQ(Impl::deposit(Impl::extract(cell)), cell) << cell;
+    }
+}
+
+
+TEST(BitManipulation, testRuntimeSelection) {
+    const auto calibrated = girgs::mortonImplementation();
+    EXPECT_TRUE(girgs::mortonImplementationAvailable(calibrated));
+    EXPECT_TRUE(girgs::mortonImplementationAvailable(girgs::MortonImplementation::Generic));
+    EXPECT_TRUE(girgs::mortonImplementationAvailable(girgs::MortonImplementation::LUT));
+    EXPECT_TRUE(girgs::mortonImplementationAvailable(girgs::calibrateMortonImplementation()));
+
+    // every available implementation computes the same cells
+    std::mt19937 prng(7);
+    std::vector<uint32_t> cells(1000);
+    for (auto& cell : cells)
+        cell = prng();
+
+    for (auto impl : {girgs::MortonImplementation::Generic, girgs::MortonImplementation::BMI2, girgs::MortonImplementation::LUT}) {
+        if (!girgs::mortonImplementationAvailable(impl)) {
+            EXPECT_THROW(girgs::setMortonImplementation(impl), std::invalid_argument);
+            continue;
+        }
+
+        girgs::setMortonImplementation(impl);
+        EXPECT_EQ(girgs::mortonImplementation(), impl);
+        EXPECT_EQ(girgs::BitManipulation<3>::name(), girgs::mortonImplementationName(impl));
+        for (auto cell : cells) {
+            ASSERT_EQ(girgs::BitManipulation<3>::extract(cell), ReferenceExtract<3>(cell)) << cell;
+            ASSERT_EQ(girgs::BitManipulation<3>::deposit(ReferenceExtract<3>(cell)), cell) << cell;
+        }
+    }
+
+    girgs::setMortonImplementation(calibrated);
+}
@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <girgs/BitManipulation.h>
+#include <girgs/CompressedGraph.h>
+
+
+class CompressedGraph_test: public testing::Test
+{
+protected:
+    const int seed = 1337;
+};
+
+
+TEST_F(CompressedGraph_test, testMortonLabelsArePermutation)
+{
+    const auto n = 10000;
+    for (auto d = 1u; d <= 5; ++d) {
+        auto positions = girgs::generatePositions(n, d, seed+d);
+        auto labels = girgs::mortonLabels(positions);
+        ASSERT_EQ(labels.size(), static_cast<std::size_t>(n));
+
+        std::sort(labels.begin(), labels.end());
+        for (auto i = 0; i < n; ++i)
+            EXPECT_EQ(labels[i], i) << "d=" << d;
+    }
+}
+
+
+TEST_F(CompressedGraph_test, testMortonLabelsFollowCells)
+{
+    // one point per cell of level 2 in 2D, inserted in reversed Morton order
+    std::vector<std::vector<double>> positions;
+    for (auto cell = 15; cell >= 0; --cell) {
+        auto coords = girgs::BitManipulation<2>::extract(cell);
+        positions.push_back({(coords[0] + 0.5) / 4, (coords[1] + 0.5) / 4});
+    }
+
+    auto labels = girgs::mortonLabels(positions);
+    for (auto i = 0; i < 16; ++i)
+        EXPECT_EQ(labels[i], 15 - i);
+}
+
+
+TEST_F(CompressedGraph_test, testRoundTrip)
+{
+    const auto n = 50000;
+    const auto file = std::string("CompressedGraph_test.adj");
+
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    auto positions = girgs::generatePositions(n, 2, seed+1);
+    girgs::scaleWeights(weights, 10, 2, 2.0);
+    auto edges = girgs::generateEdges(weights, positions, 2.0, seed+2);
+    auto labels = girgs::mortonLabels(positions);
+
+    auto header = girgs::CompressedGraphHeader();
+    header.parameters = {{2.0, 2.5, 2.0, 10.0}};
+    header.seeds = {{seed, seed+1, seed+2, 0}};
+    girgs::saveCompressed(header, n, edges, labels, file);
+
+    auto expected = std::vector<girgs::Edge>();
+    for (auto& edge : edges)
+        expected.emplace_back(std::min(labels[edge.first], labels[edge.second]), std::max(labels[edge.first], labels[edge.second]));
+    std::sort(expected.begin(), expected.end());
+
+    auto reader = girgs::CompressedGraphReader(file);
+    EXPECT_EQ(reader.header().n, static_cast<uint64_t>(n));
+    EXPECT_EQ(reader.header().m, edges.size());
+    EXPECT_EQ(reader.header().relabelled, 1u);
+    EXPECT_EQ(reader.header().parameters, header.parameters);
+    EXPECT_EQ(reader.header().seeds, header.seeds);
+
+    auto read = std::vector<girgs::Edge>();
+    auto neighbours = std::vector<girgs::NodeIndex>();
+    auto nodes = 0;
+    while (reader.next(neighbours)) {
+        EXPECT_EQ(reader.node(), nodes++);
+        for (auto v : neighbours)
+            read.emplace_back(reader.node(), v);
+    }
+    EXPECT_EQ(nodes, n);
+    EXPECT_FALSE(reader.next(neighbours));
+    EXPECT_EQ(read, expected);
+
+    std::remove(file.c_str());
+}
+
+
+TEST_F(CompressedGraph_test, testLargeGapsAndEmptyGraph)
+{
+    const auto file = std::string("CompressedGraph_test_gaps.adj");
+
+    // gaps which need one to four bytes
+    const auto n = (1 << 22) + 7;
+    auto edges = std::vector<girgs::Edge>{{0, 1}, {0, 200}, {0, 40000}, {5, 1 << 21}, {1 << 20, n-1}, {n-2, 3}};
+    girgs::saveCompressed(girgs::CompressedGraphHeader(), n, edges, {}, file);
+
+    auto reader = girgs::CompressedGraphReader(file);
+    EXPECT_EQ(reader.header().relabelled, 0u);
+    auto read = std::vector<girgs::Edge>();
+    auto neighbours = std::vector<girgs::NodeIndex>();
+    while (reader.next(neighbours))
+        for (auto v : neighbours)
+            read.emplace_back(reader.node(), v);
+
+    auto expected = std::vector<girgs::Edge>{{0, 1}, {0, 200}, {0, 40000}, {3, n-2}, {5, 1 << 21}, {1 << 20, n-1}};
+    EXPECT_EQ(read, expected);
+
+    girgs::saveCompressed(girgs::CompressedGraphHeader(), 0, {}, {}, file);
+    auto empty = girgs::CompressedGraphReader(file);
+    EXPECT_EQ(empty.header().n, 0u);
+    EXPECT_FALSE(empty.next(neighbours));
+
+    std::remove(file.c_str());
+}
+
+
+TEST_F(CompressedGraph_test, testRejectsInvalidGraphs)
+{
+    const auto file = std::string("CompressedGraph_test_invalid.adj");
+    const auto n = 5;
+
+    // self loops and duplicates, also in the other direction or after relabelling, have no gap encoding
+    const auto selfLoop = std::vector<girgs::Edge>{{0, 1}, {3, 3}};
+    const auto duplicate = std::vector<girgs::Edge>{{0, 1}, {2, 4}, {4, 2}};
+    const auto labels = std::vector<girgs::NodeIndex>{4, 3, 2, 1, 0};
+    EXPECT_THROW(girgs::saveCompressed(girgs::CompressedGraphHeader(), n, selfLoop, {}, file), std::invalid_argument);
+    EXPECT_THROW(girgs::saveCompressed(girgs::CompressedGraphHeader(), n, duplicate, {}, file), std::invalid_argument);
+    EXPECT_THROW(girgs::saveCompressed(girgs::CompressedGraphHeader(), n, duplicate, labels, file), std::invalid_argument);
+
+    // nothing is written
+    EXPECT_THROW(girgs::CompressedGraphReader{file}, std::runtime_error);
+}
+
+
+TEST_F(CompressedGraph_test, testRejectsOtherFiles)
+{
+    EXPECT_THROW(girgs::CompressedGraphReader("CompressedGraph_test_missing.adj"), std::runtime_error);
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <girgs/DynamicSpatialTree.h>
+#include <girgs/Generator.h>
+
+
+class DynamicSpatialTree_test: public testing::Test
+{
+protected:
+    using Edges = std::vector<girgs::Edge>;
+
+    const int seed = 1337;
+
+    static Edges normalized(Edges edges) {
+        for (auto& e : edges)
+            if (e.first > e.second)
+                std::swap(e.first, e.second);
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    }
+
+    template<unsigned int D>
+    static std::array<double, D> positionOf(const std::vector<std::vector<double>>& positions, girgs::NodeIndex i) {
+        std::array<double, D> result;
+        std::copy(positions[i].begin(), positions[i].end(), result.begin());
+        return result;
+    }
+
+    template<unsigned int D>
+    void testThreshold() {
+        const auto n = 2000;
+        const auto alpha = std::numeric_limits<double>::infinity();
+        auto weights = girgs::generateWeights(n, 2.5, seed);
+        girgs::scaleWeights(weights, 10, D, alpha);
+        const auto positions = girgs::generatePositions(n, D, seed+D);
+        const auto expected = normalized(girgs::generateEdges(weights, positions, alpha, seed));
+
+        const auto W = std::accumulate(weights.begin(), weights.end(), 0.0);
+        const auto w0 = *std::min_element(weights.begin(), weights.end());
+        auto tree = girgs::DynamicSpatialTree<D>(alpha, W, w0, seed);
+
+        // ids of the nodes of the static graph
+        auto ids = std::vector<girgs::NodeIndex>(n);
+        for (int i = 0; i < n; ++i)
+            ids[i] = tree.insert(positionOf<D>(positions, i), weights[i]);
+
+        const auto relabelled = [&] (const Edges& edges, const std::vector<bool>& present) {
+            auto result = Edges();
+            for (auto& e : edges)
+                if (present[e.first] && present[e.second])
+                    result.emplace_back(ids[e.first], ids[e.second]);
+            return normalized(result);
+        };
+
+        auto present = std::vector<bool>(n, true);
+        EXPECT_EQ(tree.numNodes(), static_cast<std::size_t>(n));
+        EXPECT_EQ(normalized(tree.edges()), relabelled(expected, present)) << "D=" << D;
+
+        // erase every third node: the remaining graph is the induced subgraph
+        for (int i = 0; i < n; i += 3) {
+            tree.erase(ids[i]);
+            present[i] = false;
+        }
+        EXPECT_EQ(normalized(tree.edges()), relabelled(expected, present)) << "D=" << D;
+
+        // insert them again with new ids
+        for (int i = 0; i < n; i += 3) {
+            ids[i] = tree.insert(positionOf<D>(positions, i), weights[i]);
+            present[i] = true;
+        }
+        EXPECT_EQ(tree.numEdges(), expected.size());
+        EXPECT_EQ(normalized(tree.edges()), relabelled(expected, present)) << "D=" << D;
+    }
+};
+
+
+#ifndef USE_COMPACT_NODES
+TEST_F(DynamicSpatialTree_test, testThresholdModelMatchesStatic)
+{
+    // without randomness the dynamic graph equals the static one
+    testThreshold<1>();
+    testThreshold<2>();
+    testThreshold<3>();
+}
+#endif // USE_COMPACT_NODES
+
+
+TEST_F(DynamicSpatialTree_test, testGeneralModelEdgeCount)
+{
+    const auto n = 5000;
+    const auto alpha = 2.0;
+    const auto repetitions = 5;
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    girgs::scaleWeights(weights, 10, 2, alpha);
+    const auto positions = girgs::generatePositions(n, 2, seed+1);
+    const auto W = std::accumulate(weights.begin(), weights.end(), 0.0);
+    const auto w0 = *std::min_element(weights.begin(), weights.end());
+
+    auto static_edges = 0.0;
+    auto dynamic_edges = 0.0;
+    for (int r = 0; r < repetitions; ++r) {
+        static_edges += girgs::generateEdges(weights, positions, alpha, seed + r).size();
+
+        auto tree = girgs::DynamicSpatialTree<2>(alpha, W, w0, seed + r);
+        for (int i = 0; i < n; ++i)
+            tree.insert(positionOf<2>(positions, i), weights[i]);
+        dynamic_edges += tree.numEdges();
+    }
+
+    EXPECT_NEAR(dynamic_edges / static_edges, 1.0, 0.03);
+}
+
+
+TEST_F(DynamicSpatialTree_test, testRandomUpdates)
+{
+    const auto alpha = 1.5;
+    auto rng = std::mt19937(seed);
+    auto uniform = std::uniform_real_distribution<double>(0.0, 1.0);
+
+    // the same updates with the same seed give the same graph
+    auto trees = std::vector<girgs::DynamicSpatialTree<3>>();
+    trees.emplace_back(alpha, 3000.0, 1.0, seed);
+    trees.emplace_back(alpha, 3000.0, 1.0, seed);
+
+    auto alive = std::vector<girgs::NodeIndex>();
+    for (int step = 0; step < 3000; ++step) {
+        if (alive.size() > 100 && uniform(rng) < 0.4) {
+            const auto k = static_cast<std::size_t>(uniform(rng) * alive.size());
+            for (auto& tree : trees)
+                tree.erase(alive[k]);
+            alive[k] = alive.back();
+            alive.pop_back();
+        } else {
+            const auto position = std::array<double, 3>{{uniform(rng), uniform(rng), uniform(rng)}};
+            const auto weight = std::pow(1.0 - uniform(rng), -1.0 / 1.5); // power law with exponent 2.5
+            const auto id = trees[0].insert(position, weight);
+            EXPECT_EQ(trees[1].insert(position, weight), id);
+            alive.push_back(id);
+        }
+    }
+
+    auto& tree = trees[0];
+    EXPECT_EQ(tree.numNodes(), alive.size());
+    EXPECT_EQ(tree.edges(), trees[1].edges());
+    EXPECT_GT(tree.numEdges(), 0u);
+
+    // the adjacency lists are symmetric and only contain nodes in the graph
+    auto degree_sum = std::size_t{0};
+    for (girgs::NodeIndex u = 0; u < tree.idBound(); ++u) {
+        if (!tree.contains(u)) {
+            EXPECT_EQ(tree.degree(u), 0u);
+            continue;
+        }
+        degree_sum += tree.degree(u);
+        tree.forEachNeighbour(u, [&] (girgs::NodeIndex v) {
+            EXPECT_TRUE(tree.contains(v));
+            auto found = false;
+            tree.forEachNeighbour(v, [&] (girgs::NodeIndex w) { found |= w == u; });
+            EXPECT_TRUE(found);
+        });
+    }
+    EXPECT_EQ(degree_sum, 2 * tree.numEdges());
+    EXPECT_EQ(tree.edges().size(), tree.numEdges());
+}
+
+
+TEST_F(DynamicSpatialTree_test, testInvalidWeight)
+{
+    auto tree = girgs::DynamicSpatialTree<2>(2.0, 100.0, 1.0, seed);
+    EXPECT_THROW(tree.insert({{0.5, 0.5}}, 0.5), std::invalid_argument);
+}
+
+
+TEST_F(DynamicSpatialTree_test, testInvalidErase)
+{
+    auto tree = girgs::DynamicSpatialTree<2>(2.0, 100.0, 1.0, seed);
+    const auto u = tree.insert({{0.2, 0.2}}, 1.0);
+    const auto v = tree.insert({{0.21, 0.2}}, 5.0);
+
+    EXPECT_THROW(tree.erase(-1), std::invalid_argument);
+    EXPECT_THROW(tree.erase(tree.idBound()), std::invalid_argument);
+
+    // a second erase of the same id leaves the graph untouched
+    tree.erase(u);
+    EXPECT_THROW(tree.erase(u), std::invalid_argument);
+    EXPECT_EQ(tree.numNodes(), 1u);
+    EXPECT_EQ(tree.numEdges(), 0u);
+    EXPECT_TRUE(tree.contains(v));
+    EXPECT_EQ(tree.degree(v), 0u);
+}
@@ -0,0 +1,43 @@
+#include <vector>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <omp.h>
+
+#include <girgs/EdgeCollector.h>
+
+
+TEST(EdgeCollector_test, testConcatenatesThreadsInOrder)
+{
+    const auto threads = 4;
+    const auto perThread = 1000;
+
+    // small blocks to force several blocks per thread
+    auto collector = girgs::EdgeCollector(7, threads);
+
+    #pragma omp parallel for schedule(static, 1), num_threads(threads)
+    for (int tid = 0; tid < threads; ++tid)
+        for (int i = 0; i < perThread * (tid + 1); ++i)
+            collector(tid, i, tid);
+
+    EXPECT_EQ(collector.size(), static_cast<std::size_t>(perThread * 10));
+
+    auto edges = collector.collect();
+    ASSERT_EQ(edges.size(), static_cast<std::size_t>(perThread * 10));
+    EXPECT_EQ(collector.size(), 0u);
+
+    auto pos = 0u;
+    for (int tid = 0; tid < threads; ++tid) {
+        for (int i = 0; i < perThread * (tid + 1); ++i, ++pos) {
+            EXPECT_EQ(edges[pos].first, tid);
+            EXPECT_EQ(edges[pos].second, i);
+        }
+    }
+}
+
+TEST(EdgeCollector_test, testEmpty)
+{
+    auto collector = girgs::EdgeCollector();
+    EXPECT_TRUE(collector.collect().empty());
+}
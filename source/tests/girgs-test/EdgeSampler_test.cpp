@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <omp.h>
+
+#include <girgs/EdgeSampler.h>
+#include <girgs/Generator.h>
+
+
+class EdgeSampler_test: public testing::Test
+{
+protected:
+    const int seed = 1337;
+    const int n = 2000;
+
+    static std::vector<girgs::Edge> sorted(std::vector<girgs::Edge> edges) {
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    }
+};
+
+
+TEST_F(EdgeSampler_test, testMatchesGenerateEdges)
+{
+    const auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    const auto weights = girgs::generateWeights(n, 2.5, seed);
+
+    for (auto d = 1u; d < 4; ++d) {
+        const auto positions = girgs::generatePositions(n, d, seed+d);
+        for (auto alpha : alphas) {
+            auto scaled = weights;
+            girgs::scaleWeights(scaled, 10, d, alpha);
+
+            const auto sampler = girgs::EdgeSampler(scaled, positions, alpha);
+            EXPECT_EQ(sampler.numNodes(), n);
+
+            // the preprocessed structure is reused for all seeds
+            for (auto samplingSeed = seed; samplingSeed < seed + 3; ++samplingSeed) {
+                const auto expected = sorted(girgs::generateEdges(scaled, positions, alpha, samplingSeed));
+                EXPECT_EQ(sorted(sampler.generateEdges(samplingSeed)), expected) << "d=" << d << " alpha=" << alpha;
+
+                const auto csr = sampler.generateCSR(samplingSeed);
+                EXPECT_EQ(csr.numEdges(), expected.size());
+            }
+        }
+    }
+}
+
+
+TEST_F(EdgeSampler_test, testFlatPositionsAndShards)
+{
+    const auto d = 2u;
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    girgs::scaleWeights(weights, 10, d, 2.0);
+    auto positions = girgs::FlatPositions(n, d);
+    girgs::generatePositions(positions, seed+1);
+
+    const auto sampler = girgs::EdgeSampler(weights, positions, 2.0);
+    const auto expected = sorted(girgs::generateEdges(weights, positions, 2.0, seed));
+
+    const auto num_shards = 3u;
+    auto edges = std::vector<girgs::Edge>();
+    auto mutex = std::mutex();
+    for (auto shard = 0u; shard < num_shards; ++shard) {
+        sampler.generateEdges(seed, [&] (const girgs::Edge* block, std::size_t count, int) {
+            std::lock_guard<std::mutex> lock(mutex);
+            edges.insert(edges.end(), block, block + count);
+        }, 100, shard, num_shards);
+    }
+    EXPECT_EQ(sorted(edges), expected);
+}
+
+
+TEST_F(EdgeSampler_test, testEnsemble)
+{
+    const auto d = 2u;
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    girgs::scaleWeights(weights, 10, d, 2.0);
+    const auto positions = girgs::generatePositions(n, d, seed+1);
+    const auto sampler = girgs::EdgeSampler(weights, positions, 2.0);
+
+    const auto seeds = std::vector<int>{3, 1, 4, 1, 5, 9, 2, 6};
+    auto expected = std::vector<std::vector<girgs::Edge>>();
+    for (auto s : seeds)
+        expected.push_back(sorted(sampler.generateEdges(s)));
+
+    const auto max_threads = omp_get_max_threads();
+    for (auto threads : {1, 3}) {
+        omp_set_num_threads(threads);
+        auto graphs = sampler.generateEnsemble(seeds);
+        ASSERT_EQ(graphs.size(), seeds.size());
+        for (std::size_t s = 0; s < seeds.size(); ++s)
+            EXPECT_EQ(sorted(graphs[s]), expected[s]) << "sample=" << s << " threads=" << threads;
+    }
+    omp_set_num_threads(max_threads);
+
+    // the threads of the ensemble do not change the number of threads of the caller
+    EXPECT_EQ(omp_get_max_threads(), max_threads);
+}
+
+
+TEST_F(EdgeSampler_test, testUnsupportedDimension)
+{
+    const auto weights = girgs::generateWeights(10, 2.5, seed);
+    const auto positions = girgs::generatePositions(10, 11, seed);
+    EXPECT_THROW(girgs::EdgeSampler(weights, positions, 2.0), std::invalid_argument);
+}
@@ -5,7 +5,11 @@
 
 #include <gmock/gmock.h>
 
+#include <omp.h>
+
 #include <girgs/Generator.h>
+#include <girgs/EdgeCollector.h>
+#include <girgs/SpatialTree.h>
 
 using namespace std;
 
@@ -19,7 +23,7 @@ protected:
 };
 
 
-bool connected(int a, int b, const vector<pair<int, int>> graph) {
+bool connected(girgs::NodeIndex a, girgs::NodeIndex b, const vector<girgs::Edge> graph) {
     bool a2b = find(graph.begin(), graph.end(), make_pair(a, b)) != graph.end();
     bool b2a = find(graph.begin(), graph.end(), make_pair(b, a)) != graph.end();
     return a2b || b2a;
@@ -188,27 +192,32 @@ TEST_F(Generator_test, testEstimation)
     auto all_alpha = {0.7, 3.0, numeric_limits<double>::infinity()};
     auto all_desired_avg = {10, 20, 50, 100};
     auto all_dimensions = {1, 2, 3};
-    auto runs = 5;
 
     auto ple = 2.5;
     auto weightSeed = seed;
     auto positionSeed = seed;
 
     for(int n : all_n){
+        // The edge count of a graph with m expected edges deviates by about sqrt(m), i.e. 4.5% for n=100
+        // and an average degree of 10, and one weight sample adds a few percent more. Averaging over
+        // runs with their own weights and at least 2000 nodes in total keeps the error of the observed
+        // average degree around 1%, well below the tolerance of 5%.
+        auto runs = std::max(5, 2000 / n);
+
         for(double alpha : all_alpha){
             for(double desired_avg : all_desired_avg){
                 if (desired_avg * 3 > n) continue;
                 for(int d : all_dimensions){
 
-                    // generate weights
-                    auto weights = girgs::generateWeights(n, ple, weightSeed);
-
-                    // estimate scaling for current dimension
-                    girgs::scaleWeights(weights, desired_avg, d, alpha);
-
                     auto observed_avg = 0.0;
                     for(int i = 0; i<runs; ++i) {
 
+                        // generate weights
+                        auto weights = girgs::generateWeights(n, ple, weightSeed+i);
+
+                        // estimate scaling for current dimension
+                        girgs::scaleWeights(weights, desired_avg, d, alpha);
+
                         // try GIRGS generator
                         auto positions = girgs::generatePositions(n, d, positionSeed+i);
                         auto edges = girgs::generateEdges(weights, positions, alpha, n+i);
@@ -268,8 +277,270 @@ TEST_F(Generator_test, testReproducible)
                     girgs::generatePositions(n, d, position_seed),
                     alpha, weight_seed+position_seed);
 
-            // same edges
+            // same edges (the order may depend on thread scheduling)
+            sort(edges1.begin(), edges1.end());
+            sort(edges2.begin(), edges2.end());
             EXPECT_EQ(edges1, edges2);
         }
     }
 }
+
+
+TEST_F(Generator_test, testReproducibleAcrossThreadCounts)
+{
+    const auto n = 1000;
+    const auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    const auto degrees = { 10.0, 200.0 }; // dense graphs have large type 1 jobs which are split into row chunks
+    const auto max_threads = omp_get_max_threads();
+
+    auto weights = girgs::generateWeights(n, 2.2, seed);
+
+    for (auto d = 1u; d < 3; ++d) {
+        auto positions = girgs::generatePositions(n, d, seed+d);
+        for (auto alpha : alphas) {
+            for (auto deg : degrees) {
+                auto scaled = weights;
+                girgs::scaleWeights(scaled, deg, d, alpha);
+
+                omp_set_num_threads(1);
+                auto expected = girgs::generateEdges(scaled, positions, alpha, seed);
+                sort(expected.begin(), expected.end());
+
+                for (auto threads : {2, 7}) {
+                    omp_set_num_threads(threads);
+                    auto edges = girgs::generateEdges(scaled, positions, alpha, seed);
+                    sort(edges.begin(), edges.end());
+                    EXPECT_EQ(edges, expected) << "threads=" << threads << " d=" << d << " alpha=" << alpha << " deg=" << deg;
+                }
+            }
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+
+#ifndef USE_LEGACY_VARIATES
+TEST_F(Generator_test, testVariatesAcrossThreadCounts)
+{
+    const auto n = 50000;
+    const auto max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    const auto weights = girgs::generateWeights(n, 2.5, seed);
+    const auto positions = girgs::generatePositions(n, 3, seed);
+
+    for (auto threads : {2, 7}) {
+        omp_set_num_threads(threads);
+        EXPECT_EQ(girgs::generateWeights(n, 2.5, seed), weights) << "threads=" << threads;
+        EXPECT_EQ(girgs::generatePositions(n, 3, seed), positions) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+}
+#endif
+
+
+TEST_F(Generator_test, testFlatPositions)
+{
+    const auto n = 1000;
+    const auto ple = 2.5;
+    const auto layouts = { girgs::FlatPositions::Layout::RowMajor, girgs::FlatPositions::Layout::ColumnMajor };
+
+    auto weights = girgs::generateWeights(n, ple, seed);
+
+    for (auto d = 1u; d < 5; ++d) {
+        auto nested = girgs::generatePositions(n, d, seed+d);
+        auto scaled = weights;
+        girgs::scaleWeights(scaled, 10, d, 2.0);
+        auto expected = girgs::generateEdges(scaled, nested, 2.0, seed);
+        sort(expected.begin(), expected.end());
+
+        for (auto layout : layouts) {
+            auto flat = girgs::FlatPositions(n, d, layout);
+            girgs::generatePositions(flat, seed+d);
+
+            // same coordinates as the nested variant
+            EXPECT_EQ(flat.toNested(), nested);
+
+            // same weight scaling and same edges
+            auto scaled_flat = weights;
+            girgs::scaleWeights(scaled_flat, 10, flat, 2.0);
+            EXPECT_EQ(scaled_flat, scaled);
+
+            auto edges = girgs::generateEdges(scaled_flat, flat, 2.0, seed);
+            sort(edges.begin(), edges.end());
+            EXPECT_EQ(edges, expected);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testEdgeBlockCallback)
+{
+    const auto n = 2000;
+    const auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    const auto blockSizes = { std::size_t{1}, std::size_t{7}, std::size_t{1} << 16 };
+
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    auto positions = girgs::generatePositions(n, 2, seed+1);
+
+    for (auto alpha : alphas) {
+        auto scaled = weights;
+        girgs::scaleWeights(scaled, 10, 2, alpha);
+        auto expected = girgs::generateEdges(scaled, positions, alpha, seed);
+        sort(expected.begin(), expected.end());
+
+        for (auto blockSize : blockSizes) {
+            std::vector<std::vector<girgs::Edge>> perThread(omp_get_max_threads());
+            girgs::generateEdges(scaled, positions, alpha, seed,
+                [&] (const girgs::Edge* edges, std::size_t count, int tid) {
+                    EXPECT_GT(count, 0u);
+                    EXPECT_LE(count, blockSize);
+                    perThread[tid].insert(perThread[tid].end(), edges, edges + count);
+                }, blockSize);
+
+            std::vector<girgs::Edge> edges;
+            for (auto& local : perThread)
+                edges.insert(edges.end(), local.begin(), local.end());
+            sort(edges.begin(), edges.end());
+            EXPECT_EQ(edges, expected);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testShards)
+{
+    const auto n = 2000;
+    const auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    const auto shardCounts = { 2u, 5u, 64u }; // more shards than cells on the deepest level leaves some shards empty
+
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+
+    for (auto d = 1u; d < 3; ++d) {
+        auto positions = girgs::generatePositions(n, d, seed+d);
+        for (auto alpha : alphas) {
+            auto scaled = weights;
+            girgs::scaleWeights(scaled, 10, d, alpha);
+            auto expected = girgs::generateEdges(scaled, positions, alpha, seed);
+            sort(expected.begin(), expected.end());
+
+            for (auto numShards : shardCounts) {
+                // the union of all shards is the graph and no edge is sampled twice
+                std::vector<girgs::Edge> edges;
+                for (auto shard = 0u; shard < numShards; ++shard) {
+                    girgs::generateEdges(scaled, positions, alpha, seed,
+                        [&] (const girgs::Edge* block, std::size_t count, int) {
+                            #pragma omp critical
+                            edges.insert(edges.end(), block, block + count);
+                        }, std::size_t{1} << 16, shard, numShards);
+                }
+                sort(edges.begin(), edges.end());
+                EXPECT_EQ(edges, expected) << "d=" << d << " alpha=" << alpha << " shards=" << numShards;
+            }
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testCSR)
+{
+    const auto n = 2000;
+    const auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+
+    for (auto d = 1u; d < 4; ++d) {
+        auto positions = girgs::generatePositions(n, d, seed+d);
+        for (auto alpha : alphas) {
+            auto scaled = weights;
+            girgs::scaleWeights(scaled, 10, d, alpha);
+
+            auto edges = girgs::generateEdges(scaled, positions, alpha, seed);
+            auto csr = girgs::generateCSR(scaled, positions, alpha, seed);
+
+            ASSERT_EQ(csr.numNodes(), static_cast<std::size_t>(n));
+            ASSERT_EQ(csr.numEdges(), edges.size());
+
+            // build the expected adjacency lists from the edge list
+            std::vector<std::vector<int>> expected(n);
+            for (auto& e : edges) {
+                expected[e.first].push_back(e.second);
+                expected[e.second].push_back(e.first);
+            }
+
+            for (int v = 0; v < n; ++v) {
+                sort(expected[v].begin(), expected[v].end());
+                auto actual = std::vector<int>(csr.neighboursBegin(v), csr.neighboursEnd(v));
+                EXPECT_EQ(actual, expected[v]);
+            }
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testHighDimensions)
+{
+    const auto n = 300;
+    const auto alpha = numeric_limits<double>::infinity();
+
+    for (auto d = 6u; d <= 10; ++d) {
+        auto weights = girgs::generateWeights(n, 2.5, seed);
+        girgs::scaleWeights(weights, 10, d, alpha);
+        const auto W = accumulate(weights.begin(), weights.end(), 0.0);
+        const auto positions = girgs::generatePositions(n, d, seed+d);
+
+        auto edges = girgs::generateEdges(weights, positions, alpha, seed);
+        for (auto& e : edges)
+            if (e.first > e.second)
+                swap(e.first, e.second);
+        sort(edges.begin(), edges.end());
+
+        // the threshold model connects exactly the pairs with dist^d < w_i w_j / W
+        auto expected = vector<girgs::Edge>();
+        for (int i = 0; i < n; ++i)
+            for (int j = i+1; j < n; ++j)
+                if (pow(distance(positions[i], positions[j]), d) < weights[i] * weights[j] / W)
+                    expected.emplace_back(i, j);
+
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(edges, expected) << "d = " << d;
+    }
+}
+
+
+// samples the same graph with 64 bit cell ids as generateEdges() with 32 bit cell ids
+template<unsigned int D>
+static void testWideCellIds(const vector<double>& weights, double alpha, int seed) {
+    auto positions = girgs::FlatPositions(weights.size(), D);
+    girgs::generatePositions(positions, seed+D);
+    ASSERT_LE(girgs::cellIdBits<D>(weights), 32u); // generateEdges() uses 32 bit cell ids
+
+    auto collector = girgs::EdgeCollector();
+    girgs::SpatialTree<D, girgs::EdgeCollector, uint64_t>(weights, positions, alpha, collector).generateEdges(seed);
+    auto wide = collector.collect();
+    auto narrow = girgs::generateEdges(weights, positions, alpha, seed);
+
+    sort(wide.begin(), wide.end());
+    sort(narrow.begin(), narrow.end());
+    EXPECT_EQ(wide, narrow) << "d = " << D;
+}
+
+TEST_F(Generator_test, testWideCellIds)
+{
+    const auto n = 2000;
+
+    for (auto alpha : {1.5, numeric_limits<double>::infinity()}) {
+        auto weights = girgs::generateWeights(n, 2.5, seed);
+        girgs::scaleWeights(weights, 10, 2, alpha);
+        testWideCellIds<1>(weights, alpha, seed);
+        testWideCellIds<2>(weights, alpha, seed);
+        testWideCellIds<3>(weights, alpha, seed);
+    }
+
+    // about 2^40 cells on the deepest level do not fit into 32 bit cell ids
+    EXPECT_GT(girgs::cellIdBits<1>(1.0, 1.0, std::ldexp(1.0, 40)), 32u);
+    EXPECT_GT(girgs::cellIdBits<4>(1.0, 16.0, std::ldexp(1.0, 40)), 32u);
+    EXPECT_LE(girgs::cellIdBits<4>(1.0, 16.0, std::ldexp(1.0, 20)), 32u);
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <girgs/IntSort.h>
+
+
+namespace {
+
+struct Element {
+    uint64_t key;
+    uint32_t index;
+};
+
+bool operator==(const Element& a, const Element& b) {
+    return a.key == b.key && a.index == b.index;
+}
+
+// keys at most max_key; every second distribution puts most elements into a single bucket
+std::vector<Element> randomElements(std::size_t n, uint64_t max_key, bool skewed, unsigned seed) {
+    auto gen = std::mt19937_64(seed);
+    auto result = std::vector<Element>(n);
+    for (auto i = 0u; i < n; ++i) {
+        auto key = max_key == UINT64_MAX ? gen() : gen() % (max_key + 1);
+        if (skewed && gen() % 4)
+            key = max_key / 2;
+        result[i] = Element{key, i};
+    }
+    return result;
+}
+
+auto key = [](const Element& e) { return e.key; };
+auto inputOrder = [](const Element& a, const Element& b) { return a.index < b.index; };
+
+} // namespace
+
+
+TEST(IntSort_test, testInPlaceMatchesStableSort)
+{
+    const auto max_threads = omp_get_max_threads();
+
+    // large inputs are distributed by several threads, even on a single core
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        for (std::size_t n : {0, 1, 2, 64, 65, 1000, 300000}) {
+            for (uint64_t max_key : {uint64_t{0}, uint64_t{1}, uint64_t{255}, uint64_t{256}, uint64_t{1} << 33, UINT64_MAX}) {
+                for (auto skewed : {false, true}) {
+                    auto elements = randomElements(n, max_key, skewed, static_cast<unsigned>(n + max_key % 1000));
+                    auto expected = elements;
+                    std::stable_sort(expected.begin(), expected.end(), [](const Element& a, const Element& b) { return a.key < b.key; });
+
+                    intsort::intsort_inplace(elements.begin(), elements.end(), key, max_key, inputOrder);
+                    ASSERT_EQ(elements, expected) << "n=" << n << " max_key=" << max_key << " threads=" << threads;
+                }
+            }
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+TEST(IntSort_test, testStableIndependentOfMethod)
+{
+    // intsort_stable uses either sort; both have to produce the order of the buffered radix sort
+    for (uint64_t max_key : {uint64_t{100}, uint64_t{1} << 20}) {
+        auto elements = randomElements(300000, max_key, false, 7);
+        auto buffered = elements;
+        intsort::intsort(buffered, key, max_key + 1);
+
+        auto inplace = elements;
+        intsort::intsort_inplace(inplace.begin(), inplace.end(), key, max_key, inputOrder);
+        EXPECT_EQ(inplace, buffered);
+
+        intsort::intsort_stable(elements, key, max_key + 1, inputOrder);
+        EXPECT_EQ(elements, buffered);
+    }
+}
+
+TEST(IntSort_test, testSkewedBuckets)
+{
+    const auto max_threads = omp_get_max_threads();
+
+    // most keys share their highest bits, so a few buckets of the first round are sorted by several threads
+    const auto max_key = (uint64_t{1} << 33) - 1;
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        for (auto heavy_buckets : {1, 3}) {
+            auto gen = std::mt19937_64(heavy_buckets);
+            auto elements = std::vector<Element>(600000);
+            for (auto i = 0u; i < elements.size(); ++i) {
+                auto key = gen() % (max_key + 1);
+                if (gen() % 8)
+                    key = ((gen() % heavy_buckets) << 25) | (key & ((uint64_t{1} << 25) - 1));
+                elements[i] = Element{key, i};
+            }
+
+            auto expected = elements;
+            std::stable_sort(expected.begin(), expected.end(), [](const Element& a, const Element& b) { return a.key < b.key; });
+
+            auto buffered = elements;
+            intsort::intsort(buffered, key, max_key);
+            EXPECT_EQ(buffered, expected) << "threads=" << threads;
+
+            intsort::intsort_inplace(elements.begin(), elements.end(), key, max_key, inputOrder);
+            EXPECT_EQ(elements, expected) << "threads=" << threads;
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+TEST(IntSort_test, testInPlaceWithoutTieBreak)
+{
+    auto elements = randomElements(100000, 1000, true, 3);
+    intsort::intsort_inplace(elements.begin(), elements.end(), key, uint64_t{1000});
+    EXPECT_TRUE(std::is_sorted(elements.begin(), elements.end(), [](const Element& a, const Element& b) { return a.key < b.key; }));
+}
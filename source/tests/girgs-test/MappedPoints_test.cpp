@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cstddef>
+#include <fstream>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <girgs/Generator.h>
+#include <girgs/MappedPoints.h>
+
+
+// the edges with u < v in ascending order
+static std::vector<girgs::Edge> normalized(std::vector<girgs::Edge> edges) {
+    for (auto& edge : edges)
+        if (edge.first > edge.second)
+            std::swap(edge.first, edge.second);
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+
+TEST(MappedPoints_test, testRoundTrip)
+{
+    const auto file = std::string("MappedPoints_test.pts");
+    const auto n = 1000;
+
+    for (auto layout : {girgs::FlatPositions::Layout::RowMajor, girgs::FlatPositions::Layout::ColumnMajor}) {
+        const auto weights = girgs::generateWeights(n, 2.5, 12);
+        auto positions = girgs::FlatPositions(n, 3, layout);
+        girgs::generatePositions(positions, 13);
+        girgs::savePoints(weights, positions, file);
+
+        const auto points = girgs::MappedPoints(file);
+        EXPECT_EQ(std::string(points.header().magic.data()), "GIRGPTS");
+        ASSERT_EQ(points.size(), static_cast<std::size_t>(n));
+        ASSERT_EQ(points.dimension(), 3u);
+        EXPECT_EQ(points.positions().layout(), layout);
+
+        const auto mappedWeights = points.weights();
+        const auto mappedPositions = points.positions();
+        for (auto i = 0; i < n; ++i) {
+            EXPECT_EQ(mappedWeights[i], weights[i]);
+            for (auto d = 0u; d < 3; ++d)
+                EXPECT_EQ(mappedPositions(i, d), positions(i, d));
+        }
+    }
+
+    std::remove(file.c_str());
+}
+
+
+TEST(MappedPoints_test, testSameEdgesAsVectors)
+{
+    const auto file = std::string("MappedPoints_test.pts");
+    const auto n = 5000;
+
+    for (auto alpha : {2.0, std::numeric_limits<double>::infinity()}) {
+        auto weights = girgs::generateWeights(n, 2.5, 21);
+        auto positions = girgs::FlatPositions(n, 2);
+        girgs::generatePositions(positions, 22);
+        girgs::scaleWeights(weights, 10.0, 2, alpha);
+        girgs::savePoints(weights, positions, file);
+
+        const auto points = girgs::MappedPoints(file);
+        const auto expected = normalized(girgs::generateEdges(weights, positions, alpha, 23));
+        EXPECT_EQ(normalized(girgs::generateEdges(points.weights(), points.positions(), alpha, 23)), expected);
+
+        // streamed and CSR output take the views as well
+        std::vector<girgs::Edge> streamed;
+        girgs::generateEdges(points.weights(), points.positions(), alpha, 23, [&] (const girgs::Edge* edges, std::size_t count, int) {
+            #pragma omp critical
+            streamed.insert(streamed.end(), edges, edges + count);
+        });
+        EXPECT_EQ(normalized(streamed), expected);
+        EXPECT_EQ(girgs::generateCSR(points.weights(), points.positions(), alpha, 23).numEdges(), expected.size());
+    }
+
+    std::remove(file.c_str());
+}
+
+
+TEST(MappedPoints_test, testInvalidFiles)
+{
+    const auto file = std::string("MappedPoints_test.pts");
+    EXPECT_THROW(girgs::MappedPoints("MappedPoints_test.missing"), std::runtime_error);
+
+    {   // no header
+        std::ofstream f{file, std::ios::binary};
+        f << "GIRGPTS";
+    }
+    EXPECT_THROW(girgs::MappedPoints{file}, std::runtime_error);
+
+    {   // truncated data
+        const auto weights = std::vector<double>{1.0, 2.0};
+        auto positions = girgs::FlatPositions(2, 1);
+        girgs::savePoints(weights, positions, file);
+        std::ofstream f{file, std::ios::binary | std::ios::in | std::ios::out};
+        f.seekp(offsetof(girgs::BinaryPointsHeader, n));
+        const auto n = uint64_t{3};
+        f.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+    EXPECT_THROW(girgs::MappedPoints{file}, std::runtime_error);
+
+    // unsupported dimensions, also one whose n * (1 + dimension) overflows to the size of the data
+    for (auto dimension : {0u, 11u, std::numeric_limits<uint32_t>::max()}) {
+        auto header = girgs::BinaryPointsHeader();
+        header.dimension = dimension;
+        header.n = dimension == 11u ? 1 : 0;
+        const auto values = std::vector<double>(header.n * 12, 0.5);
+        std::ofstream f{file, std::ios::binary};
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)));
+        f.close();
+        EXPECT_THROW(girgs::MappedPoints{file}, std::runtime_error) << "dimension=" << dimension;
+    }
+
+    std::remove(file.c_str());
+}
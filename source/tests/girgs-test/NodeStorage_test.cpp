@@ -0,0 +1,76 @@
+#include <array>
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <girgs/Node.h>
+#include <girgs/NodeColumns.h>
+#include <girgs/SpatialTreeCoordinateHelper.h>
+
+
+TEST(NodeStorage_test, testCompactDistance)
+{
+    using Compact = girgs::CompactNodeStorage;
+    using Exact = girgs::ExactNodeStorage;
+
+    auto gen = std::mt19937_64(1);
+    auto dist = std::uniform_real_distribution<>();
+
+    for (auto i = 0; i < 10000; ++i) {
+        const auto x = dist(gen);
+        const auto y = dist(gen);
+        const auto cx = Compact::coordinate(x);
+        const auto cy = Compact::coordinate(y);
+
+        // the quantised coordinate is at most 2^-32 below the original one
+        EXPECT_LE(Compact::position(cx), x);
+        EXPECT_LT(x - Compact::position(cx), 0x1.0p-32);
+
+        // the distance is exact for the quantised coordinates
+        EXPECT_EQ(Compact::torusDistance(cx, cy), Exact::torusDistance(Compact::position(cx), Compact::position(cy)));
+        EXPECT_NEAR(Compact::torusDistance(cx, cy), Exact::torusDistance(x, y), 0x1.0p-31);
+        EXPECT_LE(Compact::torusDistance(cx, cy), 0.5);
+    }
+
+    // wrap around
+    EXPECT_EQ(Compact::torusDistance(Compact::coordinate(0.0), Compact::coordinate(1.0 - 0x1.0p-32)), 0x1.0p-32);
+    EXPECT_EQ(Compact::torusDistance(Compact::coordinate(0.0), Compact::coordinate(0.5)), 0.5);
+}
+
+
+TEST(NodeStorage_test, testCompactKeepsCells)
+{
+    using Helper = girgs::SpatialTreeCoordinateHelper<2>;
+
+    auto gen = std::mt19937_64(2);
+    auto dist = std::uniform_real_distribution<>();
+
+    for (auto i = 0; i < 1000; ++i) {
+        const auto position = std::array<double, 2>{{dist(gen), dist(gen)}};
+        const auto node = girgs::Node<2, girgs::CompactNodeStorage>(position, 1.0, i);
+        for (auto level = 0u; level < 16; ++level)
+            EXPECT_EQ(Helper::cellForPoint(node.position(), level), Helper::cellForPoint(position, level));
+    }
+}
+
+
+TEST(NodeStorage_test, testColumns)
+{
+    auto gen = std::mt19937_64(3);
+    auto dist = std::uniform_real_distribution<>();
+
+    std::vector<girgs::Node<3, girgs::NodeStorage>> nodes;
+    for (auto i = 0; i < 100; ++i)
+        nodes.emplace_back(std::array<double, 3>{{dist(gen), dist(gen), dist(gen)}}, 1.0 + dist(gen), 100 - i);
+
+    const auto columns = girgs::NodeColumns<3>(nodes);
+    ASSERT_EQ(columns.size(), nodes.size());
+    for (auto k = 0u; k < nodes.size(); ++k) {
+        EXPECT_EQ(columns.indices[k], nodes[k].index);
+        EXPECT_EQ(columns.weights[k], nodes[k].weight);
+        EXPECT_EQ(columns.position(k), nodes[k].position());
+        for (auto l = 0u; l < nodes.size(); ++l)
+            EXPECT_EQ(columns.distance(k, l), nodes[k].distance(nodes[l]));
+    }
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include <girgs/Philox.h>
+
+
+TEST(Philox_test, testKnownAnswers)
+{
+    // known answer tests of the Random123 reference implementation
+    using Counter = girgs::Philox4x32::Counter;
+    using Key = girgs::Philox4x32::Key;
+
+    EXPECT_EQ(girgs::Philox4x32::block(Counter{{0, 0, 0, 0}}, Key{{0, 0}}),
+              (Counter{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+    EXPECT_EQ(girgs::Philox4x32::block(Counter{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}}, Key{{0xffffffff, 0xffffffff}}),
+              (Counter{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+    EXPECT_EQ(girgs::Philox4x32::block(Counter{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}}, Key{{0xa4093822, 0x299f31d0}}),
+              (Counter{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+}
+
+
+TEST(Philox_test, testSeek)
+{
+    auto stream = girgs::PhiloxStream(42, 1, 2);
+    std::vector<uint64_t> sequence(100);
+    for (auto& x : sequence)
+        x = stream();
+
+    for (auto pos = 0u; pos < sequence.size(); pos += 7) {
+        auto seeked = girgs::PhiloxStream(42, 1, 2, pos);
+        EXPECT_EQ(seeked(), sequence[pos]);
+
+        auto reseeked = girgs::PhiloxStream(42, 1, 2);
+        reseeked.seek(pos);
+        EXPECT_EQ(reseeked(), sequence[pos]);
+    }
+}
+
+
+TEST(Philox_test, testStreamsDiffer)
+{
+    std::set<uint64_t> firsts;
+    for (uint64_t key = 0; key < 4; ++key)
+        for (uint32_t a = 0; a < 4; ++a)
+            for (uint32_t b = 0; b < 4; ++b)
+                firsts.insert(girgs::PhiloxStream(key, a, b)());
+    EXPECT_EQ(firsts.size(), 64u);
+}
+
+
+TEST(Philox_test, testUniform)
+{
+    auto stream = girgs::PhiloxStream(7, 0, 0);
+    const auto samples = 100000;
+    double sum = 0;
+    for (int i = 0; i < samples; ++i) {
+        auto x = stream.uniform();
+        ASSERT_GE(x, 0.0);
+        ASSERT_LT(x, 1.0);
+        sum += x;
+    }
+    EXPECT_NEAR(sum / samples, 0.5, 0.01);
+}
+
+
+TEST(Philox_test, testFillUniform)
+{
+    std::vector<double> expected(1000);
+    auto stream = girgs::PhiloxStream(42, 3, 4);
+    for (auto& x : expected)
+        x = stream.uniform();
+
+    // odd and even offsets and sizes, within and across batches
+    for (auto first : {0u, 1u, 2u, 17u, 128u, 129u}) {
+        for (auto count : {0u, 1u, 2u, 3u, 127u, 128u, 129u, 300u, 777u}) {
+            std::vector<double> filled(count);
+            girgs::PhiloxStream::fillUniform(filled.data(), count, 42, 3, 4, first);
+            EXPECT_TRUE(std::equal(filled.begin(), filled.end(), expected.begin() + first)) << "first=" << first << " count=" << count;
+        }
+    }
+}
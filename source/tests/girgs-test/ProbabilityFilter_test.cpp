@@ -0,0 +1,39 @@
+#include <cmath>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <girgs/ProbabilityFilter.h>
+
+
+TEST(ProbabilityFilter_test, testAgreesWithExactTest)
+{
+    auto gen = std::mt19937_64(42);
+    auto dist = std::uniform_real_distribution<>();
+
+    for (auto alpha : {1.1, 1.5, 2.0, 2.5, 3.0, 8.0}) {
+        const auto filter = girgs::ProbabilityFilter<1024>(alpha);
+        auto undecided = 0;
+        const auto samples = 100000;
+        for (auto s = 0; s < samples; ++s) {
+            const auto rnd = dist(gen);
+            const auto ratio = 1.2 * dist(gen);
+            const auto connected = rnd < std::pow(ratio, alpha);
+
+            if (ratio <= filter.ratioForProb_lowerBound(rnd))
+                EXPECT_FALSE(connected);
+            else if (ratio >= filter.ratioForProb_upperBound(rnd))
+                EXPECT_TRUE(connected);
+            else
+                ++undecided;
+
+            // pairs right at the bounds
+            const auto lower = filter.ratioForProb_lowerBound(rnd);
+            const auto upper = filter.ratioForProb_upperBound(rnd);
+            EXPECT_FALSE(rnd < std::pow(lower, alpha));
+            EXPECT_TRUE(rnd < std::pow(upper, alpha));
+        }
+        // the band between the bounds is narrow
+        EXPECT_LT(undecided, samples / 100);
+    }
+}
@@ -1,4 +1,5 @@
 
+#include <cmath>
 #include <random>
 
 #include <gmock/gmock.h>
@@ -12,9 +13,9 @@ using namespace girgs;
 
 class SpatialTreeCoordinateHelper_test: public testing::Test {};
 
-template<unsigned int D>
+template<unsigned int D, typename CellId = uint32_t>
 void testTreeStructure(const unsigned max_level) {
-    using Tree = SpatialTreeCoordinateHelper<D>;
+    using Tree = SpatialTreeCoordinateHelper<D, CellId>;
 
     // check the number of children on all layers and helper functions
     auto cells = Tree::firstCellOfLevel(max_level+1);
@@ -40,9 +41,9 @@ void testTreeStructure(const unsigned max_level) {
         EXPECT_EQ(numChildren[i], 0);
 }
 
-template<unsigned int D>
+template<unsigned int D, typename CellId = uint32_t>
 void testCoordMapping(const unsigned max_level) {
-    using Tree = SpatialTreeCoordinateHelper<D>;
+    using Tree = SpatialTreeCoordinateHelper<D, CellId>;
 
     // generate some points and check their cells on all levels
     mt19937 gen(1337);
@@ -55,7 +56,7 @@ void testCoordMapping(const unsigned max_level) {
             point[d] = dist(gen);
 
         // compute containing cell in all levels and check if point is in their bounds
-        auto containingCells = vector<unsigned int>(max_level);
+        auto containingCells = vector<CellId>(max_level);
         containingCells[0] = 0;
         for(auto l=1u; l < max_level; ++l){
             containingCells[l] = Tree::cellForPoint(point, l) + Tree::firstCellOfLevel(l);
@@ -95,6 +96,26 @@ TEST_F(SpatialTreeCoordinateHelper_test, testCoordMapping)
 }
 
 
+TEST_F(SpatialTreeCoordinateHelper_test, testWideCells)
+{
+    testTreeStructure<1, uint64_t>(12);
+    testTreeStructure<6, uint64_t>( 2);
+
+    // levels whose cells do not fit into 32 bits
+    testCoordMapping<1, uint64_t>(40);
+    testCoordMapping<3, uint64_t>(20);
+    testCoordMapping<7, uint64_t>( 8);
+    testCoordMapping<10, uint64_t>(6);
+
+    using Tree = SpatialTreeCoordinateHelper<1, uint64_t>;
+    const auto first = Tree::firstCellOfLevel(40);
+    const auto last = first + Tree::numCellsInLevel(40) - 1;
+    EXPECT_TRUE(Tree::touching(first, last, 40));
+    EXPECT_FALSE(Tree::touching(first, first + 2, 40));
+    EXPECT_EQ(Tree::dist(first, first + 3, 40), std::ldexp(2.0, -40));
+}
+
+
 TEST_F(SpatialTreeCoordinateHelper_test, testTouching)
 {
     // TODO write better test for touching
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <girgs/Generator.h>
+
+
+static std::string readFile(const std::string& file) {
+    std::ifstream f{file};
+    return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+
+class TextWriter_test: public testing::Test
+{
+protected:
+    const int seed = 1337;
+};
+
+
+TEST_F(TextWriter_test, testEdgeListLayout)
+{
+    const auto n = 50000;
+    const auto file = std::string("TextWriter_test.txt");
+    const auto max_threads = omp_get_max_threads();
+
+    auto weights = girgs::generateWeights(n, 2.5, seed);
+    auto positions = girgs::generatePositions(n, 2, seed+1);
+    girgs::scaleWeights(weights, 10, 2, 2.0);
+    auto edges = girgs::generateEdges(weights, positions, 2.0, seed+2);
+
+    // layout as written with iostreams
+    std::ostringstream expected;
+    expected << n << ' ' << edges.size() << "\n\n";
+    for (auto& each : edges)
+        expected << each.first << ' ' << each.second << '\n';
+
+    // the chunks are formatted by several threads and written in order, even on a single core
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        girgs::saveEdgeList(n, edges, file);
+        EXPECT_EQ(readFile(file), expected.str()) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}
+
+
+TEST_F(TextWriter_test, testDotLayout)
+{
+    const auto n = 40000; // several chunks of nodes
+    const auto file = std::string("TextWriter_test.dot");
+    const auto max_threads = omp_get_max_threads();
+
+    for (auto d = 1u; d <= 3; ++d) {
+        auto weights = girgs::generateWeights(n, 2.5, seed);
+        auto positions = girgs::generatePositions(n, d, seed+d);
+        girgs::scaleWeights(weights, 10, d, 2.0);
+        auto edges = girgs::generateEdges(weights, positions, 2.0, seed);
+
+        // layout as written with iostreams
+        std::ostringstream expected;
+        expected << "graph girg {\n\toverlap=scale;\n\n";
+        expected << std::fixed;
+        for (std::size_t i = 0; i < weights.size(); ++i) {
+            expected << '\t' << i << " [label=\""
+                     << std::setprecision(2) << weights[i] << std::setprecision(6)
+                     << "\", pos=\"";
+            for (auto k = 0u; k < d; ++k)
+                expected << (k == 0 ? "" : ",") << positions[i][k];
+            expected << "\"];\n";
+        }
+        expected << '\n';
+        for (auto& edge : edges)
+            expected << '\t' << edge.first << "\t-- " << edge.second << ";\n";
+        expected << "}\n";
+
+        for (auto threads : {1, 4}) {
+            omp_set_num_threads(threads);
+            girgs::saveDot(weights, positions, edges, file);
+            EXPECT_EQ(readFile(file), expected.str()) << "d=" << d << " threads=" << threads;
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}
@@ -0,0 +1,81 @@
+#include <array>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <girgs/Node.h>
+#include <girgs/NodeColumns.h>
+#include <girgs/TypeIKernel.h>
+
+
+template<unsigned D, typename Kernel>
+void compareWithGeneric(unsigned n, unsigned seed) {
+    using Generic = girgs::TypeIKernelDetails::Generic::Implementation<D>;
+
+    auto gen = std::mt19937(seed);
+    auto dist = std::uniform_real_distribution<>();
+
+    std::vector<girgs::Node<D, girgs::NodeStorage>> nodes;
+    for (auto k = 0u; k < n; ++k) {
+        std::array<double, D> coord;
+        for (auto d = 0u; d < D; ++d)
+            coord[d] = dist(gen);
+        nodes.emplace_back(coord, 1.0 + 10.0 * dist(gen), static_cast<int>(k));
+    }
+    const auto columns = girgs::NodeColumns<D>(nodes);
+    const auto W = 5.0 * n;
+
+    // odd ranges exercise the scalar tails of the vectorized kernels
+    for (auto a = 0u; a < n; a += 3) {
+        const auto coordA = columns.coord(a);
+        const double weightA = columns.weights[a];
+        const auto begin = a / 2;
+        const auto end = n - a / 5;
+
+        std::vector<std::size_t> expected, actual;
+        Generic::threshold(coordA, weightA, W, columns, begin, end, [&](std::size_t k) { expected.push_back(k); });
+        Kernel::threshold(coordA, weightA, W, columns, begin, end, [&](std::size_t k) { actual.push_back(k); });
+        EXPECT_EQ(expected, actual);
+
+        std::vector<double> expectedRatios(end - begin), actualRatios(end - begin);
+        Generic::ratios(coordA, weightA, W, columns, begin, end, expectedRatios.data());
+        Kernel::ratios(coordA, weightA, W, columns, begin, end, actualRatios.data());
+        EXPECT_EQ(expectedRatios, actualRatios);
+    }
+}
+
+
+// compares the kernels selected at runtime
+template<unsigned D>
+void compareWithGeneric(unsigned n, unsigned seed) {
+    girgs::dispatchTypeIKernel<D>([&] (auto kernel) {
+        compareWithGeneric<D, decltype(kernel)>(n, seed);
+    });
+}
+
+
+TEST(TypeIKernel_test, testSameAsGeneric)
+{
+    const auto detected = girgs::typeIKernel();
+
+    // each kernel the cpu supports, selected at runtime
+    for (auto impl : {girgs::TypeIKernelImplementation::Generic, girgs::TypeIKernelImplementation::AVX2, girgs::TypeIKernelImplementation::AVX512}) {
+        if (!girgs::typeIKernelAvailable(impl)) {
+            EXPECT_THROW(girgs::setTypeIKernel(impl), std::invalid_argument);
+            continue;
+        }
+
+        girgs::setTypeIKernel(impl);
+        EXPECT_EQ(girgs::typeIKernel(), impl);
+        compareWithGeneric<1>(101, 1);
+        compareWithGeneric<2>(101, 2);
+        compareWithGeneric<3>(101, 3);
+        compareWithGeneric<4>(101, 4);
+        compareWithGeneric<5>(101, 5);
+    }
+
+    girgs::setTypeIKernel(detected);
+    EXPECT_EQ(girgs::detectTypeIKernel(), detected);
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <omp.h>
+
+#include <girgs/Generator.h>
+#include <girgs/WeightScaling.h>
+
+
+class WeightScaling_test: public testing::Test
+{
+protected:
+    const int seed = 1337;
+};
+
+
+TEST_F(WeightScaling_test, testLazySorter)
+{
+    // large enough for the parallel partition and sort
+    const auto n = 300000;
+    const auto weights = girgs::generateWeights(n, 2.1, seed);
+
+    auto sorter = girgs::LazySorter(weights);
+    for (auto thresh : {1000.0, 100.0, 200.0, 10.0, 2.0, 1.5}) {
+        const auto num_larger = sorter.sortDownto(thresh);
+        const auto& sorted = sorter.weights();
+
+        EXPECT_EQ(num_larger, static_cast<std::size_t>(std::count_if(weights.begin(), weights.end(), [=] (double w) { return w >= thresh; })));
+        EXPECT_GE(sorter.sortedSize(), num_larger);
+        EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.begin() + sorter.sortedSize(), std::greater<double>()));
+        EXPECT_TRUE(std::all_of(sorted.begin() + sorter.sortedSize(), sorted.end(), [=] (double w) { return w < thresh; }));
+    }
+
+    auto all = sorter.weights();
+    auto expected = weights;
+    std::sort(all.begin(), all.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(all, expected);
+}
+
+
+TEST_F(WeightScaling_test, testReusedStatistics)
+{
+    const auto n = 100000;
+    const auto weights = girgs::generateWeights(n, 2.2, seed);
+
+    auto statistics = girgs::WeightStatistics(weights);
+    for (auto d : {1, 3}) {
+        for (auto deg : {5.0, 50.0}) {
+            EXPECT_EQ(girgs::estimateWeightScaling(statistics, deg, d, 1.5), girgs::estimateWeightScaling(weights, deg, d, 1.5));
+            EXPECT_EQ(girgs::estimateWeightScaling(statistics, deg, d, 3.0), girgs::estimateWeightScaling(weights, deg, d, 3.0));
+            EXPECT_EQ(girgs::estimateWeightScalingThreshold(statistics, deg, d), girgs::estimateWeightScalingThreshold(weights, deg, d));
+        }
+    }
+}
+
+
+TEST_F(WeightScaling_test, testIndependentOfThreadCount)
+{
+    const auto n = 300000;
+    const auto weights = girgs::generateWeights(n, 2.1, seed);
+    const auto max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    const auto expected = girgs::estimateWeightScaling(weights, 20.0, 2, 2.0);
+    const auto expected_threshold = girgs::estimateWeightScalingThreshold(weights, 20.0, 2);
+
+    for (auto threads : {2, 7}) {
+        omp_set_num_threads(threads);
+        EXPECT_EQ(girgs::estimateWeightScaling(weights, 20.0, 2, 2.0), expected) << "threads=" << threads;
+        EXPECT_EQ(girgs::estimateWeightScalingThreshold(weights, 20.0, 2), expected_threshold) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+
+TEST_F(WeightScaling_test, testSolverMatchesScaleWeights)
+{
+    const auto n = 50000;
+    const auto weights = girgs::generateWeights(n, 2.5, seed);
+
+    auto targets = std::vector<girgs::WeightScalingTarget>();
+    for (auto d : {1, 2, 3})
+        for (auto deg : {5.0, 20.0, 50.0})
+            for (auto alpha : {0.7, 1.5, 3.0, 9.0, std::numeric_limits<double>::infinity()})
+                targets.push_back({deg, d, alpha});
+
+    const auto max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    auto expected = std::vector<double>();
+    for (auto& target : targets) {
+        auto scaled = weights;
+        expected.push_back(girgs::scaleWeights(scaled, target.desiredAvgDegree, target.dimension, target.alpha));
+    }
+
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        auto solver = girgs::WeightScalingSolver(weights);
+        EXPECT_EQ(solver.scalings(targets), expected) << "threads=" << threads;
+
+        // later queries reuse the sorted rich club and the power sums
+        for (std::size_t i = 0; i < targets.size(); i += 7)
+            EXPECT_EQ(solver.scaling(targets[i].desiredAvgDegree, targets[i].dimension, targets[i].alpha), expected[i]);
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+
+TEST_F(WeightScaling_test, testSolverRejectsAlpha)
+{
+    auto solver = girgs::WeightScalingSolver(girgs::generateWeights(100, 2.5, seed));
+    EXPECT_ANY_THROW(solver.scalings({{10.0, 2, 2.0}, {10.0, 2, 1.0}}));
+    EXPECT_ANY_THROW(solver.scaling(10.0, 2, 0.0));
+}
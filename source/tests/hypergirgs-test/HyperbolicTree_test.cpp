@@ -4,6 +4,8 @@
 
 #include <gmock/gmock.h>
 
+#include <omp.h>
+
 #include <hypergirgs/HyperbolicTree.h>
 #include <hypergirgs/Generator.h>
 
@@ -123,3 +125,124 @@ TEST_F(HyperbolicTree_test, testReproducible)
         ASSERT_EQ(edges1, edges2);
     }
 }
+
+
+TEST_F(HyperbolicTree_test, testEdgeBlockCallback)
+{
+    const auto n = 1000;
+    const auto alpha = 0.75;
+    const auto T = 0.5;
+    const auto deg = 10;
+    const auto blockSize = std::size_t{5};
+
+    auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+    auto expected = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+    sort(expected.begin(), expected.end());
+
+    std::vector<std::vector<hypergirgs::Edge>> perThread(omp_get_max_threads());
+    hypergirgs::generateEdges(radii, angles, T, R, edgesSeed,
+        [&] (const hypergirgs::Edge* edges, std::size_t count, int tid) {
+            EXPECT_LE(count, blockSize);
+            perThread[tid].insert(perThread[tid].end(), edges, edges + count);
+        }, blockSize);
+
+    std::vector<hypergirgs::Edge> edges;
+    for (auto& local : perThread)
+        edges.insert(edges.end(), local.begin(), local.end());
+    sort(edges.begin(), edges.end());
+    ASSERT_EQ(edges, expected);
+}
+
+
+TEST_F(HyperbolicTree_test, testReproducibleAcrossThreadCounts)
+{
+    const auto n = 2000;
+    const auto alpha = 0.75;
+    const auto T = 0.5;
+    const auto deg = 10;
+    const auto max_threads = omp_get_max_threads();
+
+    auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+
+    omp_set_num_threads(1);
+    auto expected = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+    sort(expected.begin(), expected.end());
+
+    for (auto threads : {2, 7}) {
+        omp_set_num_threads(threads);
+        auto edges = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+        sort(edges.begin(), edges.end());
+        EXPECT_EQ(edges, expected) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+}
+
+
+TEST_F(HyperbolicTree_test, testShards)
+{
+    const auto n = 2000;
+    const auto alpha = 0.75;
+    const auto Ts = {0.0, 0.5};
+    const auto deg = 10;
+    const auto shardCounts = { 2u, 5u, 1000u }; // more shards than cells on the deepest level leaves some shards empty
+
+    for (auto T : Ts) {
+        auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+        auto angles = hypergirgs::sampleAngles(n, angleSeed);
+        auto expected = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+        sort(expected.begin(), expected.end());
+
+        for (auto numShards : shardCounts) {
+            // the union of all shards is the graph and no edge is sampled twice
+            std::vector<hypergirgs::Edge> edges;
+            for (auto shard = 0u; shard < numShards; ++shard) {
+                hypergirgs::generateEdges(radii, angles, T, R, edgesSeed,
+                    [&] (const hypergirgs::Edge* block, std::size_t count, int) {
+                        #pragma omp critical
+                        edges.insert(edges.end(), block, block + count);
+                    }, std::size_t{1} << 16, shard, numShards);
+            }
+            sort(edges.begin(), edges.end());
+            EXPECT_EQ(edges, expected) << "T=" << T << " shards=" << numShards;
+        }
+    }
+}
+
+
+TEST_F(HyperbolicTree_test, testCSR)
+{
+    const auto n = 1000;
+    const auto alpha = 0.75;
+    const auto Ts = {0.0, 0.5};
+    const auto deg = 10;
+
+    for (auto T : Ts) {
+        auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+        auto angles = hypergirgs::sampleAngles(n, angleSeed);
+
+        auto edges = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+        auto csr = hypergirgs::generateCSR(radii, angles, T, R, edgesSeed);
+
+        ASSERT_EQ(csr.numNodes(), static_cast<std::size_t>(n));
+        ASSERT_EQ(csr.numEdges(), edges.size());
+
+        std::vector<std::vector<int>> expected(n);
+        for (auto& e : edges) {
+            expected[e.first].push_back(e.second);
+            expected[e.second].push_back(e.first);
+        }
+
+        for (int v = 0; v < n; ++v) {
+            sort(expected[v].begin(), expected[v].end());
+            auto actual = std::vector<int>(csr.neighboursBegin(v), csr.neighboursEnd(v));
+            EXPECT_EQ(actual, expected[v]);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <hypergirgs/Generator.h>
+#include <hypergirgs/MappedPoints.h>
+
+
+// the edges with u < v in ascending order
+static std::vector<hypergirgs::Edge> normalized(std::vector<hypergirgs::Edge> edges) {
+    for (auto& edge : edges)
+        if (edge.first > edge.second)
+            std::swap(edge.first, edge.second);
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+
+TEST(MappedPoints_test, testSameEdgesAsVectors)
+{
+    const auto file = std::string("MappedPoints_test.pts");
+    const auto n = 5000;
+    const auto alpha = 0.75;
+
+    for (auto T : {0.0, 0.5}) {
+        const auto R = hypergirgs::calculateRadius(n, alpha, T, 10);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, 12);
+        auto angles = hypergirgs::sampleAngles(n, 130);
+        hypergirgs::savePoints(radii, angles, R, file);
+
+        const auto points = hypergirgs::MappedPoints(file);
+        ASSERT_EQ(points.size(), static_cast<std::size_t>(n));
+        EXPECT_EQ(points.radius(), R);
+        EXPECT_TRUE(std::equal(radii.begin(), radii.end(), points.radii().begin()));
+        EXPECT_TRUE(std::equal(angles.begin(), angles.end(), points.angles().begin()));
+
+        const auto expected = normalized(hypergirgs::generateEdges(radii, angles, T, R, 1400));
+        EXPECT_EQ(normalized(hypergirgs::generateEdges(points.radii(), points.angles(), T, points.radius(), 1400)), expected);
+        EXPECT_EQ(hypergirgs::generateCSR(points.radii(), points.angles(), T, points.radius(), 1400).numEdges(), expected.size());
+    }
+
+    std::remove(file.c_str());
+}
+
+
+TEST(MappedPoints_test, testInvalidFiles)
+{
+    const auto file = std::string("MappedPoints_test.pts");
+    EXPECT_THROW(hypergirgs::MappedPoints("MappedPoints_test.missing"), std::runtime_error);
+
+    {   // a file with different sizes of radii and angles
+        auto header = hypergirgs::BinaryPointsHeader();
+        header.n = 2;
+        const double values[3] = {1.0, 2.0, 3.0};
+        std::ofstream f{file, std::ios::binary};
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+    EXPECT_THROW(hypergirgs::MappedPoints{file}, std::runtime_error);
+
+    {   // a crafted n whose 2 * n overflows to the number of values
+        auto header = hypergirgs::BinaryPointsHeader();
+        header.n = (uint64_t{1} << 63) + 2;
+        const double values[4] = {1.0, 2.0, 3.0, 4.0};
+        std::ofstream f{file, std::ios::binary};
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+    EXPECT_THROW(hypergirgs::MappedPoints{file}, std::runtime_error);
+
+    std::remove(file.c_str());
+}
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <omp.h>
+
+#include <hypergirgs/Generator.h>
+
+
+static std::string readFile(const std::string& file) {
+    std::ifstream f{file};
+    return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+
+class TextWriter_test: public testing::Test
+{
+protected:
+    const int radiiSeed = 12;
+    const int angleSeed = 130;
+    const int edgesSeed = 1400;
+};
+
+
+TEST_F(TextWriter_test, testEdgeListLayout)
+{
+    const auto n = 50000;
+    const auto alpha = 0.75;
+    const auto T = 0.5;
+    const auto file = std::string("TextWriter_test.txt");
+    const auto max_threads = omp_get_max_threads();
+
+    const auto R = hypergirgs::calculateRadius(n, alpha, T, 10);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+    const auto edges = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+
+    // layout as written with iostreams
+    std::ostringstream expected;
+    expected << n << ' ' << edges.size() << "\n\n";
+    for (auto& each : edges)
+        expected << each.first << ' ' << each.second << '\n';
+
+    // the chunks are formatted by several threads and written in order, even on a single core
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        hypergirgs::saveEdgeList(n, edges, file);
+        EXPECT_EQ(readFile(file), expected.str()) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}
+
+
+TEST_F(TextWriter_test, testCoordinatesLayout)
+{
+    const auto n = 40000; // several chunks of nodes
+    const auto alpha = 0.75;
+    const auto file = std::string("TextWriter_test.hyp");
+    const auto max_threads = omp_get_max_threads();
+
+    const auto R = hypergirgs::calculateRadius(n, alpha, 0, 10);
+    const auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    const auto angles = hypergirgs::sampleAngles(n, angleSeed);
+
+    // layout as written with iostreams
+    std::ostringstream expected;
+    expected << std::fixed << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (auto i = 0; i < n; ++i)
+        expected << radii[i] << ' ' << angles[i] << '\n';
+
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        hypergirgs::saveCoordinates(radii, angles, file);
+        EXPECT_EQ(readFile(file), expected.str()) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <hypergirgs/Generator.h>
+#include <hypergirgs/Point.h>
+#include <hypergirgs/PointColumns.h>
+#include <hypergirgs/TypeIKernel.h>
+
+
+static std::vector<hypergirgs::Point> randomPoints(unsigned n, double R, unsigned seed) {
+    auto gen = std::mt19937(seed);
+    auto radius = std::uniform_real_distribution<>(0.1, R);
+    auto angle = std::uniform_real_distribution<>(0.0, 6.28);
+
+    std::vector<hypergirgs::Point> points;
+    for (auto k = 0u; k < n; ++k)
+        points.emplace_back(static_cast<hypergirgs::NodeIndex>(k), radius(gen), angle(gen));
+    return points;
+}
+
+
+template<typename Kernel>
+void compareWithPoint(unsigned n, unsigned seed) {
+    const auto R = 12.0;
+    const auto coshR = std::cosh(R);
+    const auto points = randomPoints(n, R, seed);
+
+    hypergirgs::PointColumns columns;
+    columns.assign(points.data(), points.data() + points.size());
+    ASSERT_EQ(columns.size(), n);
+
+    // odd ranges exercise the scalar tails of the vectorized kernels
+    for (auto a = 0u; a < n; a += 3) {
+        const auto& pointA = points[a];
+        const auto begin = a / 2;
+        const auto end = n - a / 5;
+
+        std::vector<std::size_t> expected, actual;
+        for (auto k = begin; k < end; ++k)
+            if (pointA.isDistanceBelowR(points[k], coshR))
+                expected.push_back(k);
+        Kernel::threshold(pointA, coshR, columns, begin, end, [&](std::size_t k) { actual.push_back(k); });
+        EXPECT_EQ(expected, actual);
+
+        std::vector<double> expectedCosh, actualCosh(end - begin);
+        for (auto k = begin; k < end; ++k)
+            expectedCosh.push_back(pointA.hyperbolicDistanceCosh(points[k]));
+        Kernel::distancesCosh(pointA, columns, begin, end, actualCosh.data());
+        EXPECT_EQ(expectedCosh, actualCosh);
+    }
+}
+
+
+// compares the kernels selected at runtime
+void compareWithPoint(unsigned n, unsigned seed) {
+    hypergirgs::dispatchTypeIKernel([&] (auto kernel) {
+        compareWithPoint<decltype(kernel)>(n, seed);
+    });
+}
+
+
+TEST(TypeIKernel_test, testSameAsPoint)
+{
+    const auto detected = hypergirgs::typeIKernel();
+
+    // each kernel the cpu supports, selected at runtime
+    for (auto impl : {hypergirgs::TypeIKernelImplementation::Generic, hypergirgs::TypeIKernelImplementation::AVX2, hypergirgs::TypeIKernelImplementation::AVX512}) {
+        if (!hypergirgs::typeIKernelAvailable(impl)) {
+            EXPECT_THROW(hypergirgs::setTypeIKernel(impl), std::invalid_argument);
+            continue;
+        }
+
+        hypergirgs::setTypeIKernel(impl);
+        EXPECT_EQ(hypergirgs::typeIKernel(), impl);
+        compareWithPoint(101, 1);
+        compareWithPoint(257, 2);
+    }
+
+    hypergirgs::setTypeIKernel(detected);
+    EXPECT_EQ(hypergirgs::detectTypeIKernel(), detected);
+}
+
+
+TEST(TypeIKernel_test, testSameGraphs)
+{
+    const auto n = 10000;
+    const auto alpha = 0.75;
+    const auto detected = hypergirgs::typeIKernel();
+
+    for (auto T : {0.0, 0.5}) {
+        const auto R = hypergirgs::calculateRadius(n, alpha, T, 10);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, 12);
+        auto angles = hypergirgs::sampleAngles(n, 130);
+
+        // the order of the edges depends on the scheduling of the threads
+        auto sortedEdges = [&] {
+            auto edges = hypergirgs::generateEdges(radii, angles, T, R, 1400);
+            std::sort(edges.begin(), edges.end());
+            return edges;
+        };
+
+        hypergirgs::setTypeIKernel(hypergirgs::TypeIKernelImplementation::Generic);
+        const auto expected = sortedEdges();
+
+        for (auto impl : {hypergirgs::TypeIKernelImplementation::AVX2, hypergirgs::TypeIKernelImplementation::AVX512}) {
+            if (!hypergirgs::typeIKernelAvailable(impl))
+                continue;
+
+            hypergirgs::setTypeIKernel(impl);
+            EXPECT_EQ(sortedEdges(), expected)
+                << "T=" << T << " kernel=" << hypergirgs::typeIKernelName(impl);
+        }
+    }
+
+    hypergirgs::setTypeIKernel(detected);
+}
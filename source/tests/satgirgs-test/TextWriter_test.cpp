@@ -0,0 +1,114 @@
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <omp.h>
+
+#include <satgirgs/Generator.h>
+
+
+static std::string readFile(const std::string& file) {
+    std::ifstream f{file};
+    return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+
+class TextWriter_test: public testing::Test
+{
+protected:
+    void SetUp() override {
+        const auto weights = satgirgs::generateWeights(n, 2.5, 12);
+        nc_nodes = satgirgs::convertToNodes(satgirgs::generatePositions(n, 2, 130), weights);
+
+        // clause nodes all have weight 1 in the model
+        c_nodes = satgirgs::convertToNodes(satgirgs::generatePositions(m, 2, 1400), std::vector<double>(m, 1), n);
+
+        // the writers only see the edges; sampling them checks all n*m node pairs, which is too slow here
+        auto gen = std::mt19937(1400);
+        auto node = std::uniform_int_distribution<int>(0, n - 1);
+        std::vector<std::pair<int,int>> edges;
+        for (auto i = 0; i < m; ++i) {
+            auto u = node(gen), v = node(gen);
+            edges.emplace_back(std::min(u, v), std::max(u, v));
+        }
+        graph = satgirgs::deduplicateEdges(edges);
+    }
+
+    const int n = 20000;
+    const int m = 40000; // several chunks of nodes and edges
+
+    std::vector<satgirgs::Node2D> nc_nodes;
+    std::vector<satgirgs::Node2D> c_nodes;
+    std::vector<std::tuple<int,int,int>> graph;
+};
+
+
+TEST_F(TextWriter_test, testEdgeListLayout)
+{
+    const auto file = std::string("TextWriter_test.txt");
+    const auto max_threads = omp_get_max_threads();
+
+    // layout as written with iostreams
+    std::ostringstream expected;
+    expected << n << ' ' << graph.size() << "\n\n";
+    for (const auto& edge : graph)
+        expected << std::get<0>(edge) << ' ' << std::get<1>(edge) << ' ' << std::get<2>(edge) << '\n';
+
+    // the chunks are formatted by several threads and written in order, even on a single core
+    for (auto threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        satgirgs::saveEdgeList(n, graph, file);
+        EXPECT_EQ(readFile(file), expected.str()) << "threads=" << threads;
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}
+
+
+TEST_F(TextWriter_test, testDotLayout)
+{
+    const auto file = std::string("TextWriter_test.dot");
+    const auto max_threads = omp_get_max_threads();
+
+    for (auto debugMode : {false, true}) {
+        // layout as written with iostreams
+        std::ostringstream expected;
+        expected << "graph girg {\n\toverlap=scale;\n\n";
+        expected << std::fixed;
+        const auto writeNodes = [&] (const std::vector<satgirgs::Node2D>& nodes, const char* attributes) {
+            for (const auto& node : nodes) {
+                expected << '\t' << node.index << attributes << "label=\""
+                         << std::setprecision(2) << node.weight << std::setprecision(6)
+                         << "\", pos=\"";
+                for (auto d = 0u; d < node.coord.size(); ++d)
+                    expected << (d == 0 ? "" : ",") << node.coord[d];
+                expected << "!\"];\n";
+            }
+        };
+        writeNodes(nc_nodes, " [");
+        if (debugMode)
+            writeNodes(c_nodes, " [color=\"red\",style=\"filled\", ");
+        expected << '\n';
+        for (const auto& edge : graph)
+            expected << '\t' << std::get<0>(edge) << "\t-- " << std::get<1>(edge) << "[label=\"" << std::get<2>(edge) << "\"];\n";
+        expected << "}\n";
+
+        for (auto threads : {1, 4}) {
+            omp_set_num_threads(threads);
+            satgirgs::saveDot(c_nodes, nc_nodes, graph, file, debugMode);
+            EXPECT_EQ(readFile(file), expected.str()) << "debugMode=" << debugMode << " threads=" << threads;
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+    std::remove(file.c_str());
+}